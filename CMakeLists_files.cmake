@@ -75,6 +75,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/blackoil/blackoillocalresidual.hh
              opm/models/blackoil/blackoillocalresidualtpfa.hh
              opm/models/blackoil/blackoilnewtonmethod.hh
+             opm/models/blackoil/blackoilsequentialsolver.hh
              opm/models/blackoil/blackoilonephaseindices.hh
              opm/models/blackoil/blackoilsolventmodules.hh
              opm/models/blackoil/blackoilsolventparams.hh
@@ -132,6 +133,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/discretization/common/fvbaselinearizer.hh
              opm/models/discretization/common/tpfalinearizer.hh
              opm/models/discretization/common/restrictprolong.hh
+             opm/models/discretization/common/renumberedmapper.hh
              opm/models/discretization/common/fvbasediscretization.hh
              opm/models/discretization/common/fvbasegradientcalculator.hh
              opm/models/discretization/common/fvbaseproblem.hh
@@ -151,6 +153,8 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/flash/flashprimaryvariables.hh
              opm/models/flash/flashextensivequantities.hh
              opm/models/flash/flashproperties.hh
+             opm/models/flash/flashnewtonmethod.hh
+             opm/models/flash/batchedncpflash.hh
              opm/models/immiscible/immisciblelocalresidual.hh
              opm/models/immiscible/immiscibleproperties.hh
              opm/models/immiscible/immisciblemodel.hh
@@ -165,6 +169,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/io/vtkscalarfunction.hh
              opm/models/io/vtkenergymodule.hh
              opm/models/io/restart.hh
+             opm/models/io/runrecord.hh
              opm/models/io/cubegridvanguard.hh
              opm/models/io/baseoutputwriter.hh
              opm/models/io/vtkmultiwriter.hh
@@ -196,6 +201,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/ncp/ncpproperties.hh
              opm/models/ncp/ncplocalresidual.hh
              opm/models/ncp/ncpboundaryratevector.hh
+             opm/models/nonlinear/newtonconvergencetracer.hh
              opm/models/nonlinear/nullconvergencewriter.hh
              opm/models/nonlinear/newtonmethod.hh
              opm/models/nonlinear/newtonmethodproperties.hh
@@ -203,6 +209,8 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/parallel/tasklets.hh
              opm/models/parallel/threadmanager.hh
              opm/models/parallel/gridcommhandles.hh
+             opm/models/parallel/elementcostbalancer.hh
+             opm/models/parallel/firsttouchallocator.hh
              opm/models/parallel/mpibuffer.hh
              opm/models/parallel/threadedentityiterator.hh
              opm/models/pvs/pvsboundaryratevector.hh
@@ -231,10 +239,15 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/utils/propertysystemmacros.hh
              opm/models/utils/pffgridvector.hh
              opm/models/utils/prefetch.hh
+             opm/models/utils/profiler.hh
+             opm/models/utils/microbenchmark.hh
+             opm/models/utils/memoryusage.hh
+             opm/models/utils/isattable.hh
              opm/models/utils/parametersystem.hh
              opm/models/utils/simulator.hh
              opm/models/utils/quadraturegeometries.hh
              opm/models/utils/alignedallocator.hh
+             opm/models/utils/timestepcontroller.hh
              opm/models/utils/timer.hh
              opm/models/utils/signum.hh
              opm/models/utils/genericguard.hh
@@ -247,6 +260,9 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/simulators/linalg/linearsolverreport.hh
              opm/simulators/linalg/istlsparsematrixadapter.hh
              opm/simulators/linalg/istlpreconditionerwrappers.hh
+             opm/simulators/linalg/scalarilu0preconditioner.hh
+             opm/simulators/linalg/cprpreconditioner.hh
+             opm/simulators/linalg/pressuresystem.hh
              opm/simulators/linalg/residreductioncriterion.hh
              opm/simulators/linalg/overlappingbcrsmatrix.hh
              opm/simulators/linalg/blacklist.hh
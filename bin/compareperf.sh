@@ -0,0 +1,91 @@
+#! /bin/bash
+#
+# Compares the run record of a simulation with the one of a baseline run and reports
+# the quantities which got worse by more than a given fraction.
+#
+# Usage:
+#
+# compareperf.sh BASELINE_RECORD RUN_RECORD [THRESHOLD]
+#
+# The run records are written by the simulators if the --run-record-file parameter is
+# specified. THRESHOLD is the tolerated relative increase of a quantity and defaults to
+# 0.1, i.e., 10%. Since the timings of short runs are dominated by noise, differences
+# of timings below 0.05 seconds are never considered to be regressions.
+#
+# The exit code is 0 if no regression was detected, 1 if there was one and 2 if the run
+# records could not be compared.
+
+usage() {
+    echo "Usage:"
+    echo
+    echo "compareperf.sh BASELINE_RECORD RUN_RECORD [THRESHOLD]"
+};
+
+# print the numeric quantities of a run record as "key value" lines
+readRecord()
+{
+    sed -n 's/^ *"\([A-Za-z0-9_]*\)": *\([-+0-9.eE]*\),\?$/\1 \2/p' "$1"
+}
+
+if test "$#" -lt 2 || test "$#" -gt 3; then
+    usage
+    exit 2
+fi
+
+BASELINE="$1"
+RECORD="$2"
+THRESHOLD="${3:-0.1}"
+
+for FILE in "$BASELINE" "$RECORD"; do
+    if ! test -r "$FILE"; then
+        echo "Run record '$FILE' does not exist or is not readable"
+        exit 2
+    fi
+done
+
+readRecord "$BASELINE" > "$RECORD.baseline-values"
+readRecord "$RECORD" > "$RECORD.values"
+
+awk -v threshold="$THRESHOLD" '
+    # the quantities which describe the configuration of the run and must not differ
+    BEGIN {
+        config["processes"] = 1;
+        config["threadsPerProcess"] = 1;
+        status = 0;
+    }
+
+    FNR == NR { baseline[$1] = $2; next }
+
+    !($1 in baseline) { next }
+
+    {
+        key = $1; old = baseline[key]; new = $2;
+
+        if (key in config) {
+            if (old != new) {
+                printf("The runs are not comparable: %s is %s for the baseline but %s\n", key, old, new);
+                status = 2;
+                exit;
+            }
+            next;
+        }
+
+        change = (old != 0) ? (new - old)/old : ((new != 0) ? 1 : 0);
+        minDiff = (key ~ /Time$/) ? 0.05 : 0;
+        regression = (change > threshold && new - old > minDiff);
+        printf("%-20s %14.6g %14.6g %+9.1f%%%s\n", key, old, new, change*100,
+               regression ? "  REGRESSION" : "");
+        if (regression)
+            status = 1;
+    }
+
+    END { exit status }
+' "$RECORD.baseline-values" "$RECORD.values"
+RET="$?"
+
+rm -f "$RECORD.baseline-values" "$RECORD.values"
+
+if test "$RET" = "1"; then
+    echo "Performance regression beyond a threshold of $THRESHOLD detected"
+fi
+exit "$RET"
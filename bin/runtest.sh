@@ -12,7 +12,8 @@ usage() {
     echo "Usage:"
     echo
     echo "runTest.sh TEST_TYPE -e binary -- [TEST_ARGS]"
-    echo "where TEST_TYPE can either be --plain, --simulation, --spe1 or --parallel-simulation=\$NUM_CORES (is '$TEST_TYPE')."
+    echo "where TEST_TYPE can either be --plain, --simulation, --spe1, --parallel-simulation=\$NUM_CORES"
+    echo "or --performance=\$BASELINE_DIR (is '$TEST_TYPE')."
 };
 
 # this function clips the help message printed by an ewoms simulation
@@ -253,6 +254,36 @@ EOF
 
         ;;
 
+    "--performance="*)
+        BASELINE_DIR="${TEST_TYPE/--performance=/}"
+        BASELINE="$BASELINE_DIR/$TEST_NAME.json"
+        RECORD="runrecord-$RND.json"
+
+        echo "executing \"$TEST_BINARY $TEST_ARGS --run-record-file=$RECORD\""
+        if ! "$TEST_BINARY" $TEST_ARGS --run-record-file="$RECORD" > "test-$RND.log"; then
+            echo "Executing the binary failed!"
+            rm -f "test-$RND.log" "$RECORD"
+            exit 1
+        fi
+        rm "test-$RND.log"
+
+        # the first run on a machine provides the baseline for the subsequent ones
+        if ! test -r "$BASELINE"; then
+            mkdir -p "$BASELINE_DIR"
+            mv "$RECORD" "$BASELINE"
+            echo "No baseline found, stored the run record as '$BASELINE'"
+            exit 0
+        fi
+
+        echo "######################"
+        echo "# Comparing with baseline '$BASELINE'"
+        echo "######################"
+        "$MY_DIR/compareperf.sh" "$BASELINE" "$RECORD" "${PERFORMANCE_THRESHOLD:-0.1}"
+        RET="$?"
+        rm "$RECORD"
+        exit "$RET"
+        ;;
+
     "--plain")
         echo "executing \"$TEST_BINARY $TEST_ARGS\""
         if ! "$TEST_BINARY" $TEST_ARGS; then
@@ -15,6 +15,7 @@ set (opm-models_CONFIG_VAR
   HAVE_ECL_INPUT
   HAVE_ECL_OUTPUT
   HAVE_OPM_GRID
+  EWOMS_ENABLE_PROFILING
   DUNE_AVOID_CAPABILITIES_IS_PARALLEL_DEPRECATION_WARNING
   )
 
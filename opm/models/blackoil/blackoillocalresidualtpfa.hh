@@ -37,9 +37,13 @@
 #include "blackoilbrinemodules.hh"
 #include "blackoildiffusionmodule.hh"
 #include "blackoilmicpmodules.hh"
+#include <opm/common/TimingMacros.hpp>
 #include <opm/material/fluidstates/BlackOilFluidState.hpp>
 #include <opm/input/eclipse/EclipseState/Grid/FaceDir.hpp>
 
+#include <stdexcept>
+#include <string>
+
 
 namespace Opm {
 /*!
@@ -441,6 +445,7 @@ public:
                                     const IntensiveQuantities& insideIntQuants,
                                     unsigned globalSpaceIdx)
     {
+        using BCType = decltype(bdyInfo.type);
         if (bdyInfo.type == BCType::RATE) {
             computeBoundaryFluxRate(bdyFlux, bdyInfo);
         } else if (bdyInfo.type == BCType::FREE) {
@@ -135,6 +135,11 @@ struct Indices<TypeTag, TTag::BlackOilModel>
                                /*PVOffset=*/0,
                                getPropValue<TypeTag, Properties::EnableMICP>()>; };
 
+//! The CPR preconditioner needs to know where the pressure is located
+template<class TypeTag>
+struct CprPressureIndex<TypeTag, TTag::BlackOilModel>
+{ static constexpr int value = GetPropType<TypeTag, Properties::Indices>::pressureSwitchIdx; };
+
 //! Set the fluid system to the black-oil fluid system by default
 template<class TypeTag>
 struct FluidSystem<TypeTag, TTag::BlackOilModel>
@@ -35,6 +35,15 @@
 #include <opm/models/utils/signum.hh>
 #include <opm/models/nonlinear/newtonmethod.hh>
 #include "blackoilmicpmodules.hh"
+#include "blackoilsequentialsolver.hh"
+
+#include <dune/common/exceptions.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 namespace Opm::Properties {
 
@@ -55,6 +64,16 @@ template<class TypeTag, class MyTypeTag>
 struct TemperatureMax { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct TemperatureMin { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct NewtonSolutionStrategy { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SequentialIterateToFullyImplicit { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SequentialMaxIterations { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SequentialMaxPressureIterations { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SequentialMaxTransportIterations { using type = UndefinedProperty; };
 template<class TypeTag>
 struct DpMaxRel<TypeTag, TTag::NewtonMethod>
 {
@@ -93,6 +112,16 @@ struct TemperatureMin<TypeTag, TTag::NewtonMethod>
     using type = GetPropType<TypeTag, Scalar>;
     static constexpr type value = 0.0; //Kelvin
 };
+template<class TypeTag>
+struct NewtonSolutionStrategy<TypeTag, TTag::NewtonMethod> { static constexpr auto value = "fully-implicit"; };
+template<class TypeTag>
+struct SequentialIterateToFullyImplicit<TypeTag, TTag::NewtonMethod> { static constexpr bool value = true; };
+template<class TypeTag>
+struct SequentialMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 10; };
+template<class TypeTag>
+struct SequentialMaxPressureIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 8; };
+template<class TypeTag>
+struct SequentialMaxTransportIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 8; };
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -101,6 +130,17 @@ namespace Opm {
  * \ingroup BlackOilModel
  *
  * \brief A newton solver which is specific to the black oil model.
+ *
+ * Besides the fully implicit Newton method, the "sequential" solution strategy can be
+ * selected by the NewtonSolutionStrategy parameter. Each of its iterations first
+ * solves the pressure equations for the pressures and then the transport equations
+ * for the remaining primary variables at fixed total volume fluxes, both by inner
+ * Newton iterations (see Opm::BlackOilSequentialSolver). If
+ * SequentialIterateToFullyImplicit is set, these outer iterations are repeated until
+ * the residual of the fully implicit system has converged. Once they stop reducing it,
+ * fail or exceed SequentialMaxIterations, the fully implicit update is used for the
+ * rest of the time step. Otherwise, a time step is done after a single outer
+ * iteration if both stages have converged.
  */
 template <class TypeTag>
 class BlackOilNewtonMethod : public GetPropType<TypeTag, Properties::DiscNewtonMethod>
@@ -116,10 +156,23 @@ class BlackOilNewtonMethod : public GetPropType<TypeTag, Properties::DiscNewtonM
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using Linearizer = GetPropType<TypeTag, Properties::Linearizer>;
     using MICPModule = BlackOilMICPModule<TypeTag>;
+    using SequentialSolver = BlackOilSequentialSolver<TypeTag>;
 
     static const unsigned numEq = getPropValue<TypeTag, Properties::NumEq>();
     static constexpr bool enableSaltPrecipitation = getPropValue<TypeTag, Properties::EnableSaltPrecipitation>();
 
+    // the transport stage of the sequential strategy only considers the black-oil
+    // components
+    static constexpr bool sequentialStrategyAvailable =
+        !getPropValue<TypeTag, Properties::EnableSolvent>()
+        && !getPropValue<TypeTag, Properties::EnableExtbo>()
+        && !getPropValue<TypeTag, Properties::EnablePolymer>()
+        && !getPropValue<TypeTag, Properties::EnableEnergy>()
+        && !getPropValue<TypeTag, Properties::EnableFoam>()
+        && !getPropValue<TypeTag, Properties::EnableBrine>()
+        && !getPropValue<TypeTag, Properties::EnableDiffusion>()
+        && !getPropValue<TypeTag, Properties::EnableMICP>();
+
 public:
     BlackOilNewtonMethod(Simulator& simulator) : ParentType(simulator)
     {
@@ -131,6 +184,22 @@ public:
         tempMax_ = EWOMS_GET_PARAM(TypeTag, Scalar, TemperatureMax);
         tempMin_ = EWOMS_GET_PARAM(TypeTag, Scalar, TemperatureMin);
 
+        const std::string strategy = EWOMS_GET_PARAM(TypeTag, std::string, NewtonSolutionStrategy);
+        if (strategy == "sequential") {
+            if constexpr (sequentialStrategyAvailable)
+                sequentialSolver_ = std::make_unique<SequentialSolver>(simulator);
+            else
+                throw std::runtime_error("The sequential solution strategy is not available if "
+                                         "any extension of the black-oil model is enabled");
+        }
+        else if (strategy != "fully-implicit")
+            throw std::runtime_error("Unknown Newton solution strategy '"+strategy+"'. "
+                                     "Valid strategies are 'fully-implicit' and 'sequential'");
+
+        iterateToFullyImplicit_ = EWOMS_GET_PARAM(TypeTag, bool, SequentialIterateToFullyImplicit);
+        maxSequentialIterations_ = EWOMS_GET_PARAM(TypeTag, int, SequentialMaxIterations);
+        maxPressureIterations_ = EWOMS_GET_PARAM(TypeTag, int, SequentialMaxPressureIterations);
+        maxTransportIterations_ = EWOMS_GET_PARAM(TypeTag, int, SequentialMaxTransportIterations);
     }
 
     /*!
@@ -142,6 +211,10 @@ public:
 
         wasSwitched_.resize(this->model().numTotalDof());
         std::fill(wasSwitched_.begin(), wasSwitched_.end(), false);
+
+        if (sequentialSolver_ && this->simulator_.gridView().comm().size() > 1)
+            throw std::runtime_error("The sequential solution strategy is only available for "
+                                     "serial runs");
     }
 
     /*!
@@ -159,6 +232,23 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, MaxTemperatureChange, "Maximum absolute change of temperature in a single iteration");
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, TemperatureMax, "Maximum absolute temperature");
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, TemperatureMin, "Minimum absolute temperature");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, NewtonSolutionStrategy,
+                             "The strategy used to solve the non-linear system of each time step. "
+                             "Possible values: 'fully-implicit' and 'sequential'");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, SequentialIterateToFullyImplicit,
+                             "Repeat the iterations of the sequential strategy until the fully "
+                             "implicit system has converged");
+        EWOMS_REGISTER_PARAM(TypeTag, int, SequentialMaxIterations,
+                             "The maximum number of iterations of the sequential strategy per "
+                             "time step before switching to the fully implicit one");
+        EWOMS_REGISTER_PARAM(TypeTag, int, SequentialMaxPressureIterations,
+                             "The maximum number of Newton iterations of the pressure stage of "
+                             "the sequential strategy");
+        EWOMS_REGISTER_PARAM(TypeTag, int, SequentialMaxTransportIterations,
+                             "The maximum number of Newton iterations of the transport stage of "
+                             "the sequential strategy");
+
+        SequentialSolver::registerParameters();
     }
 
     /*!
@@ -168,16 +258,63 @@ public:
     unsigned numPriVarsSwitched() const
     { return numPriVarsSwitched_; }
 
+    /*!
+     * \copydoc NewtonMethod::converged()
+     *
+     * If the iterations of the sequential strategy are not repeated until the fully
+     * implicit system has converged, this is the case if both of its stages converged.
+     */
+    bool converged() const
+    {
+        if (lastIterationSequential_ && !iterateToFullyImplicit_)
+            return sequentialConverged_;
+
+        return ParentType::converged();
+    }
+
+    /*!
+     * \brief Returns the total number of Newton iterations of the pressure stage of the
+     *        sequential strategy.
+     */
+    std::size_t numPressureIterations() const
+    { return numPressureIterations_; }
+
+    /*!
+     * \brief Returns the total number of Newton iterations of the transport stage of the
+     *        sequential strategy.
+     */
+    std::size_t numTransportIterations() const
+    { return numTransportIterations_; }
+
 protected:
     friend NewtonMethod<TypeTag>;
     friend ParentType;
 
+    /*!
+     * \copydoc NewtonMethod::begin_
+     */
+    void begin_(const SolutionVector& u)
+    {
+        ParentType::begin_(u);
+
+        if (sequentialSolver_ && this->model().numAuxiliaryModules() > 0)
+            throw std::runtime_error("The sequential solution strategy does not support "
+                                     "auxiliary equations");
+
+        numSequentialIterations_ = 0;
+        sequentialFailed_ = false;
+        lastIterationSequential_ = false;
+        sequentialConverged_ = false;
+    }
+
     /*!
      * \copydoc FvBaseNewtonMethod::beginIteration_
      */
     void beginIteration_()
     {
         numPriVarsSwitched_ = 0;
+        previousIterationSequential_ = lastIterationSequential_;
+        lastIterationSequential_ = false;
         ParentType::beginIteration_();
     }
 
@@ -202,15 +339,190 @@ protected:
         this->simulator_.model().newtonMethod().endIterMsg()
             << ", num switched=" << numPriVarsSwitched_;
 
+        if (sequentialSolver_) {
+            if (lastIterationSequential_)
+                this->endIterMsg() << ", sequential (pressure iterations=" << stagePressureIterations_
+                                   << ", transport iterations=" << stageTransportIterations_ << ")";
+            else
+                this->endIterMsg() << ", fully implicit";
+        }
+
         ParentType::endIteration_(uCurrentIter, uLastIter);
     }
 
+    /*!
+     * \copydoc NewtonMethod::primaryVarsSwitched_
+     */
+    bool primaryVarsSwitched_() const
+    { return numPriVarsSwitched_ > 0; }
+
+    /*!
+     * \copydoc NewtonMethod::proceed_
+     */
+    bool proceed_() const
+    {
+        if (lastIterationSequential_ && !iterateToFullyImplicit_)
+            return false;
+
+        return ParentType::proceed_();
+    }
+
+    /*!
+     * \copydoc NewtonMethod::canReuseJacobian_
+     */
+    bool canReuseJacobian_() const
+    {
+        // the stages of the sequential strategy relinearize the system
+        if (sequentialSolver_)
+            return false;
+
+        return ParentType::canReuseJacobian_();
+    }
+
+    /*!
+     * \copydoc NewtonMethod::solveLinearSystem_
+     *
+     * For the sequential strategy, this runs the pressure and the transport stages,
+     * which already update the solution, and returns the resulting change of the
+     * primary variables.
+     */
+    template <class Jacobian>
+    bool solveLinearSystem_(const Jacobian& jacobian,
+                            const GlobalEqVector& residual,
+                            GlobalEqVector& solutionUpdate)
+    {
+        if (!sequentialSolver_)
+            return ParentType::solveLinearSystem_(jacobian, residual, solutionUpdate);
+
+        // use the fully implicit update for the rest of the time step if the sequential
+        // iterations do not reduce the error of the fully implicit system
+        if ((previousIterationSequential_ && this->error_ > this->lastError_)
+            || numSequentialIterations_ >= maxSequentialIterations_)
+            sequentialFailed_ = true;
+        if (sequentialFailed_)
+            return ParentType::solveLinearSystem_(jacobian, residual, solutionUpdate);
+
+        auto& solution = this->model().solution(/*timeIdx=*/0);
+        const SolutionVector startSolution(solution);
+
+        // the storage terms of the last time step are refreshed if the system is
+        // linearized within the first iteration of a time step. this must not happen for
+        // the linearizations of the stages.
+        const int iterationIdx = this->numIterations();
+        this->setIterationIndex(std::max(iterationIdx, 1));
+
+        bool succeeded;
+        try {
+            succeeded = solveSequentially_();
+        }
+        catch (const NumericalProblem&) {
+            succeeded = false;
+        }
+        catch (const Dune::Exception&) {
+            succeeded = false;
+        }
+
+        if (!succeeded) {
+            if (this->verbose_())
+                std::cout << "Sequential iteration failed, using the fully implicit update\n"
+                          << std::flush;
+
+            // go back to the solution and the linearization of the beginning of the
+            // iteration
+            solution = startSolution;
+            this->model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+            this->linearizeDomain_();
+            this->linearizeAuxiliaryEquations_();
+            this->setIterationIndex(iterationIdx);
+            numPriVarsSwitched_ = 0;
+            sequentialFailed_ = true;
+
+            auto& currentResidual = this->model().linearizer().residual();
+            this->linearSolver_.prepare(jacobian, currentResidual);
+            this->linearSolver_.setResidual(currentResidual);
+            this->linearSolver_.getResidual(currentResidual);
+            return ParentType::solveLinearSystem_(jacobian, residual, solutionUpdate);
+        }
+
+        this->setIterationIndex(iterationIdx);
+        for (unsigned dofIdx = 0; dofIdx < solution.size(); ++dofIdx) {
+            solutionUpdate[dofIdx] = startSolution[dofIdx];
+            solutionUpdate[dofIdx] -= solution[dofIdx];
+        }
+
+        lastIterationSequential_ = true;
+        ++numSequentialIterations_;
+        return true;
+    }
+
+    // the pressure stage followed by the transport stage of the sequential strategy.
+    // returns false if one of the linear solvers did not converge.
+    bool solveSequentially_()
+    {
+        auto& linearizer = this->model().linearizer();
+        GlobalEqVector stageUpdate(linearizer.residual().size());
+
+        // the pressure stage starts with the linearization of the current iteration
+        bool pressureConverged = false;
+        stagePressureIterations_ = 0;
+        for (int iterIdx = 0; ; ++iterIdx) {
+            if (iterIdx > 0) {
+                this->linearizeDomain_();
+                this->linearizeAuxiliaryEquations_();
+            }
+
+            sequentialSolver_->assemblePressureSystem();
+            pressureConverged = sequentialSolver_->pressureError() <= this->tolerance();
+            if (pressureConverged || iterIdx >= maxPressureIterations_)
+                break;
+
+            if (!sequentialSolver_->solvePressureSystem(stageUpdate))
+                return false;
+            applyStageUpdate_(stageUpdate, linearizer.residual());
+            ++stagePressureIterations_;
+        }
+
+        // the transport stage keeps the total volume fluxes of the new pressures
+        sequentialSolver_->updateTotalVolumeFluxes();
+        bool transportConverged = false;
+        stageTransportIterations_ = 0;
+        for (int iterIdx = 0; ; ++iterIdx) {
+            sequentialSolver_->assembleTransportSystem();
+            transportConverged = sequentialSolver_->transportError() <= this->tolerance();
+            if (transportConverged || iterIdx >= maxTransportIterations_)
+                break;
+
+            if (!sequentialSolver_->solveTransportSystem(stageUpdate))
+                return false;
+            applyStageUpdate_(stageUpdate, sequentialSolver_->transportResidual());
+            ++stageTransportIterations_;
+        }
+
+        numPressureIterations_ += stagePressureIterations_;
+        numTransportIterations_ += stageTransportIterations_;
+        sequentialConverged_ = pressureConverged && transportConverged;
+        return true;
+    }
+
+    // update the current solution by the result of a stage of the sequential strategy
+    void applyStageUpdate_(const GlobalEqVector& stageUpdate,
+                           const GlobalEqVector& stageResidual)
+    {
+        auto& solution = this->model().solution(/*timeIdx=*/0);
+        const SolutionVector currentSolution(solution);
+        ParentType::update_(solution, currentSolution, stageUpdate, stageResidual);
+    }
+
 public:
     void update_(SolutionVector& nextSolution,
                  const SolutionVector& currentSolution,
                  const GlobalEqVector& solutionUpdate,
                  const GlobalEqVector& currentResidual)
     {
+        // the stages of the sequential strategy have already updated the solution
+        if (lastIterationSequential_)
+            return;
+
         const auto& comm = this->simulator_.gridView().comm();
 
         int succeeded;
@@ -443,6 +755,23 @@ private:
     // keep track of cells where the primary variable meaning has changed
     // to detect and hinder oscillations
     std::vector<bool> wasSwitched_;
+
+    // the sequential strategy. this is only allocated if it is selected
+    std::unique_ptr<SequentialSolver> sequentialSolver_;
+    bool iterateToFullyImplicit_;
+    int maxSequentialIterations_;
+    int maxPressureIterations_;
+    int maxTransportIterations_;
+
+    int numSequentialIterations_{0};
+    bool sequentialFailed_{false};
+    bool sequentialConverged_{false};
+    bool lastIterationSequential_{false};
+    bool previousIterationSequential_{false};
+    int stagePressureIterations_{0};
+    int stageTransportIterations_{0};
+    std::size_t numPressureIterations_{0};
+    std::size_t numTransportIterations_{0};
 };
 } // namespace Opm
 
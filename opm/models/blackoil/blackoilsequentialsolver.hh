@@ -0,0 +1,561 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::BlackOilSequentialSolver
+ */
+#ifndef EWOMS_BLACK_OIL_SEQUENTIAL_SOLVER_HH
+#define EWOMS_BLACK_OIL_SEQUENTIAL_SOLVER_HH
+
+#include "blackoilproperties.hh"
+#include "blackoillocalresidualtpfa.hh"
+
+#include <opm/models/discretization/common/fvbaseproperties.hh>
+#include <opm/models/nonlinear/newtonmethod.hh>
+#include <opm/models/parallel/threadmanager.hh>
+#include <opm/models/utils/parametersystem.hh>
+#include <opm/simulators/linalg/pressuresystem.hh>
+
+#include <opm/material/densead/Math.hpp>
+
+#include <dune/common/fvector.hh>
+#include <dune/grid/common/partitionset.hh>
+#include <dune/grid/common/rangegenerators.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Opm::Properties {
+
+template<class TypeTag, class MyTypeTag>
+struct SequentialLinearSolverTolerance { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SequentialLinearSolverMaxIterations { using type = UndefinedProperty; };
+template<class TypeTag>
+struct SequentialLinearSolverTolerance<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1e-4;
+};
+template<class TypeTag>
+struct SequentialLinearSolverMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 500; };
+
+} // namespace Opm::Properties
+
+namespace Opm {
+
+/*!
+ * \ingroup BlackOilModel
+ *
+ * \brief Assembles and solves the pressure and the transport systems of the sequential
+ *        solution strategy of the black-oil model.
+ *
+ * The pressure system is extracted from the Jacobian of the fully implicit system
+ * using quasi-IMPES weights, i.e., it only depends on the pressures. The transport
+ * system consists of the conservation equations of the black-oil model in which the
+ * pressures are kept constant and the phase fluxes are rewritten to the total volume
+ * fluxes which result from the pressure stage: If \f$v_\alpha\f$ denotes the volume
+ * flux of phase \f$\alpha\f$ of the current solution and \f$\lambda_\alpha\f$ the
+ * mobility of its upstream degree of freedom, the phase fluxes of the transport
+ * system are
+ * \f[
+ * v_\alpha^* = v_\alpha + \frac{\lambda_\alpha}{\sum_\beta \lambda_\beta}
+ *              \left(v_T^* - \sum_\beta v_\beta\right) \;,
+ * \f]
+ * where \f$v_T^*\f$ is the fixed total volume flux. The storage terms and the
+ * conversion of the phase fluxes to the fluxes of the conserved quantities are the
+ * ones of Opm::BlackOilLocalResidualTPFA. For each degree of freedom, the equation
+ * which dominates the pressure equation is replaced by the condition that its
+ * pressure does not change.
+ *
+ * The strategy which alternates between the two stages is implemented by
+ * Opm::BlackOilNewtonMethod. Only the extensions-free black-oil model is supported
+ * and the simulation must run on a single process.
+ */
+template <class TypeTag>
+class BlackOilSequentialSolver
+{
+    using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Evaluation = GetPropType<TypeTag, Properties::Evaluation>;
+    using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
+    using BoundaryContext = GetPropType<TypeTag, Properties::BoundaryContext>;
+    using IntensiveQuantities = GetPropType<TypeTag, Properties::IntensiveQuantities>;
+    using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
+    using Indices = GetPropType<TypeTag, Properties::Indices>;
+    using EqVector = GetPropType<TypeTag, Properties::EqVector>;
+    using RateVector = GetPropType<TypeTag, Properties::RateVector>;
+    using BoundaryRateVector = GetPropType<TypeTag, Properties::BoundaryRateVector>;
+    using GlobalEqVector = GetPropType<TypeTag, Properties::GlobalEqVector>;
+    using SparseMatrixAdapter = GetPropType<TypeTag, Properties::SparseMatrixAdapter>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
+    using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;
+    using FluidState = typename IntensiveQuantities::FluidState;
+    using LocalResidualTPFA = BlackOilLocalResidualTPFA<TypeTag>;
+
+    enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
+    enum { numPhases = getPropValue<TypeTag, Properties::NumPhases>() };
+    enum { pressureIdx = Indices::pressureSwitchIdx };
+
+    static constexpr bool useVolumetricResidual = getPropValue<TypeTag, Properties::UseVolumetricResidual>();
+    static constexpr bool enableConstraints = getPropValue<TypeTag, Properties::EnableConstraints>();
+
+    using EvalEqVector = Dune::FieldVector<Evaluation, numEq>;
+    using PressureSystem = Linear::PressureSystem<Scalar, numEq>;
+    using PressureMatrix = typename PressureSystem::Matrix;
+    using PressureVector = typename PressureSystem::Vector;
+    using TransportVector = Dune::BlockVector<EqVector>;
+
+public:
+    explicit BlackOilSequentialSolver(Simulator& simulator)
+        : simulator_(simulator)
+        , pressureSystem_(pressureIdx)
+    {
+        linearTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, SequentialLinearSolverTolerance);
+        maxLinearIterations_ = EWOMS_GET_PARAM(TypeTag, int, SequentialLinearSolverMaxIterations);
+    }
+
+    /*!
+     * \brief Register all run-time parameters of the sequential solver.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, SequentialLinearSolverTolerance,
+                             "The reduction of the residual which the linear solvers of the "
+                             "pressure and the transport stages need to achieve");
+        EWOMS_REGISTER_PARAM(TypeTag, int, SequentialLinearSolverMaxIterations,
+                             "The maximum number of iterations of the linear solvers of the "
+                             "pressure and the transport stages");
+    }
+
+    /*!
+     * \brief Extract the pressure system from the current linearization of the fully
+     *        implicit system and compute the error of the pressure equations.
+     */
+    void assemblePressureSystem()
+    {
+        const auto& model = simulator_.model();
+        const auto& linearizer = model.linearizer();
+        pressureSystem_.update(linearizer.jacobian().istlMatrix());
+        pressureSystem_.assembleRhs(linearizer.residual(), pressureRhs_);
+
+        pressureError_ = 0.0;
+        for (unsigned dofIdx = 0; dofIdx < model.numGridDof(); ++dofIdx) {
+            if (!isActiveDof_(dofIdx))
+                continue;
+
+            unsigned eqIdx = pressureSystem_.dominantEquation(dofIdx);
+            pressureError_ = std::max(pressureError_,
+                                      std::abs(pressureRhs_[dofIdx][0]*model.eqWeight(dofIdx, eqIdx)));
+        }
+    }
+
+    /*!
+     * \brief Returns the weighted maximum error of the pressure equations of the most
+     *        recent call to assemblePressureSystem().
+     */
+    Scalar pressureError() const
+    { return pressureError_; }
+
+    /*!
+     * \brief Solve the pressure system.
+     *
+     * \param update Receives the update of the primary variables, i.e., the negative
+     *               pressure changes. All other primary variables stay unchanged.
+     *
+     * \return true iff the linear solver converged
+     */
+    bool solvePressureSystem(GlobalEqVector& update)
+    {
+        const PressureMatrix& matrix = pressureSystem_.matrix();
+        PressureVector x(matrix.N());
+        x = 0.0;
+        PressureVector b(pressureRhs_);
+
+        Dune::MatrixAdapter<PressureMatrix, PressureVector, PressureVector> op(matrix);
+        Dune::SeqILU<PressureMatrix, PressureVector, PressureVector> ilu(matrix, /*relaxationFactor=*/1.0);
+        Dune::BiCGSTABSolver<PressureVector> solver(op, ilu, linearTolerance_, maxLinearIterations_,
+                                                    /*verbosity=*/0);
+        Dune::InverseOperatorResult result;
+        solver.apply(x, b, result);
+        numLinearIterations_ += result.iterations;
+
+        update.resize(x.size());
+        update = 0.0;
+        for (std::size_t dofIdx = 0; dofIdx < x.size(); ++dofIdx)
+            update[dofIdx][pressureIdx] = x[dofIdx][0];
+
+        return result.converged;
+    }
+
+    /*!
+     * \brief Store the total volume fluxes over all faces for the current solution.
+     *
+     * These are kept fixed by the transport stage.
+     */
+    void updateTotalVolumeFluxes()
+    {
+        const auto& model = simulator_.model();
+        totalVolumeFluxes_.resize(simulator_.gridView().size(/*codim=*/0));
+
+        ElementContext elemCtx(simulator_);
+        for (const auto& elem : elements(simulator_.gridView(), Dune::Partitions::interior)) {
+            elemCtx.updateAll(elem);
+
+            auto& fluxes = totalVolumeFluxes_[model.elementMapper().index(elem)];
+            fluxes.resize(elemCtx.numInteriorFaces(/*timeIdx=*/0));
+            for (unsigned scvfIdx = 0; scvfIdx < fluxes.size(); ++scvfIdx) {
+                const auto& extQuants = elemCtx.extensiveQuantities(scvfIdx, /*timeIdx=*/0);
+                fluxes[scvfIdx] = 0.0;
+                for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                    if (!FluidSystem::phaseIsActive(phaseIdx))
+                        continue;
+
+                    fluxes[scvfIdx] += getValue(extQuants.volumeFlux(phaseIdx));
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Linearize the transport system for the current solution and compute the
+     *        error of its equations.
+     *
+     * The total volume fluxes must have been updated by updateTotalVolumeFluxes() and
+     * the pressure system must have been assembled before.
+     */
+    void assembleTransportSystem()
+    {
+        auto& model = simulator_.model();
+        const auto& jacobian = model.linearizer().jacobian().istlMatrix();
+
+        // the transport system has the sparsity pattern of the fully implicit one
+        if (transportMatrix_.N() != jacobian.N() || transportMatrix_.nonzeroes() != jacobian.nonzeroes())
+            transportMatrix_ = jacobian;
+        transportMatrix_ = 0.0;
+        transportResidual_.resize(jacobian.N());
+        transportResidual_ = 0.0;
+
+        ElementContext elemCtx(simulator_);
+        std::vector<EvalEqVector> localResidual;
+        for (const auto& elem : elements(simulator_.gridView(), Dune::Partitions::interior)) {
+            elemCtx.updateStencil(elem);
+            elemCtx.updateAllIntensiveQuantities();
+
+            const auto& fluxes = totalVolumeFluxes_[model.elementMapper().index(elem)];
+            size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+            localResidual.resize(numDof);
+
+            size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+            for (unsigned focusDofIdx = 0; focusDofIdx < numPrimaryDof; ++focusDofIdx) {
+                elemCtx.setFocusDofIndex(focusDofIdx);
+                elemCtx.updateAllExtensiveQuantities();
+
+                for (auto& dofResidual : localResidual)
+                    dofResidual = 0.0;
+                evalLocalTransportResidual_(localResidual, elemCtx, fluxes);
+
+                // the residual of a degree of freedom is only added if it is the one
+                // in focus, the derivatives are added for all of them
+                unsigned globI = elemCtx.globalSpaceIndex(focusDofIdx, /*timeIdx=*/0);
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    transportResidual_[globI][eqIdx] += getValue(localResidual[focusDofIdx][eqIdx]);
+
+                for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                    unsigned globJ = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                    auto& block = transportMatrix_[globJ][globI];
+                    for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                            block[eqIdx][pvIdx] += localResidual[dofIdx][eqIdx].derivative(pvIdx);
+                }
+            }
+        }
+
+        finishTransportSystem_();
+    }
+
+    /*!
+     * \brief Returns the weighted maximum error of the transport equations of the most
+     *        recent call to assembleTransportSystem().
+     */
+    Scalar transportError() const
+    { return transportError_; }
+
+    /*!
+     * \brief Returns the residual of the transport system of the most recent call to
+     *        assembleTransportSystem().
+     */
+    const GlobalEqVector& transportResidual() const
+    { return transportResidual_; }
+
+    /*!
+     * \brief Solve the transport system.
+     *
+     * \param update Receives the update of the primary variables. The pressures are
+     *               not changed.
+     *
+     * \return true iff the linear solver converged
+     */
+    bool solveTransportSystem(GlobalEqVector& update)
+    {
+        TransportVector x(transportResidual_.size());
+        x = 0.0;
+        TransportVector b(transportResidual_.size());
+        for (std::size_t dofIdx = 0; dofIdx < b.size(); ++dofIdx)
+            b[dofIdx] = transportResidual_[dofIdx];
+
+        Dune::MatrixAdapter<IstlMatrix, TransportVector, TransportVector> op(transportMatrix_);
+        Dune::SeqILU<IstlMatrix, TransportVector, TransportVector> ilu(transportMatrix_, /*relaxationFactor=*/1.0);
+        Dune::BiCGSTABSolver<TransportVector> solver(op, ilu, linearTolerance_, maxLinearIterations_,
+                                                     /*verbosity=*/0);
+        Dune::InverseOperatorResult result;
+        solver.apply(x, b, result);
+        numLinearIterations_ += result.iterations;
+
+        update.resize(x.size());
+        for (std::size_t dofIdx = 0; dofIdx < x.size(); ++dofIdx) {
+            update[dofIdx] = x[dofIdx];
+            update[dofIdx][pressureIdx] = 0.0;
+        }
+
+        return result.converged;
+    }
+
+    /*!
+     * \brief Returns the total number of iterations of the linear solvers of both stages.
+     */
+    std::size_t numLinearIterations() const
+    { return numLinearIterations_; }
+
+private:
+    // returns true if a degree of freedom takes part in the pressure and the transport
+    // systems. this excludes auxiliary and constraint ones.
+    bool isActiveDof_(unsigned dofIdx) const
+    {
+        const auto& model = simulator_.model();
+        if (dofIdx >= model.numGridDof() || model.dofTotalVolume(dofIdx) <= 0.0)
+            return false;
+
+        if constexpr (enableConstraints)
+            return model.linearizer().constraintsMap().count(dofIdx) == 0;
+
+        return true;
+    }
+
+    void evalLocalTransportResidual_(std::vector<EvalEqVector>& residual,
+                                     const ElementContext& elemCtx,
+                                     const std::vector<Scalar>& totalVolumeFluxes) const
+    {
+        const auto& model = simulator_.model();
+        const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
+        unsigned focusDofIdx = elemCtx.focusDofIndex();
+        Scalar dt = simulator_.timeStepSize();
+
+        // storage and source terms
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+            const auto& intQuants = elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0);
+            Scalar scvVolume = stencil.subControlVolume(dofIdx).volume()*intQuants.extrusionFactor();
+
+            EvalEqVector storage;
+            if (dofIdx == focusDofIdx)
+                LocalResidualTPFA::computeStorage(storage, intQuants);
+            else {
+                EqVector tmp;
+                LocalResidualTPFA::computeStorage(tmp, intQuants);
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    storage[eqIdx] = tmp[eqIdx];
+            }
+
+            EqVector oldStorage;
+            if (elemCtx.enableStorageCache())
+                oldStorage = model.cachedStorage(elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0),
+                                                 /*timeIdx=*/1);
+            else
+                LocalResidualTPFA::computeStorage(oldStorage, elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/1));
+
+            RateVector source;
+            model.localResidual(ThreadManager::threadId()).computeSource(source, elemCtx, dofIdx, /*timeIdx=*/0);
+
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                residual[dofIdx][eqIdx] += (storage[eqIdx] - oldStorage[eqIdx])*scvVolume/dt;
+                if (dofIdx == focusDofIdx)
+                    residual[dofIdx][eqIdx] -= source[eqIdx]*scvVolume;
+                else
+                    residual[dofIdx][eqIdx] -= getValue(source[eqIdx])*scvVolume;
+            }
+        }
+
+        // fluxes over the interior faces for the fixed total volume fluxes
+        RateVector flux;
+        std::array<Evaluation, numPhases> mobility;
+        size_t numInteriorFaces = elemCtx.numInteriorFaces(/*timeIdx=*/0);
+        for (unsigned scvfIdx = 0; scvfIdx < numInteriorFaces; ++scvfIdx) {
+            const auto& face = stencil.interiorFace(scvfIdx);
+            const auto& extQuants = elemCtx.extensiveQuantities(scvfIdx, /*timeIdx=*/0);
+
+            Evaluation totalVolumeFlux = 0.0;
+            Evaluation totalMobility = 0.0;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                if (!FluidSystem::phaseIsActive(phaseIdx))
+                    continue;
+
+                unsigned upIdx = static_cast<unsigned>(extQuants.upstreamIndex(phaseIdx));
+                const auto& up = elemCtx.intensiveQuantities(upIdx, /*timeIdx=*/0);
+                if (upIdx == focusDofIdx)
+                    mobility[phaseIdx] = up.mobility(phaseIdx);
+                else
+                    mobility[phaseIdx] = getValue(up.mobility(phaseIdx));
+
+                totalVolumeFlux += extQuants.volumeFlux(phaseIdx);
+                totalMobility += mobility[phaseIdx];
+            }
+
+            flux = 0.0;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                if (!FluidSystem::phaseIsActive(phaseIdx))
+                    continue;
+
+                Evaluation volumeFlux = extQuants.volumeFlux(phaseIdx);
+                if (getValue(totalMobility) > 0.0)
+                    volumeFlux += mobility[phaseIdx]/totalMobility
+                        *(totalVolumeFluxes[scvfIdx] - totalVolumeFlux);
+
+                unsigned upIdx = static_cast<unsigned>(extQuants.upstreamIndex(phaseIdx));
+                const auto& upFs = elemCtx.intensiveQuantities(upIdx, /*timeIdx=*/0).fluidState();
+                unsigned pvtRegionIdx = elemCtx.intensiveQuantities(upIdx, /*timeIdx=*/0).pvtRegionIndex();
+                if (upIdx == focusDofIdx) {
+                    const auto& invB = getInvB_<FluidSystem, FluidState, Evaluation>(upFs, phaseIdx, pvtRegionIdx);
+                    LocalResidualTPFA::template evalPhaseFluxes_<Evaluation, Evaluation, FluidState>(
+                        flux, phaseIdx, pvtRegionIdx, invB*volumeFlux, upFs);
+                }
+                else {
+                    const auto& invB = getInvB_<FluidSystem, FluidState, Scalar>(upFs, phaseIdx, pvtRegionIdx);
+                    LocalResidualTPFA::template evalPhaseFluxes_<Scalar, Evaluation, FluidState>(
+                        flux, phaseIdx, pvtRegionIdx, invB*volumeFlux, upFs);
+                }
+            }
+
+            Scalar alpha = extQuants.extrusionFactor()*face.area();
+            unsigned i = face.interiorIndex();
+            unsigned j = face.exteriorIndex();
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                residual[i][eqIdx] += flux[eqIdx]*alpha;
+                residual[j][eqIdx] -= flux[eqIdx]*alpha;
+            }
+        }
+
+        // boundary conditions
+        if (!elemCtx.onBoundary())
+            return;
+
+        BoundaryContext boundaryCtx(elemCtx);
+        // move the iterator to the first boundary
+        if (boundaryCtx.intersection(0).neighbor())
+            boundaryCtx.increment();
+
+        BoundaryRateVector values;
+        size_t numBoundaryFaces = boundaryCtx.numBoundaryFaces(/*timeIdx=*/0);
+        for (unsigned faceIdx = 0; faceIdx < numBoundaryFaces; ++faceIdx, boundaryCtx.increment()) {
+            simulator_.problem().boundary(values, boundaryCtx, faceIdx, /*timeIdx=*/0);
+
+            const auto& boundaryFace = boundaryCtx.stencil(/*timeIdx=*/0).boundaryFace(faceIdx);
+            unsigned dofIdx = boundaryFace.interiorIndex();
+            Scalar alpha = boundaryFace.area()*elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).extrusionFactor();
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                residual[dofIdx][eqIdx] += values[eqIdx]*alpha;
+        }
+    }
+
+    // replace the equations which are not part of the transport system and compute its
+    // error
+    void finishTransportSystem_()
+    {
+        const auto& model = simulator_.model();
+
+        transportError_ = 0.0;
+        for (unsigned dofIdx = 0; dofIdx < transportResidual_.size(); ++dofIdx) {
+            auto& row = transportMatrix_[dofIdx];
+
+            // keep the primary variables of the auxiliary and constraint degrees of
+            // freedom
+            if (!isActiveDof_(dofIdx)) {
+                for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                    *colIt = 0.0;
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    row[dofIdx][eqIdx][eqIdx] = 1.0;
+                transportResidual_[dofIdx] = 0.0;
+                continue;
+            }
+
+            if (useVolumetricResidual) {
+                Scalar dofVolume = model.dofTotalVolume(dofIdx);
+                for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                    *colIt /= dofVolume;
+                transportResidual_[dofIdx] /= dofVolume;
+            }
+
+            // the equation which dominates the pressure equation is replaced by the
+            // condition that the pressure does not change
+            unsigned droppedEqIdx = pressureSystem_.dominantEquation(dofIdx);
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                (*colIt)[droppedEqIdx] = 0.0;
+            row[dofIdx][droppedEqIdx][pressureIdx] = 1.0;
+            transportResidual_[dofIdx][droppedEqIdx] = 0.0;
+
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                transportError_ = std::max(transportError_,
+                                           std::abs(transportResidual_[dofIdx][eqIdx]
+                                                    *model.eqWeight(dofIdx, eqIdx)));
+        }
+    }
+
+    Simulator& simulator_;
+
+    PressureSystem pressureSystem_;
+    PressureVector pressureRhs_;
+    Scalar pressureError_{0.0};
+
+    // the total volume flux over each interior face of the elements' stencils
+    std::vector<std::vector<Scalar>> totalVolumeFluxes_;
+
+    IstlMatrix transportMatrix_;
+    GlobalEqVector transportResidual_;
+    Scalar transportError_{0.0};
+
+    Scalar linearTolerance_;
+    int maxLinearIterations_;
+    std::size_t numLinearIterations_{0};
+};
+
+} // namespace Opm
+
+#endif
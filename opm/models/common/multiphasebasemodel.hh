@@ -138,6 +138,24 @@ struct ThermalConductionLawParams<TypeTag, TTag::MultiPhaseBaseModel>
 template<class TypeTag>
 struct EnableGravity<TypeTag, TTag::MultiPhaseBaseModel> { static constexpr bool value = false; };
 
+//! the tabulation of phase equilibria must be explicitly enabled
+template<class TypeTag>
+struct EnableIsat<TypeTag, TTag::MultiPhaseBaseModel> { static constexpr bool value = false; };
+template<class TypeTag>
+struct IsatTolerance<TypeTag, TTag::MultiPhaseBaseModel>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1e-4;
+};
+template<class TypeTag>
+struct IsatBinWidth<TypeTag, TTag::MultiPhaseBaseModel>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.05;
+};
+template<class TypeTag>
+struct IsatMemoryBudget<TypeTag, TTag::MultiPhaseBaseModel> { static constexpr int value = 256; };
+
 
 } // namespace Opm::Properties
 
@@ -81,6 +81,20 @@ struct EnableGravity { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct EnableDiffusion { using type = UndefinedProperty; };
 
+//! Specify whether the results of the phase equilibrium calculations should be tabulated
+//! using in-situ adaptive tabulation (ISAT). This is only used by the compositional models.
+template<class TypeTag, class MyTypeTag>
+struct EnableIsat { using type = UndefinedProperty; };
+//! The maximum scaled error of the phase equilibrium results taken from the table
+template<class TypeTag, class MyTypeTag>
+struct IsatTolerance { using type = UndefinedProperty; };
+//! The relative width of the bins of the table in each input dimension
+template<class TypeTag, class MyTypeTag>
+struct IsatBinWidth { using type = UndefinedProperty; };
+//! The maximum amount of memory used by the table [MB]
+template<class TypeTag, class MyTypeTag>
+struct IsatMemoryBudget { using type = UndefinedProperty; };
+
 } // namespace Opm::Properties
 
 #endif
@@ -74,7 +74,8 @@ public:
         unsigned globalI = elemCtx.globalSpaceIndex(insideScvIdx, timeIdx);
         unsigned globalJ = elemCtx.globalSpaceIndex(outsideScvIdx, timeIdx);
         const auto& fractureMapper = elemCtx.problem().fractureMapper();
-        if (!fractureMapper.isFractureEdge(globalI, globalJ))
+        isFractureFace_ = fractureMapper.isFractureEdge(globalI, globalJ);
+        if (!isFractureFace_)
             // do nothing if no fracture goes though the current edge
             return;
 
@@ -114,6 +115,13 @@ public:
     }
 
 public:
+    /*!
+     * \brief Returns true iff a fracture goes through the edge which corresponds to
+     *        the sub-control volume face.
+     */
+    bool isFractureFace() const
+    { return isFractureFace_; }
+
     const DimMatrix& fractureIntrinsicPermeability() const
     { return fractureIntrinsicPermeability_; }
 
@@ -131,6 +139,7 @@ private:
     DimVector fractureFilterVelocity_[numPhases];
     Scalar fractureVolumeFlux_[numPhases];
     Scalar fractureWidth_;
+    bool isFractureFace_;
 };
 
 } // namespace Opm
@@ -117,13 +117,7 @@ public:
         ParentType::computeFlux(flux, elemCtx, scvfIdx, timeIdx);
 
         const auto& extQuants = elemCtx.extensiveQuantities(scvfIdx, timeIdx);
-
-        unsigned i = extQuants.interiorIndex();
-        unsigned j = extQuants.exteriorIndex();
-        unsigned I = elemCtx.globalSpaceIndex(i, timeIdx);
-        unsigned J = elemCtx.globalSpaceIndex(j, timeIdx);
-        const auto& fractureMapper = elemCtx.problem().fractureMapper();
-        if (!fractureMapper.isFractureEdge(I, J))
+        if (!extQuants.isFractureFace())
             // do nothing if the edge from i to j is not part of a
             // fracture
             return;
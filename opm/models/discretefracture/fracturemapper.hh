@@ -30,34 +30,24 @@
 #include <opm/models/utils/propertysystem.hh>
 
 #include <algorithm>
-#include <set>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace Opm {
 
 /*!
  * \ingroup DiscreteFractureModel
  * \brief Stores the topology of fractures.
+ *
+ * The fracture edges are first collected using addFractureEdge(). They are compiled
+ * into dense arrays which can be queried in constant time by finalize() or, if that has
+ * not been called after the last edge was added, by the first query.
  */
 template <class TypeTag>
 class FractureMapper
 {
-    struct FractureEdge
-    {
-        FractureEdge(unsigned edgeVertex1Idx, unsigned edgeVertex2Idx)
-            : i_(std::min(edgeVertex1Idx, edgeVertex2Idx)),
-              j_(std::max(edgeVertex1Idx, edgeVertex2Idx))
-        {}
-
-        bool operator<(const FractureEdge& e) const
-        { return i_ < e.i_ || (i_ == e.i_ && j_ < e.j_); }
-
-        bool operator==(const FractureEdge& e) const
-        { return i_ == e.i_ && j_ == e.j_; }
-
-        unsigned i_;
-        unsigned j_;
-    };
-
 public:
     /*!
      * \brief Constructor
@@ -73,18 +63,30 @@ public:
      */
     void addFractureEdge(unsigned vertexIdx1, unsigned vertexIdx2)
     {
-        fractureEdges_.insert(FractureEdge(vertexIdx1, vertexIdx2));
-        fractureVertices_.insert(vertexIdx1);
-        fractureVertices_.insert(vertexIdx2);
+        addedEdges_.emplace_back(vertexIdx1, vertexIdx2);
+        finalized_.store(false, std::memory_order_relaxed);
     }
 
+    /*!
+     * \brief Compile the fracture edges added so far into the data structures used
+     *        for the queries.
+     *
+     * Calling this method after the last fracture edge has been added is optional, but
+     * it avoids that the first query needs to do it.
+     */
+    void finalize()
+    { compileIfNeeded_(); }
+
     /*!
      * \brief Returns true iff a fracture cuts through a given vertex.
      *
      * \param vertexIdx The index of the vertex.
      */
     bool isFractureVertex(unsigned vertexIdx) const
-    { return fractureVertices_.count(vertexIdx) > 0; }
+    {
+        compileIfNeeded_();
+        return vertexIdx < isFractureVertex_.size() && isFractureVertex_[vertexIdx];
+    }
 
     /*!
      * \brief Returns true iff a fracture is associated with a given edge.
@@ -94,13 +96,75 @@ public:
      */
     bool isFractureEdge(unsigned vertex1Idx, unsigned vertex2Idx) const
     {
-        FractureEdge tmp(vertex1Idx, vertex2Idx);
-        return fractureEdges_.count(tmp) > 0;
+        if (!isFractureVertex(vertex1Idx) || !isFractureVertex(vertex2Idx))
+            return false;
+
+        // a fracture vertex is usually only connected to very few other fracture
+        // vertices, so a linear search is the fastest option here
+        auto beginIt = neighbors_.begin() + neighborOffsets_[vertex1Idx];
+        auto endIt = neighbors_.begin() + neighborOffsets_[vertex1Idx + 1];
+        return std::find(beginIt, endIt, vertex2Idx) != endIt;
     }
 
 private:
-    std::set<FractureEdge> fractureEdges_;
-    std::set<unsigned> fractureVertices_;
+    // the queries may be done concurrently by the threads of the linearizer, so only
+    // one of them must compile the topology
+    void compileIfNeeded_() const
+    {
+        if (finalized_.load(std::memory_order_acquire))
+            return;
+
+        std::lock_guard<std::mutex> lock(compileMutex_);
+        if (!finalized_.load(std::memory_order_relaxed))
+            compile_();
+    }
+
+    void compile_() const
+    {
+        // edges are usually added once for each element they belong to
+        for (auto& edge : addedEdges_)
+            if (edge.second < edge.first)
+                std::swap(edge.first, edge.second);
+        std::sort(addedEdges_.begin(), addedEdges_.end());
+        addedEdges_.erase(std::unique(addedEdges_.begin(), addedEdges_.end()), addedEdges_.end());
+
+        unsigned numVertices = 0;
+        for (const auto& edge : addedEdges_)
+            numVertices = std::max(numVertices, std::max(edge.first, edge.second) + 1);
+
+        // mark the fracture vertices and count the fracture edges of each vertex
+        isFractureVertex_.assign(numVertices, 0);
+        neighborOffsets_.assign(numVertices + 1, 0);
+        for (const auto& edge : addedEdges_) {
+            isFractureVertex_[edge.first] = 1;
+            isFractureVertex_[edge.second] = 1;
+            ++neighborOffsets_[edge.first + 1];
+            ++neighborOffsets_[edge.second + 1];
+        }
+        for (unsigned vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+            neighborOffsets_[vertexIdx + 1] += neighborOffsets_[vertexIdx];
+
+        // store the vertices connected by a fracture edge to each vertex in compressed
+        // row format
+        neighbors_.resize(neighborOffsets_[numVertices]);
+        std::vector<unsigned> fillPos(neighborOffsets_.begin(), neighborOffsets_.end() - 1);
+        for (const auto& edge : addedEdges_) {
+            neighbors_[fillPos[edge.first]++] = edge.second;
+            neighbors_[fillPos[edge.second]++] = edge.first;
+        }
+
+        finalized_.store(true, std::memory_order_release);
+    }
+
+    // the compiled topology is a cache of the added edges, so it is updated by the
+    // queries if necessary
+    mutable std::vector<std::pair<unsigned, unsigned>> addedEdges_;
+    mutable std::atomic<bool> finalized_{true};
+    mutable std::mutex compileMutex_;
+
+    mutable std::vector<unsigned char> isFractureVertex_;
+    mutable std::vector<unsigned> neighborOffsets_;
+    mutable std::vector<unsigned> neighbors_;
 };
 
 } // namespace Opm
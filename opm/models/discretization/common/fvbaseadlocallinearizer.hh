@@ -39,6 +39,8 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
+
 namespace Opm {
 // forward declaration
 template<class TypeTag>
@@ -138,6 +140,11 @@ public:
         simulatorPtr_ = &simulator;
         delete internalElemContext_;
         internalElemContext_ = new ElementContext(simulator);
+
+        // allocate the storage for the largest stencil of the grid up front
+        const auto& model = simulator.model();
+        residual_.reserve(model.maxStencilNumDof());
+        jacobian_.setSize(model.maxStencilNumDof(), model.maxStencilNumPrimaryDof());
     }
 
     /*!
@@ -251,8 +258,12 @@ protected:
         size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
 
         residual_.resize(numDof);
-        if (jacobian_.N() != numDof || jacobian_.M() != numPrimaryDof)
-          jacobian_.setSize(numDof, numPrimaryDof);
+
+        // the Jacobian only grows: shrinking a Dune::Matrix releases its rows, which
+        // would then need to be allocated again for the next larger element
+        if (jacobian_.N() < numDof || jacobian_.M() < numPrimaryDof)
+            jacobian_.setSize(std::max(jacobian_.N(), numDof),
+                              std::max(jacobian_.M(), numPrimaryDof));
     }
 
     /*!
@@ -47,11 +47,15 @@
 #include "fvbaseextensivequantities.hh"
 #include "baseauxiliarymodule.hh"
 
+#include <opm/models/parallel/elementcostbalancer.hh>
+#include <opm/models/parallel/firsttouchallocator.hh>
 #include <opm/models/parallel/gridcommhandles.hh>
 #include <opm/models/parallel/threadmanager.hh>
 #include <opm/simulators/linalg/nullborderlistmanager.hh>
 #include <opm/models/utils/simulator.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 #include <opm/models/io/vtkprimaryvarsmodule.hh>
@@ -66,6 +70,7 @@
 
 #if HAVE_DUNE_FEM
 #include <dune/fem/space/common/adaptationmanager.hh>
+#include <dune/fem/space/common/dofmanager.hh>
 #include <dune/fem/space/common/restrictprolongtuple.hh>
 #include <dune/fem/function/blockvectorfunction.hh>
 #include <dune/fem/misc/capabilities.hh>
@@ -77,6 +82,7 @@
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace Opm {
@@ -128,6 +134,35 @@ struct GradientCalculator<TypeTag, TTag::FvBaseDiscretization> { using type = Fv
 template<class TypeTag>
 struct MaxTimeStepDivisions<TypeTag, TTag::FvBaseDiscretization> { static constexpr int value = 10; };
 
+//! By default, select the time step size based on the number of Newton iterations
+template<class TypeTag>
+struct TimeStepControl<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "iteration-count"; };
+
+template<class TypeTag>
+struct TimeStepControlTargetChange<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.1;
+};
+
+template<class TypeTag>
+struct TimeStepControlMaxGrowth<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 3.0;
+};
+
+//! By default, failed time steps do not limit the size of the subsequent ones
+template<class TypeTag>
+struct TimeStepFailureMemory<TypeTag, TTag::FvBaseDiscretization> { static constexpr unsigned value = 0; };
+
+template<class TypeTag>
+struct TimeStepFailureSafetyFactor<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.8;
+};
+
 
 //! By default, do not continue with a non-converged solution instead of giving up
 //! if we encounter a time step size smaller than the minimum time
@@ -177,7 +212,16 @@ struct ElementEqVector<TypeTag, TTag::FvBaseDiscretization>
  */
 template<class TypeTag>
 struct GlobalEqVector<TypeTag, TTag::FvBaseDiscretization>
-{ using type = Dune::BlockVector<GetPropType<TypeTag, Properties::EqVector>>; };
+{
+private:
+    using EqVector = GetPropType<TypeTag, Properties::EqVector>;
+    using Allocator =
+        OptionalFirstTouchAllocator<EqVector,
+                                    getPropValue<TypeTag, Properties::EnableFirstTouchAllocation>()>;
+
+public:
+    using type = Dune::BlockVector<EqVector, Allocator>;
+};
 
 /*!
  * \brief An object representing a local set of primary variables.
@@ -246,6 +290,18 @@ struct MinTimeStepSize<TypeTag, TTag::FvBaseDiscretization>
 template<class TypeTag>
 struct EnableGridAdaptation<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+//! Do not repartition the grid based on the costs of the elements by default
+template<class TypeTag>
+struct EnableDynamicLoadBalancing<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+//! Repartition the grid if the costs of a process exceed the mean by more than 20%
+template<class TypeTag>
+struct LoadBalancingImbalanceThreshold<TypeTag, TTag::FvBaseDiscretization>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1.2;
+};
+
 //! By default, write the simulation output to the current working directory
 template<class TypeTag>
 struct OutputDir<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "."; };
@@ -254,6 +310,10 @@ struct OutputDir<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto va
 template<class TypeTag>
 struct EnableVtkOutput<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = true; };
 
+//! Do not write a run record by default
+template<class TypeTag>
+struct RunRecordFile<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = ""; };
+
 //! By default, write the VTK output to asynchronously to disk
 //!
 //! This has only an effect if EnableVtkOutput is true
@@ -268,6 +328,11 @@ struct VtkOutputFormat<TypeTag, TTag::FvBaseDiscretization> { static constexpr i
 template<class TypeTag>
 struct EnableStorageCache<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+// store the cached storage terms with full precision by default
+template<class TypeTag>
+struct StorageCacheScalar<TypeTag, TTag::FvBaseDiscretization>
+{ using type = GetPropType<TypeTag, Properties::Scalar>; };
+
 // disable constraints by default
 template<class TypeTag>
 struct EnableConstraints<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
@@ -279,6 +344,15 @@ struct EnableConstraints<TypeTag, TTag::FvBaseDiscretization> { static constexpr
 template<class TypeTag>
 struct EnableIntensiveQuantityCache<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+// do not keep the intensive quantities of the last time step by default because this
+// requires a second buffer for the current slot of the cache
+template<class TypeTag>
+struct EnableTimeStepSnapshot<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+// do not keep the stencils of all elements in memory by default
+template<class TypeTag>
+struct EnableStencilCache<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
 // do not use thermodynamic hints by default. If you enable this, make sure to also
 // enable the intensive quantity cache above to avoid getting an exception...
 template<class TypeTag>
@@ -312,6 +386,11 @@ struct TimeDiscHistorySize<TypeTag, TTag::FvBaseDiscretization> { static constex
 template<class TypeTag>
 struct ExtensiveStorageTerm<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+//! The source terms of a problem may depend on the intensive quantities of any degree of
+//! freedom, so they are not considered to be local by default.
+template<class TypeTag>
+struct LocalSourceTerms<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
 // use volumetric residuals is default
 template<class TypeTag>
 struct UseVolumetricResidual<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = true; };
@@ -325,6 +404,23 @@ struct EnableExperiments<TypeTag, TTag::FvBaseDiscretization> { static constexpr
 
 namespace Opm {
 
+namespace detail {
+// the type of the value-only fluid states of a model's intensive quantities. models
+// which do not define a ScalarFluidState type do not support records of their fluid
+// states.
+struct NoScalarFluidState
+{};
+
+template <class IntensiveQuantities, class = void>
+struct ScalarFluidStateOf
+{ using type = NoScalarFluidState; };
+
+template <class IntensiveQuantities>
+struct ScalarFluidStateOf<IntensiveQuantities,
+                          std::void_t<typename IntensiveQuantities::ScalarFluidState> >
+{ using type = typename IntensiveQuantities::ScalarFluidState; };
+} // namespace detail
+
 /*!
  * \ingroup FiniteVolumeDiscretizations
  *
@@ -369,7 +465,17 @@ class FvBaseDiscretization
         historySize = getPropValue<TypeTag, Properties::TimeDiscHistorySize>(),
     };
 
-    using IntensiveQuantitiesVector = std::vector<IntensiveQuantities, aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> >;
+    // the allocator of the large per-DOF arrays
+    template <class T, class BaseAllocator = std::allocator<T> >
+    using DofAllocator =
+        OptionalFirstTouchAllocator<T,
+                                    getPropValue<TypeTag, Properties::EnableFirstTouchAllocation>(),
+                                    BaseAllocator>;
+
+    using IntensiveQuantitiesAllocator =
+        DofAllocator<IntensiveQuantities,
+                     aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> >;
+    using IntensiveQuantitiesVector = std::vector<IntensiveQuantities, IntensiveQuantitiesAllocator>;
 
     using Element = typename GridView::template Codim<0>::Entity;
     using ElementIterator = typename GridView::template Codim<0>::Iterator;
@@ -378,6 +484,15 @@ class FvBaseDiscretization
     using VectorBlock = Dune::FieldVector<Evaluation, numEq>;
     using EvalEqVector = Dune::FieldVector<Evaluation, numEq>;
 
+    using StorageCacheScalar = GetPropType<TypeTag, Properties::StorageCacheScalar>;
+    using StorageCacheVector = Dune::FieldVector<StorageCacheScalar, numEq>;
+    using StorageCache = Dune::BlockVector<StorageCacheVector, DofAllocator<StorageCacheVector> >;
+
+    using ScalarFluidState = typename detail::ScalarFluidStateOf<IntensiveQuantities>::type;
+    using ScalarFluidStateVector = std::vector<ScalarFluidState, DofAllocator<ScalarFluidState> >;
+    static constexpr bool haveScalarFluidState =
+        !std::is_same_v<ScalarFluidState, detail::NoScalarFluidState>;
+
     using LocalEvalBlockVector = typename LocalResidual::LocalEvalBlockVector;
 
 public:
@@ -462,9 +577,14 @@ public:
         , space_( asImp_().numGridDof() )
 #endif
         , enableGridAdaptation_( EWOMS_GET_PARAM(TypeTag, bool, EnableGridAdaptation) )
+        , enableDynamicLoadBalancing_( EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing) )
+        , loadBalancingImbalanceThreshold_( EWOMS_GET_PARAM(TypeTag, Scalar, LoadBalancingImbalanceThreshold) )
         , enableIntensiveQuantityCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableIntensiveQuantityCache))
         , enableStorageCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache))
         , enableThermodynamicHints_(EWOMS_GET_PARAM(TypeTag, bool, EnableThermodynamicHints))
+        , enableTimeStepSnapshot_(EWOMS_GET_PARAM(TypeTag, bool, EnableTimeStepSnapshot))
+        , enableStencilCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStencilCache))
+        , memoryDryRun_(EWOMS_GET_PARAM_(TypeTag, bool, MemoryDryRun))
     {
 #if HAVE_DUNE_FEM
         if (enableGridAdaptation_ && !Dune::Fem::Capabilities::isLocallyAdaptive<Grid>::v)
@@ -487,13 +607,23 @@ public:
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
             solution_[timeIdx].reset(new DiscreteFunction("solution", space_));
 
-            if (storeIntensiveQuantities()) {
+            // for a memory dry run, the footprints of the caches are only estimated
+            if (memoryDryRun_)
+                continue;
+
+            if (storeIntensiveQuantities() && (timeIdx == 0 || storeIntensiveQuantityHistory_())) {
                 intensiveQuantityCache_[timeIdx].resize(numDof);
                 intensiveQuantityCacheUpToDate_[timeIdx].resize(numDof, /*value=*/false);
             }
 
-            if (enableStorageCache_)
+            // the storage term is only cached for the previous time levels
+            if (enableStorageCache_ && timeIdx > 0)
                 storageCache_[timeIdx].resize(numDof);
+
+            if (storeFluidStateRecords_() && timeIdx > 0) {
+                fluidStateRecords_[timeIdx].resize(numDof);
+                fluidStateRecordUpToDate_[timeIdx].resize(numDof, /*value=*/0);
+            }
         }
 
         resizeAndResetIntensiveQuantitiesCache_();
@@ -529,18 +659,39 @@ public:
         VtkPrimaryVarsModule<TypeTag>::registerParameters();
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableGridAdaptation, "Enable adaptive grid refinement/coarsening");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableDynamicLoadBalancing, "Repartition the grid based on the measured computational costs of the elements before it is adapted");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, LoadBalancingImbalanceThreshold, "The ratio between the largest and the mean computational costs of the processes above which the grid is repartitioned");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkOutput, "Global switch for turning on writing VTK files");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableTimeStepSnapshot, "Keep the intensive quantities of the last converged time step to restore them without recomputation if a time step fails.");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStencilCache, "Compute the finite volume geometry of all elements once and keep it in memory.");
         EWOMS_REGISTER_PARAM(TypeTag, std::string, OutputDir, "The directory to which result files are written");
     }
 
+    /*!
+     * \brief Called by the problem after the simulation has finished.
+     *
+     * Models can use this e.g. to print statistics about the run.
+     */
+    void finalize()
+    { }
+
     /*!
      * \brief Apply the initial conditions to the model.
      */
     void finishInit()
     {
+        // precompute the stencils of all elements if requested. since this method is
+        // also called if the grid has changed, the cache is always rebuilt here.
+        if (enableStencilCache_ && !memoryDryRun_)
+            updateStencilCache_();
+
+        // the chunks of elements which are processed by the threads also need to be
+        // re-determined if the grid has changed
+        updateElementChunks_();
+
         // initialize the volume of the finite volumes to zero
         size_t numDof = asImp_().numGridDof();
         dofTotalVolume_.resize(numDof);
@@ -548,6 +699,10 @@ public:
 
         ElementContext elemCtx(simulator_);
         gridTotalVolume_ = 0.0;
+        maxStencilNumDof_ = 0;
+        maxStencilNumPrimaryDof_ = 0;
+        maxStencilNumInteriorFaces_ = 0;
+        maxStencilNumBoundaryFaces_ = 0;
 
         // iterate through the grid and evaluate the initial condition
         for (const auto& elem : elements(gridView_)) {
@@ -561,6 +716,13 @@ public:
             elemCtx.updateStencil(elem);
             const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
 
+            // remember the size of the largest stencil so that the scratch space of the
+            // element contexts and the local linearizers can be allocated up front
+            maxStencilNumDof_ = std::max<size_t>(maxStencilNumDof_, stencil.numDof());
+            maxStencilNumPrimaryDof_ = std::max<size_t>(maxStencilNumPrimaryDof_, stencil.numPrimaryDof());
+            maxStencilNumInteriorFaces_ = std::max<size_t>(maxStencilNumInteriorFaces_, stencil.numInteriorFaces());
+            maxStencilNumBoundaryFaces_ = std::max<size_t>(maxStencilNumBoundaryFaces_, stencil.numBoundaryFaces());
+
             // loop over all element vertices, i.e. sub control volumes
             for (unsigned dofIdx = 0; dofIdx < elemCtx.numPrimaryDof(/*timeIdx=*/0); dofIdx++) {
                 // map the local degree of freedom index to the global one
@@ -723,8 +885,7 @@ public:
      */
     const IntensiveQuantities* cachedIntensiveQuantities(unsigned globalIdx, unsigned timeIdx) const
     {
-        if (!enableIntensiveQuantityCache_ ||
-            !intensiveQuantityCacheUpToDate_[timeIdx][globalIdx])
+        if (!enableIntensiveQuantityCache_)
             return 0;
 
         if (timeIdx > 0 && enableStorageCache_)
@@ -732,9 +893,61 @@ public:
             // recent time step are cached!
             return 0;
 
+        if (!intensiveQuantityCacheUpToDate_[timeIdx][globalIdx]) {
+            // until the solution gets updated, the snapshot of the last time step holds
+            // the intensive quantities of the current solution
+            if (timeIdx == 0 && snapshotIsCurrent_ && intensiveQuantitySnapshotUpToDate_[globalIdx])
+                return &intensiveQuantitySnapshot_[globalIdx];
+
+            return 0;
+        }
+
         return &intensiveQuantityCache_[timeIdx][globalIdx];
     }
 
+    /*!
+     * \brief Return the value-only record of the fluid state of a degree of freedom at
+     *        a previous time level.
+     *
+     * If the storage term is cached, the intensive quantities of the previous time
+     * levels are not kept. If thermodynamic hints are enabled and the intensive
+     * quantities of the model define a ScalarFluidState type, the fluid states of the
+     * converged solutions are kept as value-only records instead. They can be used as
+     * the initial guess of the constraint solvers if the intensive quantities of a
+     * previous time level need to be recalculated.
+     *
+     * \attention If no record is available, this method will return 0.
+     *
+     * \param globalIdx The global space index for the entity where a
+     *                  record is requested.
+     * \param timeIdx The index used by the time discretization.
+     */
+    const ScalarFluidState* cachedFluidStateRecord(unsigned globalIdx, unsigned timeIdx) const
+    {
+        if (timeIdx == 0 || !storeFluidStateRecords_())
+            return 0;
+
+        if (!fluidStateRecordUpToDate_[timeIdx][globalIdx])
+            return 0;
+
+        return &fluidStateRecords_[timeIdx][globalIdx];
+    }
+
+    /*!
+     * \brief Return the precomputed finite volume geometry of an element.
+     *
+     * \attention If the stencil cache is disabled, this method returns 0.
+     *
+     * \param elem The grid element of interest.
+     */
+    const Stencil* cachedStencil(const Element& elem) const
+    {
+        if (stencilCache_.empty())
+            return 0;
+
+        return &stencilCache_[elementMapper_.index(elem)];
+    }
+
     /*!
      * \brief Update the intensive quantity cache for a entity on the grid at given time.
      *
@@ -747,7 +960,7 @@ public:
                                          unsigned globalIdx,
                                          unsigned timeIdx) const
     {
-        if (!storeIntensiveQuantities())
+        if (!storeIntensiveQuantities() || (timeIdx > 0 && !storeIntensiveQuantityHistory_()))
             return;
 
         intensiveQuantityCache_[timeIdx][globalIdx] = intQuants;
@@ -765,7 +978,7 @@ public:
                                                   unsigned timeIdx,
                                                   bool newValue) const
     {
-        if (!storeIntensiveQuantities())
+        if (!storeIntensiveQuantities() || (timeIdx > 0 && !storeIntensiveQuantityHistory_()))
             return;
 
         intensiveQuantityCacheUpToDate_[timeIdx][globalIdx] = newValue ? 1 : 0;
@@ -782,11 +995,19 @@ public:
             std::fill(intensiveQuantityCacheUpToDate_[timeIdx].begin(),
                       intensiveQuantityCacheUpToDate_[timeIdx].end(),
                       /*value=*/0);
+
+            if (timeIdx == 0)
+                snapshotIsCurrent_ = false;
+            else
+                std::fill(fluidStateRecordUpToDate_[timeIdx].begin(),
+                          fluidStateRecordUpToDate_[timeIdx].end(),
+                          /*value=*/0);
         }
     }
 
     void invalidateAndUpdateIntensiveQuantities(unsigned timeIdx) const
     {
+        EWOMS_TIMEBLOCK(updateIntensiveQuantities);
         invalidateIntensiveQuantitiesCache(timeIdx);
 
         // loop over all elements...
@@ -795,6 +1016,7 @@ public:
 #pragma omp parallel
 #endif
         {
+            EWOMS_TIMEBLOCK(updateIntensiveQuantitiesThread);
             ElementContext elemCtx(simulator_);
             ElementIterator elemIt = threadedElemIt.beginParallel();
             for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
@@ -818,15 +1040,18 @@ public:
         if (!storeIntensiveQuantities())
             return;
 
+        assert(numSlots > 0);
+
         if (enableStorageCache()) {
             // if the storage term is cached, the intensive quantities of the previous
             // time steps do not need to be accessed, and we can thus spare ourselves to
-            // copy the objects for the intensive quantities.
+            // copy the objects for the intensive quantities. only the value-only
+            // records of their fluid states are kept if they are used as hints.
+            if (storeFluidStateRecords_())
+                shiftFluidStateRecords_(numSlots);
             return;
         }
 
-        assert(numSlots > 0);
-
         for (unsigned timeIdx = 0; timeIdx < historySize - numSlots; ++ timeIdx) {
             intensiveQuantityCache_[timeIdx + numSlots] = intensiveQuantityCache_[timeIdx];
             intensiveQuantityCacheUpToDate_[timeIdx + numSlots] = intensiveQuantityCacheUpToDate_[timeIdx];
@@ -853,7 +1078,38 @@ public:
      * disabled will crash the program.
      */
     void setEnableStorageCache(bool enableStorageCache)
-    { enableStorageCache_= enableStorageCache; }
+    {
+        enableStorageCache_= enableStorageCache;
+
+        size_t numDof = asImp_().numGridDof();
+        if (enableStorageCache_) {
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx)
+                storageCache_[timeIdx].resize(numDof);
+        }
+
+        if (storeFluidStateRecords_()) {
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx) {
+                if (fluidStateRecords_[timeIdx].size() == numDof)
+                    continue;
+
+                fluidStateRecords_[timeIdx].resize(numDof);
+                fluidStateRecordUpToDate_[timeIdx].assign(numDof, /*value=*/0);
+            }
+        }
+
+        // without the storage cache, the intensive quantities of the previous time steps
+        // are required, but they might not have been allocated so far
+        if (storeIntensiveQuantities() && storeIntensiveQuantityHistory_()) {
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx) {
+                if (intensiveQuantityCache_[timeIdx].size() == numDof)
+                    continue;
+
+                intensiveQuantityCache_[timeIdx].resize(numDof);
+                intensiveQuantityCacheUpToDate_[timeIdx].resize(numDof);
+                invalidateIntensiveQuantitiesCache(timeIdx);
+            }
+        }
+    }
 
     /*!
      * \brief Retrieve an entry of the cache for the storage term.
@@ -862,13 +1118,28 @@ public:
      * volume unit at a given time. The user is responsible for making sure that the
      * value of this is correct and that it can be used before this method is called.
      *
+     * The storage term is only cached for the previous time levels, i.e., for time
+     * indices larger than 0. An exception is thrown for time index 0. If the
+     * StorageCacheScalar property differs from Scalar, the cached value is converted
+     * and returned by value.
+     *
      * \param globalDofIdx The index of the relevant degree of freedom in a grid-global vector
      * \param timeIdx The relevant index for the time discretization
      */
-    const EqVector& cachedStorage(unsigned globalIdx, unsigned timeIdx) const
+    decltype(auto) cachedStorage(unsigned globalIdx, unsigned timeIdx) const
     {
         assert(enableStorageCache_);
-        return storageCache_[timeIdx][globalIdx];
+        if (timeIdx == 0)
+            throw std::logic_error("The storage term is only cached for the previous time levels");
+        if constexpr (std::is_same_v<StorageCacheVector, EqVector>)
+            return static_cast<const EqVector&>(storageCache_[timeIdx][globalIdx]);
+        else {
+            const auto& cached = storageCache_[timeIdx][globalIdx];
+            EqVector result;
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                result[eqIdx] = cached[eqIdx];
+            return result;
+        }
     }
 
     /*!
@@ -876,7 +1147,8 @@ public:
      *
      * This is supposed to represent a DOF's total amount of conservation quantities per
      * volume unit at a given time. The user is responsible for making sure that the
-     * storage cache is enabled before this method is called.
+     * storage cache is enabled before this method is called. Since the storage term is
+     * only cached for the previous time levels, an exception is thrown for time index 0.
      *
      * \param globalDofIdx The index of the relevant degree of freedom in a grid-global vector
      * \param timeIdx The relevant index for the time discretization
@@ -885,7 +1157,11 @@ public:
     void updateCachedStorage(unsigned globalIdx, unsigned timeIdx, const EqVector& value) const
     {
         assert(enableStorageCache_);
-        storageCache_[timeIdx][globalIdx] = value;
+        if (timeIdx == 0)
+            throw std::logic_error("The storage term is only cached for the previous time levels");
+        auto& cached = storageCache_[timeIdx][globalIdx];
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            cached[eqIdx] = static_cast<StorageCacheScalar>(value[eqIdx]);
     }
 
     /*!
@@ -1373,9 +1649,18 @@ public:
     /*!
      * \brief Called by the update() method if it was
      *        successful.
+     *
+     * The Newton method invalidates the cached intensive quantities whenever it updates
+     * the solution, i.e., also after its last iteration. If the cache is enabled, the
+     * intensive quantities of the converged solution are thus computed once here, so
+     * that the output and the first linearization of the next time step can take them
+     * from the cache.
      */
     void updateSuccessful()
-    { }
+    {
+        if (storeIntensiveQuantities())
+            invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
+    }
 
     /*!
      * \brief Called by the update() method when the grid should be refined.
@@ -1387,6 +1672,12 @@ public:
         // adaptation is only done if markForGridAdaptation returns true
         if (enableGridAdaptation_)
         {
+            // repartition the grid if the work is distributed unevenly. this needs to
+            // happen before the elements are marked because the marks do not survive
+            // the migration of the elements.
+            if (enableDynamicLoadBalancing_ && gridView_.comm().size() > 1)
+                rebalanceGrid_();
+
             // check if problem allows for adaptation and cells were marked
             if( simulator_.problem().markForGridAdaptation() )
             {
@@ -1395,32 +1686,7 @@ public:
 
                 // if the grid has potentially changed, we need to re-create the
                 // supporting data structures.
-#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
-                elementMapper_.update(gridView_);
-                vertexMapper_.update(gridView_);
-#else
-                elementMapper_.update();
-                vertexMapper_.update();
-#endif
-                resetLinearizer();
-
-                // this is a bit hacky because it supposes that Problem::finishInit()
-                // works fine multiple times in a row.
-                //
-                // TODO: move this to Problem::gridChanged()
-                finishInit();
-
-                // notify the problem that the grid has changed
-                //
-                // TODO: come up with a mechanism to access the unadapted data structures
-                // outside of the problem (i.e., grid, mappers, solutions)
-                simulator_.problem().gridChanged();
-
-                // notify the modules for visualization output
-                auto outIt = outputModules_.begin();
-                auto outEndIt = outputModules_.end();
-                for (; outIt != outEndIt; ++outIt)
-                    (*outIt)->allocBuffers();
+                gridChanged_();
             }
         }
 #endif
@@ -1433,11 +1699,23 @@ public:
      */
     void updateFailed()
     {
+        TimerGuard rollbackTimerGuard(rollbackTimer_);
+        rollbackTimer_.start();
+        ++numFailedUpdates_;
+
         // Reset the current solution to the one of the
         // previous time step so that we can start the next
         // update at a physically meaningful solution.
         solution(/*timeIdx=*/0) = solution(/*timeIdx=*/1);
-        invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
+
+        if (enableTimeStepSnapshot_ && storeIntensiveQuantities())
+            // the intensive quantities for the solution of the last time step have been
+            // kept when the time step was started, so we do not need to recompute them.
+            restoreIntensiveQuantitiesSnapshot_();
+        else
+            invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
+
+        rollbackTimer_.stop();
 
 #ifndef NDEBUG
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
@@ -1468,6 +1746,11 @@ public:
         // shift the intensive quantities cache by one position in the
         // history
         asImp_().shiftIntensiveQuantityCache(/*numSlots=*/1);
+
+        // keep the intensive quantities of the current solution to be able to restore
+        // them if the next time integration fails
+        if (enableTimeStepSnapshot_ && storeIntensiveQuantities())
+            takeIntensiveQuantitiesSnapshot_();
     }
 
     /*!
@@ -1571,6 +1854,121 @@ public:
     size_t numTotalDof() const
     { return asImp_().numGridDof() + numAuxiliaryDof(); }
 
+    /*!
+     * \brief Returns the largest number of degrees of freedom of the stencil of an
+     *        interior element of the local process.
+     */
+    size_t maxStencilNumDof() const
+    { return maxStencilNumDof_; }
+
+    /*!
+     * \brief Returns the largest number of primary degrees of freedom of the stencil of
+     *        an interior element of the local process.
+     */
+    size_t maxStencilNumPrimaryDof() const
+    { return maxStencilNumPrimaryDof_; }
+
+    /*!
+     * \brief Returns the largest number of interior faces of the stencil of an interior
+     *        element of the local process.
+     */
+    size_t maxStencilNumInteriorFaces() const
+    { return maxStencilNumInteriorFaces_; }
+
+    /*!
+     * \brief Returns the largest number of boundary faces of the stencil of an interior
+     *        element of the local process.
+     */
+    size_t maxStencilNumBoundaryFaces() const
+    { return maxStencilNumBoundaryFaces_; }
+
+    /*!
+     * \brief Add the memory footprints of the data structures of the model.
+     *
+     * This includes the structures of the linearizer and of the linear solver if these
+     * support the memory accounting.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
+            usage.add("Solution vectors", memoryUsageOf(solution(timeIdx)));
+            usage.add("Intensive quantity cache",
+                      memoryUsageOf(intensiveQuantityCache_[timeIdx])
+                      + memoryUsageOf(intensiveQuantityCacheUpToDate_[timeIdx]));
+            usage.add("Storage cache", memoryUsageOf(storageCache_[timeIdx]));
+            usage.add("Fluid state records",
+                      memoryUsageOf(fluidStateRecords_[timeIdx])
+                      + memoryUsageOf(fluidStateRecordUpToDate_[timeIdx]));
+        }
+        usage.add("Intensive quantity cache",
+                  memoryUsageOf(intensiveQuantitySnapshot_)
+                  + memoryUsageOf(intensiveQuantitySnapshotUpToDate_));
+        usage.add("DOF volumes", memoryUsageOf(dofTotalVolume_) + memoryUsageOf(isLocalDof_));
+
+        // the stencils own some more memory for their sub-control volumes and faces
+        // which is not accounted for here
+        usage.add("Stencil cache", memoryUsageOf(stencilCache_));
+
+        Opm::addMemoryUsage(*linearizer_, usage);
+        Opm::addMemoryUsage(newtonMethod_.linearSolver(), usage);
+    }
+
+    /*!
+     * \brief Estimate the memory footprints of the data structures of the model without
+     *        allocating them.
+     *
+     * The footprints are computed from the number of degrees of freedom, the number of
+     * elements and the number of non-zero blocks of the Jacobian matrix, which is
+     * obtained by counting the couplings of the stencils. The following approximations
+     * are made:
+     *
+     * - The number of non-zero blocks is exact for element-centered discretizations. For
+     *   the vertex-centered one, it is an upper bound because couplings which are shared
+     *   by several elements are counted once for each of them. The couplings caused by
+     *   auxiliary equations are not considered.
+     * - The node sizes of standard containers are estimated and the stencil cache is
+     *   counted shallowly, like by addMemoryUsage().
+     * - The linearizer and the linear solver add their estimates only if they support
+     *   it. See their estimateMemoryUsage() methods for their approximations.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage) const
+    {
+        const std::size_t numDof = asImp_().numGridDof();
+
+        // the solution vectors are always allocated
+        for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx)
+            usage.add("Solution vectors", memoryUsageOf(solution(timeIdx)));
+
+        if (storeIntensiveQuantities()) {
+            std::size_t numSlots = storeIntensiveQuantityHistory_() ? historySize : 1;
+            if (enableTimeStepSnapshot_)
+                ++numSlots;
+            usage.add("Intensive quantity cache",
+                      numSlots*numDof*(sizeof(IntensiveQuantities) + sizeof(unsigned char)));
+        }
+        if (enableStorageCache_)
+            usage.add("Storage cache", (historySize - 1)*numDof*sizeof(StorageCacheVector));
+        if (storeFluidStateRecords_())
+            usage.add("Fluid state records",
+                      (historySize - 1)*numDof*(sizeof(ScalarFluidState) + sizeof(unsigned char)));
+        usage.add("DOF volumes", numDof*sizeof(Scalar) + numDof/8);
+        if (enableStencilCache_)
+            usage.add("Stencil cache", gridView_.size(/*codim=*/0)*sizeof(Stencil));
+
+        // count the couplings of the degrees of freedom in the same way as the
+        // linearizers create the sparsity pattern of the Jacobian matrix
+        std::size_t numNonzeros = 0;
+        Stencil stencil(gridView_, asImp_().dofMapper());
+        for (const auto& elem : elements(gridView_)) {
+            stencil.update(elem);
+            numNonzeros += stencil.numPrimaryDof()*stencil.numDof();
+        }
+
+        const std::size_t numRows = asImp_().numTotalDof();
+        Opm::estimateMemoryUsage(*linearizer_, usage, numRows, numNonzeros);
+        Opm::estimateMemoryUsage(newtonMethod_.linearSolver(), usage, numRows, numNonzeros);
+    }
+
     /*!
      * \brief Mapper to convert the Dune entities of the
      *        discretization's degrees of freedoms are to indices.
@@ -1745,6 +2143,7 @@ public:
      */
     void prepareOutputFields() const
     {
+        EWOMS_TIMEBLOCK(prepareOutputFields);
         bool needFullContextUpdate = false;
         auto modIt = outputModules_.begin();
         const auto& modEndIt = outputModules_.end();
@@ -1753,33 +2152,48 @@ public:
             needFullContextUpdate = needFullContextUpdate || (*modIt)->needExtensiveQuantities();
         }
 
-        // iterate over grid
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
+        // iterate over grid. since the amount of work per element is small if the
+        // intensive quantities can be taken from the cache, we do not hand out the
+        // elements using the lock-based ThreadedEntityIterator but statically assign
+        // the precomputed chunks of elements to the threads.
+        const int numChunks = static_cast<int>(elementChunkBegins_.size()) - 1;
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
             ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const auto& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    // ignore non-interior entities
-                    continue;
-
-                if (needFullContextUpdate)
-                    elemCtx.updateAll(elem);
-                else {
-                    elemCtx.updatePrimaryStencil(elem);
-                    elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+                const ElementIterator& chunkEndIt = elementChunkBegins_[chunkIdx + 1];
+                for (ElementIterator elemIt = elementChunkBegins_[chunkIdx]; elemIt != chunkEndIt; ++elemIt) {
+                    const Element& elem = *elemIt;
+                    if (elem.partitionType() != Dune::InteriorEntity)
+                        // ignore non-interior entities
+                        continue;
+
+                    // only the quantities of the most recent time index are written, so
+                    // we do not need to update the history. Also, the intensive
+                    // quantities of the converged solution of a time step are taken from
+                    // the cache if it is enabled (see updateSuccessful()).
+                    if (needFullContextUpdate) {
+                        elemCtx.updateStencil(elem);
+                        elemCtx.updateIntensiveQuantities(/*timeIdx=*/0);
+                        elemCtx.updateExtensiveQuantities(/*timeIdx=*/0);
+                    }
+                    else {
+                        elemCtx.updatePrimaryStencil(elem);
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                    }
+
+                    // we cannot reuse the "modIt" variable here because the code here
+                    // might be threaded and "modIt" is is the same for all threads, i.e.,
+                    // if a given thread modifies it, the changes affect all threads.
+                    auto modIt2 = outputModules_.begin();
+                    for (; modIt2 != modEndIt; ++modIt2)
+                        (*modIt2)->processElement(elemCtx);
                 }
-
-                // we cannot reuse the "modIt" variable here because the code here might
-                // be threaded and "modIt" is is the same for all threads, i.e., if a
-                // given thread modifies it, the changes affect all threads.
-                auto modIt2 = outputModules_.begin();
-                for (; modIt2 != modEndIt; ++modIt2)
-                    (*modIt2)->processElement(elemCtx);
             }
         }
     }
@@ -1897,6 +2311,22 @@ public:
     const Timer& updateTimer() const
     { return updateTimer_; }
 
+    /*!
+     * \brief Returns the timer which measures the time required to restore the state of
+     *        the last time step after failed time integrations.
+     *
+     * In contrast to the other timers of the model, this one accumulates over the whole
+     * simulation.
+     */
+    const Timer& rollbackTimer() const
+    { return rollbackTimer_; }
+
+    /*!
+     * \brief Returns the number of time integrations which failed so far.
+     */
+    unsigned numFailedUpdates() const
+    { return numFailedUpdates_; }
+
     template<class Serializer>
     void serializeOp(Serializer& serializer)
     {
@@ -1922,24 +2352,220 @@ public:
 protected:
     void resizeAndResetIntensiveQuantitiesCache_()
     {
-        // allocate the storage cache
+        if (memoryDryRun_)
+            return;
+
+        // allocate the storage cache for the previous time levels
         if (enableStorageCache()) {
             size_t numDof = asImp_().numGridDof();
-            for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx) {
                 storageCache_[timeIdx].resize(numDof);
             }
         }
 
+        // allocate the records of the fluid states of the previous time levels
+        if (storeFluidStateRecords_()) {
+            size_t numDof = asImp_().numGridDof();
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx) {
+                fluidStateRecords_[timeIdx].resize(numDof);
+                fluidStateRecordUpToDate_[timeIdx].assign(numDof, /*value=*/0);
+            }
+        }
+
         // allocate the intensive quantities cache
         if (storeIntensiveQuantities()) {
             size_t numDof = asImp_().numGridDof();
             for(unsigned timeIdx=0; timeIdx<historySize; ++timeIdx) {
+                if (timeIdx > 0 && !storeIntensiveQuantityHistory_())
+                    continue;
+
                 intensiveQuantityCache_[timeIdx].resize(numDof);
                 intensiveQuantityCacheUpToDate_[timeIdx].resize(numDof);
                 invalidateIntensiveQuantitiesCache(timeIdx);
             }
         }
+
+        // the snapshot of the last time step does not match the new grid
+        intensiveQuantitySnapshot_.clear();
+        intensiveQuantitySnapshotUpToDate_.clear();
+        snapshotIsCurrent_ = false;
+    }
+
+    // re-create the data structures which depend on the grid after it has changed
+    void gridChanged_()
+    {
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
+        elementMapper_.update(gridView_);
+        vertexMapper_.update(gridView_);
+#else
+        elementMapper_.update();
+        vertexMapper_.update();
+#endif
+        resetLinearizer();
+
+        // this is a bit hacky because it supposes that Problem::finishInit()
+        // works fine multiple times in a row.
+        //
+        // TODO: move this to Problem::gridChanged()
+        finishInit();
+
+        // notify the problem that the grid has changed
+        //
+        // TODO: come up with a mechanism to access the unadapted data structures
+        // outside of the problem (i.e., grid, mappers, solutions)
+        simulator_.problem().gridChanged();
+
+        // notify the modules for visualization output
+        auto outIt = outputModules_.begin();
+        auto outEndIt = outputModules_.end();
+        for (; outIt != outEndIt; ++outIt)
+            (*outIt)->allocBuffers();
     }
+
+#if HAVE_DUNE_FEM
+    // repartition the grid using the costs of the elements measured by the linearizer
+    // during the last time step if the imbalance of the processes is too large
+    void rebalanceGrid_()
+    {
+        const auto& elementCosts = linearizer_->elementCosts();
+        if (elementCosts.size() != static_cast<size_t>(gridView_.size(/*codim=*/0)))
+            // no costs have been measured on the current grid yet
+            return;
+
+        ElementCostBalancer<GridView, ElementMapper> balancer(gridView_, elementMapper_, elementCosts);
+        Scalar imbalance = balancer.imbalance();
+        if (imbalance <= loadBalancingImbalanceThreshold_) {
+            linearizer_->resetElementCosts();
+            return;
+        }
+
+        if (gridView_.comm().rank() == 0)
+            std::cout << "Load imbalance of the processes is " << imbalance
+                      << ", repartitioning the grid\n" << std::flush;
+
+        // the solution is migrated by the data handle of the dune-fem DOF manager. the
+        // restriction and prolongation operators register their data with it when the
+        // adaptation manager is created. the intensive quantities are re-computed from
+        // the migrated solution.
+        adaptationManager();
+        auto& grid = simulator_.vanguard().grid();
+        auto& dofManager = Dune::Fem::DofManager<Grid>::instance(grid);
+        if (balancer.repartition(grid, dofManager))
+            gridChanged_();
+        else
+            linearizer_->resetElementCosts();
+    }
+#endif
+
+    /*!
+     * \brief Keep the cached intensive quantities of the current solution.
+     *
+     * The history of the cache cannot be used for this because its entries may have
+     * been computed for a previous time index, i.e., they do not exhibit any
+     * derivatives. Since updateSuccessful() has refreshed the current slot of the
+     * cache for the converged solution, it is swapped with the snapshot buffer instead
+     * of being copied. The snapshot is then used instead of the invalidated current slot
+     * until the solution gets updated by the Newton method.
+     */
+    void takeIntensiveQuantitiesSnapshot_()
+    {
+        auto& cache = intensiveQuantityCache_[/*timeIdx=*/0];
+        auto& cacheUpToDate = intensiveQuantityCacheUpToDate_[/*timeIdx=*/0];
+
+        // the second buffer only needs to be allocated for the first time step and
+        // after the grid has changed
+        if (intensiveQuantitySnapshot_.size() != cache.size()) {
+            intensiveQuantitySnapshot_.resize(cache.size());
+            intensiveQuantitySnapshotUpToDate_.resize(cache.size());
+        }
+
+        std::swap(cache, intensiveQuantitySnapshot_);
+        std::swap(cacheUpToDate, intensiveQuantitySnapshotUpToDate_);
+
+        // the current slot now holds the intensive quantities of an older solution
+        invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+        snapshotIsCurrent_ = true;
+    }
+
+    /*!
+     * \brief Make the cached intensive quantities of the most recent time index those of
+     *        the solution of the last time step.
+     *
+     * Nothing is copied for this: the current slot of the cache is invalidated and the
+     * snapshot is used instead of it until the solution gets updated again. Entries
+     * which were not up to date when the snapshot was taken are recomputed on demand.
+     * If no snapshot is available (e.g., because the first time step failed or the grid
+     * has changed), all intensive quantities are recomputed.
+     */
+    void restoreIntensiveQuantitiesSnapshot_()
+    {
+        if (intensiveQuantitySnapshot_.size() != intensiveQuantityCache_[/*timeIdx=*/0].size()) {
+            invalidateAndUpdateIntensiveQuantities(/*timeIdx=*/0);
+            return;
+        }
+
+        invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+        snapshotIsCurrent_ = true;
+    }
+
+    /*!
+     * \brief Compute the stencils of all elements of the grid.
+     *
+     * The stencils are stored contiguously in the order of the element indices. They
+     * must not be moved after they have been updated because the stencils of some
+     * discretizations refer to the element which they store internally.
+     */
+    void updateStencilCache_()
+    {
+        stencilCache_.clear();
+
+        std::size_t numElements = gridView_.size(/*codim=*/0);
+        stencilCache_.reserve(numElements);
+        for (std::size_t elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            stencilCache_.emplace_back(gridView_, asImp_().dofMapper());
+
+        for (const auto& elem : elements(gridView_))
+            stencilCache_[elementMapper_.index(elem)].update(elem);
+    }
+
+    /*!
+     * \brief Divide the elements of the grid into contiguous chunks with the same number
+     *        of interior elements, one for each thread.
+     *
+     * Each chunk is represented by the iterator to its first element. The last entry is
+     * the end iterator of the grid view.
+     */
+    void updateElementChunks_()
+    {
+        const unsigned numChunks = ThreadManager::maxThreads();
+        std::size_t numInteriorElements = 0;
+        for (const auto& elem : elements(gridView_))
+            if (elem.partitionType() == Dune::InteriorEntity)
+                ++numInteriorElements;
+
+        elementChunkBegins_.clear();
+        elementChunkBegins_.reserve(numChunks + 1);
+        elementChunkBegins_.push_back(gridView_.template begin</*codim=*/0>());
+
+        const ElementIterator elemEndIt = gridView_.template end</*codim=*/0>();
+        std::size_t interiorElemIdx = 0;
+        unsigned chunkIdx = 1;
+        for (ElementIterator elemIt = elementChunkBegins_.front(); elemIt != elemEndIt; ++elemIt) {
+            if (elemIt->partitionType() != Dune::InteriorEntity)
+                continue;
+
+            // start the next chunk(s) at this element if the current one is full
+            while (chunkIdx < numChunks && interiorElemIdx == chunkIdx*numInteriorElements/numChunks) {
+                elementChunkBegins_.push_back(elemIt);
+                ++chunkIdx;
+            }
+            ++interiorElemIdx;
+        }
+
+        while (elementChunkBegins_.size() < numChunks + 1)
+            elementChunkBegins_.push_back(elemEndIt);
+    }
+
     template <class Context>
     void supplementInitialSolution_(PrimaryVariables&,
                                     const Context&,
@@ -1973,6 +2599,50 @@ protected:
     bool verbose_() const
     { return gridView_.comm().rank() == 0; }
 
+    // returns whether the intensive quantities of the previous time steps need to be
+    // cached. if the storage term is cached, they are never accessed.
+    bool storeIntensiveQuantityHistory_() const
+    { return !enableStorageCache_; }
+
+    // returns whether the fluid states of the previous time steps are kept as value-only
+    // records. this is only done if the intensive quantities of these time steps are
+    // not cached and the records are used as thermodynamic hints.
+    bool storeFluidStateRecords_() const
+    {
+        return haveScalarFluidState
+            && enableStorageCache_
+            && enableThermodynamicHints_
+            && enableIntensiveQuantityCache_;
+    }
+
+    // move the records of the fluid states by the given number of time levels to the
+    // back and record the fluid states of the current solution
+    void shiftFluidStateRecords_(unsigned numSlots)
+    {
+        for (unsigned timeIdx = historySize - 1; timeIdx > numSlots; -- timeIdx) {
+            fluidStateRecords_[timeIdx] = fluidStateRecords_[timeIdx - numSlots];
+            fluidStateRecordUpToDate_[timeIdx] = fluidStateRecordUpToDate_[timeIdx - numSlots];
+        }
+        for (unsigned timeIdx = 1; timeIdx < numSlots && timeIdx < historySize; ++ timeIdx)
+            std::fill(fluidStateRecordUpToDate_[timeIdx].begin(),
+                      fluidStateRecordUpToDate_[timeIdx].end(),
+                      /*value=*/0);
+
+        if (numSlots >= historySize)
+            return;
+
+        if constexpr (haveScalarFluidState) {
+            auto& records = fluidStateRecords_[numSlots];
+            auto& upToDate = fluidStateRecordUpToDate_[numSlots];
+            for (unsigned globalIdx = 0; globalIdx < records.size(); ++globalIdx) {
+                const auto* intQuants = cachedIntensiveQuantities(globalIdx, /*timeIdx=*/0);
+                upToDate[globalIdx] = intQuants ? 1 : 0;
+                if (intQuants)
+                    records[globalIdx].assign(intQuants->fluidState());
+            }
+        }
+    }
+
     Implementation& asImp_()
     { return *static_cast<Implementation*>(this); }
     const Implementation& asImp_() const
@@ -1998,6 +2668,8 @@ protected:
     Timer linearizeTimer_;
     Timer solveTimer_;
     Timer updateTimer_;
+    Timer rollbackTimer_;
+    unsigned numFailedUpdates_{0};
 
     // calculates the local jacobian matrix for a given element
     std::vector<LocalLinearizer> localLinearizer_;
@@ -2009,7 +2681,16 @@ protected:
     // solution of the previous time step
     mutable IntensiveQuantitiesVector intensiveQuantityCache_[historySize];
     // while these are logically bools, concurrent writes to vector<bool> are not thread safe.
-    mutable std::vector<unsigned char> intensiveQuantityCacheUpToDate_[historySize];
+    mutable std::vector<unsigned char, DofAllocator<unsigned char> > intensiveQuantityCacheUpToDate_[historySize];
+
+    // the cached intensive quantities of the solution of the last time step including
+    // their derivatives. only used if time step snapshots are enabled. this is the
+    // second buffer of the current slot of the cache.
+    IntensiveQuantitiesVector intensiveQuantitySnapshot_;
+    std::vector<unsigned char, DofAllocator<unsigned char> > intensiveQuantitySnapshotUpToDate_;
+    // specifies whether the snapshot corresponds to the current solution, i.e., whether
+    // the solution has not been updated since the snapshot was taken or restored
+    mutable bool snapshotIsCurrent_{false};
 
     DiscreteFunctionSpace space_;
     mutable std::array< std::unique_ptr< DiscreteFunction >, historySize > solution_;
@@ -2023,15 +2704,36 @@ protected:
     std::list<BaseOutputModule<TypeTag>*> outputModules_;
 
     Scalar gridTotalVolume_;
-    std::vector<Scalar> dofTotalVolume_;
+    size_t maxStencilNumDof_{0};
+    size_t maxStencilNumPrimaryDof_{0};
+    size_t maxStencilNumInteriorFaces_{0};
+    size_t maxStencilNumBoundaryFaces_{0};
+    std::vector<Scalar, DofAllocator<Scalar> > dofTotalVolume_;
     std::vector<bool> isLocalDof_;
 
-    mutable GlobalEqVector storageCache_[historySize];
+    mutable StorageCache storageCache_[historySize];
+
+    // value-only records of the fluid states of the previous time levels. only used if
+    // the intensive quantities of these time levels are not cached, see
+    // storeFluidStateRecords_(). the slot for time index 0 is never allocated.
+    ScalarFluidStateVector fluidStateRecords_[historySize];
+    std::vector<unsigned char, DofAllocator<unsigned char> > fluidStateRecordUpToDate_[historySize];
 
     bool enableGridAdaptation_;
+    bool enableDynamicLoadBalancing_;
+    Scalar loadBalancingImbalanceThreshold_;
     bool enableIntensiveQuantityCache_;
     bool enableStorageCache_;
     bool enableThermodynamicHints_;
+    bool enableTimeStepSnapshot_;
+    bool enableStencilCache_;
+    bool memoryDryRun_;
+
+    std::vector<Stencil> stencilCache_;
+
+    // the iterators to the first elements of the chunks which are processed by the
+    // threads, see updateElementChunks_()
+    std::vector<ElementIterator> elementChunkBegins_;
 };
 } // namespace Opm
 
@@ -92,12 +92,24 @@ public:
     explicit FvBaseElementContext(const Simulator& simulator)
         : gridView_(simulator.gridView())
         , stencil_(gridView_, simulator.model().dofMapper() )
+        , stencilPtr_(&stencil_)
     {
         // remember the simulator object
         simulatorPtr_ = &simulator;
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
         stashedDofIdx_ = -1;
         focusDofIdx_ = -1;
+
+        // allocate the scratch space for the largest stencil of the grid up front. since
+        // the arrays never shrink, the element loops do not need to allocate any memory
+        // or to construct quantities if the size of the stencils varies. (the model
+        // only knows the size of the largest stencil after it has been initialized.)
+        const auto& model = simulator.model();
+        stencil_.reserve(model.maxStencilNumDof(),
+                         model.maxStencilNumInteriorFaces(),
+                         model.maxStencilNumBoundaryFaces());
+        dofVars_.resize(model.maxStencilNumDof());
+        extensiveQuantities_.resize(model.maxStencilNumInteriorFaces());
     }
 
     static void *operator new(size_t size)
@@ -131,14 +143,20 @@ public:
         // remember the current element
         elemPtr_ = &elem;
 
-        // update the stencil. the center gradients are quite expensive to calculate and
-        // most models don't need them, so that we only do this if the model explicitly
-        // enables them
-        stencil_.update(elem);
+        // use the precomputed stencil of the element if the model provides one. if
+        // not, update the stencil. the center gradients are quite expensive to
+        // calculate and most models don't need them, so that we only do this if the
+        // model explicitly enables them
+        if (!bindCachedStencil_(elem)) {
+            stencil_.update(elem);
+            stencilPtr_ = &stencil_;
+        }
 
-        // resize the arrays containing the flux and the volume variables
-        dofVars_.resize(stencil_.numDof());
-        extensiveQuantities_.resize(stencil_.numInteriorFaces());
+        // grow the arrays containing the flux and the volume variables if necessary
+        if (dofVars_.size() < stencilPtr_->numDof())
+            dofVars_.resize(stencilPtr_->numDof());
+        if (extensiveQuantities_.size() < stencilPtr_->numInteriorFaces())
+            extensiveQuantities_.resize(stencilPtr_->numInteriorFaces());
     }
 
     /*!
@@ -153,9 +171,13 @@ public:
         elemPtr_ = &elem;
 
         // update the finite element geometry
-        stencil_.updatePrimaryTopology(elem);
+        if (!bindCachedStencil_(elem)) {
+            stencil_.updatePrimaryTopology(elem);
+            stencilPtr_ = &stencil_;
+        }
 
-        dofVars_.resize(stencil_.numPrimaryDof());
+        if (dofVars_.size() < stencilPtr_->numPrimaryDof())
+            dofVars_.resize(stencilPtr_->numPrimaryDof());
     }
 
     /*!
@@ -170,7 +192,10 @@ public:
         elemPtr_ = &elem;
 
         // update the finite element geometry
-        stencil_.updateTopology(elem);
+        if (!bindCachedStencil_(elem)) {
+            stencil_.updateTopology(elem);
+            stencilPtr_ = &stencil_;
+        }
     }
 
     /*!
@@ -337,7 +362,7 @@ public:
      *                time discretization.
      */
     const Stencil& stencil(unsigned) const
-    { return stencil_; }
+    { return *stencilPtr_; }
 
     /*!
      * \brief Return the position of a local entities in global coordinates
@@ -348,7 +373,7 @@ public:
      *                time discretization.
      */
     decltype(auto) pos(unsigned dofIdx, unsigned) const
-    { return stencil_.subControlVolume(dofIdx).globalPos(); }
+    { return stencilPtr_->subControlVolume(dofIdx).globalPos(); }
 
     /*!
      * \brief Return the global spatial index for a sub-control volume
@@ -582,6 +607,18 @@ protected:
         dofVars_[dofIdx].intensiveQuantities[timeIdx].update(/*context=*/asImp_(), dofIdx, timeIdx);
     }
 
+    // use the stencil precomputed by the model for an element. returns false if the
+    // model does not cache stencils.
+    bool bindCachedStencil_(const Element& elem)
+    {
+        const Stencil* cachedStencil = model().cachedStencil(elem);
+        if (!cachedStencil)
+            return false;
+
+        stencilPtr_ = cachedStencil;
+        return true;
+    }
+
     IntensiveQuantities intensiveQuantitiesStashed_;
     PrimaryVariables priVarsStashed_;
 
@@ -594,6 +631,7 @@ protected:
     const Element *elemPtr_;
     const GridView gridView_;
     Stencil stencil_;
+    const Stencil* stencilPtr_;
 
     int stashedDofIdx_;
     int focusDofIdx_;
@@ -41,6 +41,7 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
 #include <limits>
 
 namespace Opm {
@@ -62,6 +63,8 @@ template<class TypeTag, class MyTypeTag>
 struct NumericDifferenceMethod { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct BaseEpsilon { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct EnableCompressedFiniteDifferences { using type = UndefinedProperty; };
 
 // set the properties to be spliced in
 template<class TypeTag>
@@ -90,6 +93,16 @@ struct BaseEpsilon<TypeTag, TTag::FiniteDifferenceLocalLinearizer>
     static constexpr type value = std::max<type>(0.9123e-10, std::numeric_limits<type>::epsilon()*1.23e3);
 };
 
+/*!
+ * \brief Specify whether the storage terms of the degrees of freedom which are not
+ *        deflected should be reused when evaluating the deflected residuals.
+ *
+ * The source terms are only reused as well if the LocalSourceTerms property is set. This
+ * has no effect if the storage term depends on the extensive quantities.
+ */
+template<class TypeTag>
+struct EnableCompressedFiniteDifferences<TypeTag, TTag::FiniteDifferenceLocalLinearizer> { static constexpr bool value = false; };
+
 } // namespace Opm::Properties
 
 namespace Opm {
@@ -156,6 +169,8 @@ private:
 
     using LocalEvalBlockVector = typename LocalResidual::LocalEvalBlockVector;
 
+    static constexpr bool canReuseVolumeTerms = LocalResidual::volumeTermsAreLocal();
+
 #if __GNUC__ == 4 && __GNUC_MINOR__ <= 6
 public:
     // make older GCCs happy by providing a public copy constructor (this is necessary
@@ -185,6 +200,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, NumericDifferenceMethod,
                              "The method used for numeric differentiation (-1: backward "
                              "differences, 0: central differences, 1: forward differences)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableCompressedFiniteDifferences,
+                             "Only recalculate the storage term of the deflected degree of "
+                             "freedom when evaluating the partial derivatives");
     }
 
     /*!
@@ -200,6 +218,17 @@ public:
         simulatorPtr_ = &simulator;
         delete internalElemContext_;
         internalElemContext_ = new ElementContext(simulator);
+
+        // allocate the storage for the largest stencil of the grid up front
+        const auto& model = simulator.model();
+        residual_.reserve(model.maxStencilNumDof());
+        derivResidual_.reserve(model.maxStencilNumDof());
+        backwardResidual_.reserve(model.maxStencilNumDof());
+        volumeTerms_.reserve(model.maxStencilNumDof());
+        jacobian_.setSize(model.maxStencilNumDof(), model.maxStencilNumPrimaryDof());
+
+        reuseVolumeTerms_ =
+            canReuseVolumeTerms && EWOMS_GET_PARAM(TypeTag, bool, EnableCompressedFiniteDifferences);
     }
 
     /*!
@@ -242,8 +271,12 @@ public:
         resize_(elemCtx);
         reset_(elemCtx);
 
-        // calculate the local residual
-        localResidual_.eval(residual_, elemCtx);
+        // calculate the local residual. if the volume terms are reused, they are computed
+        // separately, so that they are available for the deflected residuals.
+        if (reuseVolumeTerms_)
+            evalResidual_(residual_, elemCtx, /*deflectedDofIdx=*/-1);
+        else
+            localResidual_.eval(residual_, elemCtx);
 
         // calculate the local jacobian matrix
         size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
@@ -347,7 +380,12 @@ protected:
         size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
 
         residual_.resize(numDof);
-        jacobian_.setSize(numDof, numPrimaryDof);
+
+        // the Jacobian only grows: shrinking a Dune::Matrix releases its rows, which
+        // would then need to be allocated again for the next larger element
+        if (jacobian_.N() < numDof || jacobian_.M() < numPrimaryDof)
+            jacobian_.setSize(std::max(jacobian_.N(), numDof),
+                              std::max(jacobian_.M(), numPrimaryDof));
 
         derivResidual_.resize(numDof);
     }
@@ -432,7 +470,7 @@ protected:
             // calculate the deflected residual
             elemCtx.updateIntensiveQuantities(priVars, dofIdx, /*timeIdx=*/0);
             elemCtx.updateAllExtensiveQuantities();
-            localResidual_.eval(derivResidual_, elemCtx);
+            evalResidual_(derivResidual_, elemCtx, static_cast<int>(dofIdx));
         }
         else {
             // we are using backward differences, i.e. we don't need
@@ -449,13 +487,14 @@ protected:
             priVars[pvIdx] -= delta + eps;
             delta += eps;
 
-            // calculate the deflected residual again, this time we use the local
-            // residual's internal storage.
+            // calculate the deflected residual again, this time we use a separate
+            // buffer.
             elemCtx.updateIntensiveQuantities(priVars, dofIdx, /*timeIdx=*/0);
             elemCtx.updateAllExtensiveQuantities();
-            localResidual_.eval(elemCtx);
+            backwardResidual_.resize(derivResidual_.size());
+            evalResidual_(backwardResidual_, elemCtx, static_cast<int>(dofIdx));
 
-            derivResidual_ -= localResidual_.residual();
+            derivResidual_ -= backwardResidual_;
         }
         else {
             // we are using forward differences, i.e. we don't need to
@@ -480,6 +519,31 @@ protected:
 #endif
     }
 
+    /*!
+     * \brief Evaluate the local residual.
+     *
+     * If the volume terms are reused, only the ones of the degree of freedom
+     * 'deflectedDofIdx' are recalculated (see FvBaseLocalResidual::evalWithVolumeTerms()).
+     * If 'deflectedDofIdx' is -1, the reusable volume terms of all degrees of freedom
+     * are calculated and stored.
+     */
+    void evalResidual_(LocalEvalBlockVector& residual,
+                       ElementContext& elemCtx,
+                       int deflectedDofIdx)
+    {
+        if constexpr (canReuseVolumeTerms) {
+            if (reuseVolumeTerms_) {
+                if (deflectedDofIdx < 0)
+                    localResidual_.evalVolumeTerms(volumeTerms_, elemCtx);
+
+                localResidual_.evalWithVolumeTerms(residual, elemCtx, volumeTerms_, deflectedDofIdx);
+                return;
+            }
+        }
+
+        localResidual_.eval(residual, elemCtx);
+    }
+
     /*!
      * \brief Updates the current local Jacobian matrix with the partial derivatives of
      *        all equations for primary variable 'pvIdx' at the degree of freedom
@@ -509,8 +573,12 @@ protected:
 
     LocalEvalBlockVector residual_;
     LocalEvalBlockVector derivResidual_;
+    LocalEvalBlockVector backwardResidual_;
+    LocalEvalBlockVector volumeTerms_;
     ScalarLocalBlockMatrix jacobian_;
 
+    bool reuseVolumeTerms_{false};
+
     LocalResidual localResidual_;
 };
 
@@ -38,11 +38,16 @@
 #include <opm/models/parallel/threadmanager.hh>
 #include <opm/models/parallel/threadedentityiterator.hh>
 #include <opm/models/discretization/common/baseauxiliarymodule.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/parametersystem.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <dune/common/version.hh>
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <type_traits>
 #include <iostream>
 #include <vector>
@@ -144,6 +149,8 @@ public:
     void init(Simulator& simulator)
     {
         simulatorPtr_ = &simulator;
+        measureElementCosts_ = EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing);
+        elementCosts_.clear();
         eraseMatrix();
         auto it = elementCtx_.begin();
         const auto& endIt = elementCtx_.end();
@@ -191,37 +198,18 @@ public:
      * represented by the model object.
      */
     void linearizeDomain()
-    {
-        // we defer the initialization of the Jacobian matrix until here because the
-        // auxiliary modules usually assume the problem, model and grid to be fully
-        // initialized...
-        if (!jacobian_)
-            initFirstIteration_();
+    { linearizeDomain_</*assembleJacobian=*/true>(); }
 
-        int succeeded;
-        try {
-            linearize_();
-            succeeded = 1;
-        }
-        catch (const std::exception& e)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing:" << e.what()
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-        catch (...)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing"
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-        succeeded = gridView_().comm().min(succeeded);
-
-        if (!succeeded)
-            throw NumericalProblem("A process did not succeed in linearizing the system");
-    }
+    /*!
+     * \brief Evaluate the residual of the spatial domain without touching the Jacobian
+     *        matrix.
+     *
+     * The residual is computed by the same local residual and for the same elements as
+     * by linearizeDomain(), so it can be used in combination with a Jacobian matrix
+     * which was assembled during an earlier iteration.
+     */
+    void linearizeResidual()
+    { linearizeDomain_</*assembleJacobian=*/false>(); }
 
     void finalize()
     { jacobian_->finalize(); }
@@ -232,6 +220,7 @@ public:
      */
     void linearizeAuxiliaryEquations()
     {
+        EWOMS_TIMEBLOCK(linearizeAuxiliaryEquations);
         // flush possible local caches into matrix structure
         jacobian_->commit();
 
@@ -296,6 +285,22 @@ public:
     const std::map<unsigned, Constraints>& constraintsMap() const
     { return constraintsMap_; }
 
+    /*!
+     * \brief Returns the computational costs of all elements.
+     *
+     * The costs are the wall clock time in seconds spent to linearize each element,
+     * accumulated since the last call to resetElementCosts(). This object is only
+     * non-empty if the EnableDynamicLoadBalancing parameter is true.
+     */
+    const std::vector<double>& elementCosts() const
+    { return elementCosts_; }
+
+    /*!
+     * \brief Start accumulating the costs of the elements from zero.
+     */
+    void resetElementCosts()
+    { std::fill(elementCosts_.begin(), elementCosts_.end(), 0.0); }
+
     /*!
      * \brief Return constant reference to the flowsInfo.
      *
@@ -312,6 +317,37 @@ public:
     const auto& getFloresInfo() const
     {return floresInfo_;}
 
+    /*!
+     * \brief Add the memory footprints of the linearized system.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        if (jacobian_)
+            usage.add("Jacobian matrix", memoryUsageOf(jacobian_->istlMatrix()));
+        usage.add("Residual", memoryUsageOf(residual_));
+        usage.add("Linearizer", memoryUsageOf(constraintsMap_) + memoryUsageOf(elementCosts_));
+        usage.add("Flows and flores", memoryUsageOf(flowsInfo_) + memoryUsageOf(floresInfo_));
+    }
+
+    /*!
+     * \brief Estimate the memory footprints of the linearized system without allocating
+     *        it.
+     *
+     * \param numRows The number of block rows of the Jacobian matrix
+     * \param numNonzeros The number of non-zero blocks of the Jacobian matrix
+     *
+     * The constraints as well as the flows and flores are not considered because their
+     * sizes depend on the problem.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage, std::size_t numRows, std::size_t numNonzeros) const
+    {
+        using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;
+        usage.add("Jacobian matrix", estimatedMemoryUsageOfMatrix<IstlMatrix>(numRows, numNonzeros));
+        usage.add("Residual", numRows*sizeof(typename GlobalEqVector::block_type));
+        if (measureElementCosts_)
+            usage.add("Linearizer", gridView_().size(/*codim=*/0)*sizeof(double));
+    }
+
 private:
     Simulator& simulator_()
     { return *simulatorPtr_; }
@@ -443,10 +479,51 @@ private:
         }
     }
 
-    // linearize the whole system
+    template <bool assembleJacobian>
+    void linearizeDomain_()
+    {
+        EWOMS_TIMEBLOCK(linearizeDomain);
+        // we defer the initialization of the Jacobian matrix until here because the
+        // auxiliary modules usually assume the problem, model and grid to be fully
+        // initialized...
+        if (!jacobian_)
+            initFirstIteration_();
+
+        int succeeded;
+        try {
+            linearize_<assembleJacobian>();
+            succeeded = 1;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing:" << e.what()
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+        catch (...)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing"
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+        succeeded = gridView_().comm().min(succeeded);
+
+        if (!succeeded)
+            throw NumericalProblem("A process did not succeed in linearizing the system");
+    }
+
+    // linearize the whole system. if assembleJacobian is false, only the residual is
+    // evaluated and the Jacobian matrix is left alone.
+    template <bool assembleJacobian>
     void linearize_()
     {
-        resetSystem_();
+        EWOMS_TIMEBLOCK(linearize);
+        if constexpr (assembleJacobian)
+            resetSystem_();
+        else
+            residual_ = 0.0;
 
         // before the first iteration of each time step, we need to update the
         // constraints. (i.e., we assume that constraints can be time dependent, but they
@@ -456,6 +533,9 @@ private:
 
         applyConstraintsToSolution_();
 
+        if (measureElementCosts_)
+            elementCosts_.resize(gridView_().size(/*codim=*/0), 0.0);
+
         // to avoid a race condition if two threads handle an exception at the same time,
         // we use an explicit lock to control access to the exception storage object
         // amongst thread-local handlers
@@ -471,6 +551,7 @@ private:
 #pragma omp parallel
 #endif
         {
+            EWOMS_TIMEBLOCK(linearizeElements);
             ElementIterator elemIt = threadedElemIt.beginParallel();
             ElementIterator nextElemIt = elemIt;
             try {
@@ -492,7 +573,15 @@ private:
                     if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
                         continue;
 
-                    linearizeElement_(elem);
+                    if (assembleJacobian && measureElementCosts_) {
+                        auto startTime = std::chrono::steady_clock::now();
+                        linearizeElement_<assembleJacobian>(elem);
+                        std::chrono::duration<double> duration =
+                            std::chrono::steady_clock::now() - startTime;
+                        elementCosts_[elementMapper_().index(elem)] += duration.count();
+                    }
+                    else
+                        linearizeElement_<assembleJacobian>(elem);
                 }
             }
             // If an exception occurs in the parallel block, it won't escape the
@@ -518,10 +607,11 @@ private:
             std::rethrow_exception(exceptionPtr);
         }
 
-        applyConstraintsToLinearization_();
+        applyConstraintsToLinearization_<assembleJacobian>();
     }
 
     // linearize an element in the interior of the process' grid partition
+    template <bool assembleJacobian>
     void linearizeElement_(const Element& elem)
     {
         unsigned threadId = ThreadManager::threadId();
@@ -529,8 +619,14 @@ private:
         ElementContext *elementCtx = elementCtx_[threadId];
         auto& localLinearizer = model_().localLinearizer(threadId);
 
-        // the actual work of linearization is done by the local linearizer class
-        localLinearizer.linearize(*elementCtx, elem);
+        // the actual work of linearization is done by the local linearizer class. if
+        // only the residual is requested, the local residual is evaluated directly.
+        if constexpr (assembleJacobian)
+            localLinearizer.linearize(*elementCtx, elem);
+        else {
+            elementCtx->updateAll(elem);
+            localLinearizer.localResidual().eval(*elementCtx);
+        }
 
         // update the right hand side and the Jacobian matrix
         if (getPropValue<TypeTag, Properties::UseLinearizationLock>())
@@ -540,14 +636,21 @@ private:
         for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
             unsigned globI = elementCtx->globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
 
-            // update the right hand side
-            residual_[globI] += localLinearizer.residual(primaryDofIdx);
+            if constexpr (assembleJacobian) {
+                // update the right hand side
+                residual_[globI] += localLinearizer.residual(primaryDofIdx);
 
-            // update the global Jacobian matrix
-            for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
-                unsigned globJ = elementCtx->globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+                // update the global Jacobian matrix
+                for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
+                    unsigned globJ = elementCtx->globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
 
-                jacobian_->addToBlock(globJ, globI, localLinearizer.jacobian(dofIdx, primaryDofIdx));
+                    jacobian_->addToBlock(globJ, globI, localLinearizer.jacobian(dofIdx, primaryDofIdx));
+                }
+            }
+            else {
+                const auto& localResid = localLinearizer.localResidual().residual(primaryDofIdx);
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                    residual_[globI][eqIdx] += Toolbox::value(localResid[eqIdx]);
             }
         }
 
@@ -576,6 +679,7 @@ private:
 
     // apply the constraints to the linearization. (i.e., for constrain degrees of
     // freedom the Jacobian matrix maps to identity and the residual is zero)
+    template <bool assembleJacobian = true>
     void applyConstraintsToLinearization_()
     {
         if (!enableConstraints_())
@@ -588,7 +692,8 @@ private:
 
             // reset the column of the Jacobian matrix
             // put an identity matrix on the main diagonal of the Jacobian
-            jacobian_->clearRow(constraintDofIdx, Scalar(1.0));
+            if constexpr (assembleJacobian)
+                jacobian_->clearRow(constraintDofIdx, Scalar(1.0));
 
             // make the right-hand side of constraint DOFs zero
             residual_[constraintDofIdx] = 0.0;
@@ -623,6 +728,10 @@ private:
 
     LinearizationType linearizationType_;
 
+    // the measured computational costs of the elements
+    bool measureElementCosts_{false};
+    std::vector<double> elementCosts_;
+
     std::mutex globalMatrixMutex_;
 };
 
@@ -76,6 +76,7 @@ private:
 
     enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
     enum { extensiveStorageTerm = getPropValue<TypeTag, Properties::ExtensiveStorageTerm>() };
+    enum { localSourceTerms = getPropValue<TypeTag, Properties::LocalSourceTerms>() };
 
     using Toolbox = MathToolbox<Evaluation>;
     using EvalVector = Dune::FieldVector<Evaluation, numEq>;
@@ -171,23 +172,85 @@ public:
         // evaluate the boundary conditions
         asImp_().evalBoundary_(residual, elemCtx, /*timeIdx=*/0);
 
-        if (useVolumetricResidual) {
-            // make the residual volume specific (i.e., make it incorrect mass per cubic
-            // meter instead of total mass)
-            size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
-            for (unsigned dofIdx=0; dofIdx < numDof; ++dofIdx) {
-                if (elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0) > 0.0) {
-                    // interior DOF
-                    Scalar dofVolume = elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0);
+        if (useVolumetricResidual)
+            makeVolumetric_(residual, elemCtx);
+    }
 
-                    assert(std::isfinite(dofVolume));
-                    Valgrind::CheckDefined(dofVolume);
+    /*!
+     * \brief Returns true if evalWithVolumeTerms() can be used, i.e., if the storage
+     *        term of a degree of freedom only depends on its own intensive quantities.
+     */
+    static constexpr bool volumeTermsAreLocal()
+    { return !extensiveStorageTerm; }
 
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                        residual[dofIdx][eqIdx] /= dofVolume;
-                }
+    /*!
+     * \brief Compute the volume terms of all primary degrees of freedom which can be
+     *        reused by evalWithVolumeTerms().
+     *
+     * These are the storage terms and, if the LocalSourceTerms property is set, the
+     * source terms.
+     *
+     * \copydetails Doxygen::ecfvElemCtxParam
+     */
+    void evalVolumeTerms(LocalEvalBlockVector& volumeTerms,
+                         ElementContext& elemCtx) const
+    {
+        volumeTerms.resize(elemCtx.numDof(/*timeIdx=*/0));
+        volumeTerms = 0.0;
+
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+            asImp_().evalDofStorageTerm_(volumeTerms, elemCtx, dofIdx);
+            if (localSourceTerms)
+                asImp_().evalDofSourceTerm_(volumeTerms, elemCtx, dofIdx);
+        }
+    }
+
+    /*!
+     * \brief Compute the local residual if the intensive quantities of at most a single
+     *        degree of freedom have changed since the volume terms were computed.
+     *
+     * The storage terms of all degrees of freedom except 'changedDofIdx' are taken
+     * from 'volumeTerms' instead of being recalculated, which requires
+     * volumeTermsAreLocal() to be true. The source terms are recalculated for all
+     * degrees of freedom because they may depend on the intensive quantities of other
+     * ones (e.g., for wells) unless the LocalSourceTerms property is set.
+     *
+     * \param residual The resulting local residual
+     * \param elemCtx The element context
+     * \param volumeTerms The result of evalVolumeTerms()
+     * \param changedDofIdx The local index of the degree of freedom for which the volume
+     *                      terms need to be recalculated or -1 if there is none
+     */
+    void evalWithVolumeTerms(LocalEvalBlockVector& residual,
+                             ElementContext& elemCtx,
+                             const LocalEvalBlockVector& volumeTerms,
+                             int changedDofIdx) const
+    {
+        static_assert(volumeTermsAreLocal(),
+                      "The volume terms can only be reused if the storage term does "
+                      "not depend on the extensive quantities");
+        assert(residual.size() == elemCtx.numDof(/*timeIdx=*/0));
+
+        residual = 0.0;
+
+        asImp_().evalFluxes(residual, elemCtx, /*timeIdx=*/0);
+
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+            if (static_cast<int>(dofIdx) == changedDofIdx)
+                asImp_().evalDofVolumeTerms_(residual, elemCtx, dofIdx);
+            else {
+                residual[dofIdx] += volumeTerms[dofIdx];
+                if (!localSourceTerms)
+                    asImp_().evalDofSourceTerm_(residual, elemCtx, dofIdx);
             }
         }
+
+        asImp_().evalBoundary_(residual, elemCtx, /*timeIdx=*/0);
+
+        if (useVolumetricResidual)
+            makeVolumetric_(residual, elemCtx);
     }
 
     /*!
@@ -490,139 +553,203 @@ protected:
      */
     void evalVolumeTerms_(LocalEvalBlockVector& residual,
                           ElementContext& elemCtx) const
+    {
+        // evaluate the volumetric terms (storage + source terms)
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        for (unsigned dofIdx=0; dofIdx < numPrimaryDof; dofIdx++)
+            evalDofVolumeTerms_(residual, elemCtx, dofIdx);
+
+#if !defined NDEBUG
+        // in debug mode, ensure that the residual is well-defined
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        for (unsigned i=0; i < numDof; i++) {
+            for (unsigned j = 0; j < numEq; ++ j) {
+                assert(isfinite(residual[i][j]));
+                Valgrind::CheckDefined(residual[i][j]);
+            }
+        }
+#endif
+    }
+
+    /*!
+     * \brief Add the change in the storage terms and the source term
+     *        to the local residual of a single sub-control volume.
+     */
+    void evalDofVolumeTerms_(LocalEvalBlockVector& residual,
+                             ElementContext& elemCtx,
+                             unsigned dofIdx) const
+    {
+        asImp_().evalDofStorageTerm_(residual, elemCtx, dofIdx);
+        asImp_().evalDofSourceTerm_(residual, elemCtx, dofIdx);
+    }
+
+    /*!
+     * \brief Returns the volume of a sub-control volume including its extrusion factor.
+     */
+    Scalar scvVolume_(const ElementContext& elemCtx, unsigned dofIdx) const
+    {
+        Scalar extrusionFactor =
+            elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).extrusionFactor();
+        Valgrind::CheckDefined(extrusionFactor);
+        assert(isfinite(extrusionFactor));
+        assert(extrusionFactor > 0.0);
+        Scalar scvVolume =
+           elemCtx.stencil(/*timeIdx=*/0).subControlVolume(dofIdx).volume() * extrusionFactor;
+        Valgrind::CheckDefined(scvVolume);
+        assert(isfinite(scvVolume));
+        assert(scvVolume > 0.0);
+
+        return scvVolume;
+    }
+
+    /*!
+     * \brief Add the change in the storage terms to the local residual of a single
+     *        sub-control volume.
+     */
+    void evalDofStorageTerm_(LocalEvalBlockVector& residual,
+                             ElementContext& elemCtx,
+                             unsigned dofIdx) const
     {
         EvalVector tmp;
         EqVector tmp2;
-        RateVector sourceRate;
 
         tmp = 0.0;
         tmp2 = 0.0;
 
-        // evaluate the volumetric terms (storage + source terms)
-        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
-        for (unsigned dofIdx=0; dofIdx < numPrimaryDof; dofIdx++) {
-            Scalar extrusionFactor =
-                elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).extrusionFactor();
-            Valgrind::CheckDefined(extrusionFactor);
-            assert(isfinite(extrusionFactor));
-            assert(extrusionFactor > 0.0);
-            Scalar scvVolume =
-               elemCtx.stencil(/*timeIdx=*/0).subControlVolume(dofIdx).volume() * extrusionFactor;
-            Valgrind::CheckDefined(scvVolume);
-            assert(isfinite(scvVolume));
-            assert(scvVolume > 0.0);
-
-            // if the model uses extensive quantities in its storage term, and we use
-            // automatic differention and current DOF is also not the one we currently
-            // focus on, the storage term does not need any derivatives!
-            if (!extensiveStorageTerm &&
-                !std::is_same<Scalar, Evaluation>::value &&
-                dofIdx != elemCtx.focusDofIndex())
-            {
-                asImp_().computeStorage(tmp2, elemCtx, dofIdx, /*timeIdx=*/0);
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                    tmp[eqIdx] = tmp2[eqIdx];
-            }
-            else
-                asImp_().computeStorage(tmp, elemCtx, dofIdx, /*timeIdx=*/0);
+        Scalar scvVolume = scvVolume_(elemCtx, dofIdx);
 
-#ifndef NDEBUG
-            Valgrind::CheckDefined(tmp);
+        // if the model uses extensive quantities in its storage term, and we use
+        // automatic differention and current DOF is also not the one we currently
+        // focus on, the storage term does not need any derivatives!
+        if (!extensiveStorageTerm &&
+            !std::is_same<Scalar, Evaluation>::value &&
+            dofIdx != elemCtx.focusDofIndex())
+        {
+            asImp_().computeStorage(tmp2, elemCtx, dofIdx, /*timeIdx=*/0);
             for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                assert(isfinite(tmp[eqIdx]));
+                tmp[eqIdx] = tmp2[eqIdx];
+        }
+        else
+            asImp_().computeStorage(tmp, elemCtx, dofIdx, /*timeIdx=*/0);
+
+#ifndef NDEBUG
+        Valgrind::CheckDefined(tmp);
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            assert(isfinite(tmp[eqIdx]));
 #endif
 
-            if (elemCtx.enableStorageCache()) {
-                const auto& model = elemCtx.model();
-                unsigned globalDofIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
-                if (model.newtonMethod().numIterations() == 0 &&
-                    !elemCtx.haveStashedIntensiveQuantities())
-                {
-                    if (!elemCtx.problem().recycleFirstIterationStorage()) {
-                        // we re-calculate the storage term for the solution of the
-                        // previous time step from scratch instead of using the one of
-                        // the first iteration of the current time step.
-                        tmp2 = 0.0;
-                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/1);
-                        asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
-                    }
-                    else {
-                        // if the storage term is cached and we're in the first iteration
-                        // of the time step, use the storage term of the first iteration
-                        // as the one as the solution of the last time step (this assumes
-                        // that the initial guess for the solution at the end of the time
-                        // step is the same as the solution at the beginning of the time
-                        // step. This is usually true, but some fancy preprocessing
-                        // scheme might invalidate that assumption.)
-                        for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                            tmp2[eqIdx] = Toolbox::value(tmp[eqIdx]);
-                    }
-
-                    Valgrind::CheckDefined(tmp2);
-
-                    model.updateCachedStorage(globalDofIdx, /*timeIdx=*/1, tmp2);
+        if (elemCtx.enableStorageCache()) {
+            const auto& model = elemCtx.model();
+            unsigned globalDofIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+            if (model.newtonMethod().numIterations() == 0 &&
+                !elemCtx.haveStashedIntensiveQuantities())
+            {
+                if (!elemCtx.problem().recycleFirstIterationStorage()) {
+                    // we re-calculate the storage term for the solution of the
+                    // previous time step from scratch instead of using the one of
+                    // the first iteration of the current time step.
+                    tmp2 = 0.0;
+                    elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/1);
+                    asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
                 }
                 else {
-                    // if the mass storage at the beginning of the time step is not cached,
-                    // if the storage term is cached and we're not looking at the first
-                    // iteration of the time step, we take the cached data.
-                    tmp2 = model.cachedStorage(globalDofIdx, /*timeIdx=*/1);
-                    Valgrind::CheckDefined(tmp2);
+                    // if the storage term is cached and we're in the first iteration
+                    // of the time step, use the storage term of the first iteration
+                    // as the one as the solution of the last time step (this assumes
+                    // that the initial guess for the solution at the end of the time
+                    // step is the same as the solution at the beginning of the time
+                    // step. This is usually true, but some fancy preprocessing
+                    // scheme might invalidate that assumption.)
+                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                        tmp2[eqIdx] = Toolbox::value(tmp[eqIdx]);
                 }
+
+                Valgrind::CheckDefined(tmp2);
+
+                model.updateCachedStorage(globalDofIdx, /*timeIdx=*/1, tmp2);
             }
             else {
                 // if the mass storage at the beginning of the time step is not cached,
-                // we re-calculate it from scratch.
-                tmp2 = 0.0;
-                asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
+                // if the storage term is cached and we're not looking at the first
+                // iteration of the time step, we take the cached data.
+                tmp2 = model.cachedStorage(globalDofIdx, /*timeIdx=*/1);
                 Valgrind::CheckDefined(tmp2);
             }
+        }
+        else {
+            // if the mass storage at the beginning of the time step is not cached,
+            // we re-calculate it from scratch.
+            tmp2 = 0.0;
+            asImp_().computeStorage(tmp2, elemCtx,  dofIdx, /*timeIdx=*/1);
+            Valgrind::CheckDefined(tmp2);
+        }
 
-            // Use the implicit Euler time discretization
-            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-                double dt = elemCtx.simulator().timeStepSize();
-                assert(dt > 0);
-                tmp[eqIdx] -= tmp2[eqIdx];
-                tmp[eqIdx] *= scvVolume / dt;
+        // Use the implicit Euler time discretization
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            double dt = elemCtx.simulator().timeStepSize();
+            assert(dt > 0);
+            tmp[eqIdx] -= tmp2[eqIdx];
+            tmp[eqIdx] *= scvVolume / dt;
 
-                residual[dofIdx][eqIdx] += tmp[eqIdx];
-            }
+            residual[dofIdx][eqIdx] += tmp[eqIdx];
+        }
+
+        Valgrind::CheckDefined(residual[dofIdx]);
+    }
 
-            Valgrind::CheckDefined(residual[dofIdx]);
+    /*!
+     * \brief Add the source term to the local residual of a single sub-control volume.
+     */
+    void evalDofSourceTerm_(LocalEvalBlockVector& residual,
+                            ElementContext& elemCtx,
+                            unsigned dofIdx) const
+    {
+        RateVector sourceRate;
+        Scalar scvVolume = scvVolume_(elemCtx, dofIdx);
 
-            // deal with the source term
-            asImp_().computeSource(sourceRate, elemCtx, dofIdx, /*timeIdx=*/0);
+        asImp_().computeSource(sourceRate, elemCtx, dofIdx, /*timeIdx=*/0);
 
-            // if the model uses extensive quantities in its storage term, and we use
-            // automatic differention and current DOF is also not the one we currently
-            // focus on, the storage term does not need any derivatives!
-            if (!extensiveStorageTerm &&
-                !std::is_same<Scalar, Evaluation>::value &&
-                dofIdx != elemCtx.focusDofIndex())
-            {
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                    residual[dofIdx][eqIdx] -= scalarValue(sourceRate[eqIdx])*scvVolume;
-            }
-            else {
-                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-                    sourceRate[eqIdx] *= scvVolume;
-                    residual[dofIdx][eqIdx] -= sourceRate[eqIdx];
-                }
+        // if the model uses extensive quantities in its storage term, and we use
+        // automatic differention and current DOF is also not the one we currently
+        // focus on, the storage term does not need any derivatives!
+        if (!extensiveStorageTerm &&
+            !std::is_same<Scalar, Evaluation>::value &&
+            dofIdx != elemCtx.focusDofIndex())
+        {
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                residual[dofIdx][eqIdx] -= scalarValue(sourceRate[eqIdx])*scvVolume;
+        }
+        else {
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                sourceRate[eqIdx] *= scvVolume;
+                residual[dofIdx][eqIdx] -= sourceRate[eqIdx];
             }
-
-            Valgrind::CheckDefined(residual[dofIdx]);
         }
 
-#if !defined NDEBUG
-        // in debug mode, ensure that the residual is well-defined
+        Valgrind::CheckDefined(residual[dofIdx]);
+    }
+
+    /*!
+     * \brief Divide the residual of all degrees of freedom by their total volume.
+     */
+    void makeVolumetric_(LocalEvalBlockVector& residual,
+                         const ElementContext& elemCtx) const
+    {
+        // make the residual volume specific (i.e., make it incorrect mass per cubic
+        // meter instead of total mass)
         size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
-        for (unsigned i=0; i < numDof; i++) {
-            for (unsigned j = 0; j < numEq; ++ j) {
-                assert(isfinite(residual[i][j]));
-                Valgrind::CheckDefined(residual[i][j]);
+        for (unsigned dofIdx=0; dofIdx < numDof; ++dofIdx) {
+            if (elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0) > 0.0) {
+                // interior DOF
+                Scalar dofVolume = elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0);
+
+                assert(std::isfinite(dofVolume));
+                Valgrind::CheckDefined(dofVolume);
+
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                    residual[dofIdx][eqIdx] /= dofVolume;
             }
         }
-#endif
     }
 
 
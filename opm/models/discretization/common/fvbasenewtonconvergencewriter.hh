@@ -28,6 +28,7 @@
 #ifndef EWOMS_FV_BASE_NEWTON_CONVERGENCE_WRITER_HH
 #define EWOMS_FV_BASE_NEWTON_CONVERGENCE_WRITER_HH
 
+#include <opm/models/discretization/common/renumberedmapper.hh>
 #include <opm/models/io/vtkmultiwriter.hh>
 #include <opm/models/utils/propertysystem.hh>
 
@@ -97,12 +98,17 @@ public:
     void beginIteration()
     {
         ++ iteration_;
-        if (!vtkMultiWriter_)
+        if (!vtkMultiWriter_) {
             vtkMultiWriter_ =
                 new VtkMultiWriter(/*async=*/false,
                                    newtonMethod_.problem().gridView(),
                                    newtonMethod_.problem().outputDir(),
                                    "convergence");
+
+            const auto& model = newtonMethod_.problem().model();
+            vtkMultiWriter_->setPermutations(mapperPermutation(model.elementMapper()),
+                                             mapperPermutation(model.vertexMapper()));
+        }
         vtkMultiWriter_->beginWrite(timeStepIdx_ + iteration_ / 100.0);
     }
 
@@ -128,13 +128,9 @@ protected:
         ParentType::update_(nextSolution, currentSolution, solutionUpdate, currentResidual);
 
         // make sure that the intensive quantities get recalculated at the next
-        // linearization
-        if (model_().storeIntensiveQuantities()) {
-            for (unsigned dofIdx = 0; dofIdx < model_().numGridDof(); ++dofIdx)
-                model_().setIntensiveQuantitiesCacheEntryValidity(dofIdx,
-                                                                  /*timeIdx=*/0,
-                                                                  /*valid=*/false);
-        }
+        // linearization. this also stops the model from using the snapshot of the last
+        // time step.
+        model_().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
     }
 
     /*!
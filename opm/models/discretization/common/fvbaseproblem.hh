@@ -32,12 +32,19 @@
 
 #include <opm/models/io/vtkmultiwriter.hh>
 #include <opm/models/io/restart.hh>
+#include <opm/models/io/runrecord.hh>
+#include <opm/models/discretization/common/renumberedmapper.hh>
 #include <opm/models/discretization/common/restrictprolong.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/profiler.hh>
+#include <opm/models/utils/timestepcontroller.hh>
 
 #include <dune/common/fvector.hh>
 
+#include <cstddef>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <string>
 
 #include <sys/stat.h>
@@ -122,6 +129,13 @@ public:
         , simulator_(simulator)
         , defaultVtkWriter_(0)
     {
+        timeStepController_ =
+            TimeStepController<Scalar>::create(EWOMS_GET_PARAM(TypeTag, std::string, TimeStepControl),
+                                               EWOMS_GET_PARAM(TypeTag, unsigned, TimeStepFailureMemory),
+                                               EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepFailureSafetyFactor),
+                                               EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlTargetChange),
+                                               EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowth));
+
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
         const VertexIterator vEndIt = gridView_.template end<dim>();
@@ -155,6 +169,12 @@ public:
 
             defaultVtkWriter_ =
                 new VtkMultiWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name());
+
+            // the output buffers are indexed by the mappers of the model, which may
+            // renumber the entities of the grid
+            const auto& model = simulator.model();
+            defaultVtkWriter_->setPermutations(mapperPermutation(model.elementMapper()),
+                                               mapperPermutation(model.vertexMapper()));
         }
     }
 
@@ -181,6 +201,24 @@ public:
                              "Continue with a non-converged solution instead of giving up "
                              "if we encounter a time step size smaller than the minimum time "
                              "step size.");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TimeStepControl,
+                             "The strategy to select the size of the next time step. Valid "
+                             "values are 'iteration-count', 'pid' and 'pid+iteration-count'");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlTargetChange,
+                             "The targeted maximum relative change of the solution per time "
+                             "step for the PID time step control");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowth,
+                             "The maximum factor by which the PID time step control increases "
+                             "the time step size");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, TimeStepFailureMemory,
+                             "The number of successful time steps for which the size of a failed "
+                             "time step limits the size of the next ones. 0 disables this");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepFailureSafetyFactor,
+                             "The fraction of the size of a recently failed time step to which "
+                             "the time step size is limited");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, RunRecordFile,
+                             "The file to which a summary of the performance of the simulation "
+                             "is written in the JSON format. If empty, no run record is written");
     }
 
     /*!
@@ -466,6 +504,7 @@ public:
 
         Scalar executionTime = executionTimer.realTimeElapsed();
         Scalar setupTime = simulator().setupTimer().realTimeElapsed();
+        Scalar vanguardTime = simulator().vanguardTimer().realTimeElapsed();
         Scalar prePostProcessTime = simulator().prePostProcessTimer().realTimeElapsed();
         Scalar localCpuTime = executionTimer.cpuTimeElapsed();
         Scalar globalCpuTime = executionTimer.globalCpuTimeElapsed();
@@ -473,6 +512,9 @@ public:
         Scalar linearizeTime = simulator().linearizeTimer().realTimeElapsed();
         Scalar solveTime = simulator().solveTimer().realTimeElapsed();
         Scalar updateTime = simulator().updateTimer().realTimeElapsed();
+        Scalar rollbackTime = model().rollbackTimer().realTimeElapsed();
+        unsigned numFailedUpdates = model().numFailedUpdates();
+        std::size_t numLinearIterations = model().newtonMethod().numLinearIterations();
         unsigned numProcesses = static_cast<unsigned>(this->gridView().comm().size());
         unsigned threadsPerProcess = ThreadManager::maxThreads();
         if (gridView().comm().rank() == 0) {
@@ -482,16 +524,24 @@ public:
                       << "------------------------ Timing ------------------------\n"
                       << "Setup time: " << setupTime << " seconds" << Simulator::humanReadableTime(setupTime)
                       << ", " << setupTime/(executionTime + setupTime)*100 << "%\n"
+                      << "    Grid creation time: " << vanguardTime << " seconds" << Simulator::humanReadableTime(vanguardTime)
+                      << ", " << vanguardTime/setupTime*100 << "%\n"
                       << "Simulation time: " << executionTime << " seconds" << Simulator::humanReadableTime(executionTime)
                       << ", " << executionTime/(executionTime + setupTime)*100 << "%\n"
                       << "    Linearization time: " << linearizeTime << " seconds" << Simulator::humanReadableTime(linearizeTime)
                       << ", " << linearizeTime/executionTime*100 << "%\n"
                       << "    Linear solve time: "  << solveTime << " seconds" << Simulator::humanReadableTime(solveTime)
                       << ", " << solveTime/executionTime*100 << "%\n"
+                      << "        Linear solver iterations: " << numLinearIterations << "\n"
                       << "    Newton update time: "  << updateTime << " seconds" << Simulator::humanReadableTime(updateTime)
                       << ", " << updateTime/executionTime*100 << "%\n"
                       << "    Pre/postprocess time: "  << prePostProcessTime << " seconds" << Simulator::humanReadableTime(prePostProcessTime)
                       << ", " << prePostProcessTime/executionTime*100 << "%\n"
+                      << "        Failed time step rollback time: "  << rollbackTime << " seconds" << Simulator::humanReadableTime(rollbackTime)
+                      << ", " << numFailedUpdates << " failed time steps\n"
+                      << "    Time step control: " << timeStepController_->name()
+                      << ", " << timeStepController_->numSucceeded() << " successful and "
+                      << timeStepController_->numFailed() << " failed time steps\n"
                       << "    Output write time: "  << writeTime << " seconds" << Simulator::humanReadableTime(writeTime)
                       << ", " << writeTime/executionTime*100 << "%\n"
                       << "First process' simulation CPU time: "  << localCpuTime << " seconds" <<  Simulator::humanReadableTime(localCpuTime) << "\n"
@@ -502,6 +552,46 @@ public:
                       << "----------------------------------------------------------------\n"
                       << std::endl;
         }
+
+        printMemoryUsage();
+
+        std::string runRecordFile = EWOMS_GET_PARAM(TypeTag, std::string, RunRecordFile);
+        if (!runRecordFile.empty())
+            writeRunRecord_(runRecordFile);
+
+        model().finalize();
+    }
+
+    /*!
+     * \brief Print the memory footprints of the major data structures of the simulation
+     *        and the peak memory usage of the processes.
+     *
+     * This is a collective operation, i.e., it must be called by all processes.
+     */
+    void printMemoryUsage() const
+    {
+        MemoryUsage usage;
+        model().addMemoryUsage(usage);
+        if (defaultVtkWriter_)
+            usage.add("VTK output buffers (peak)", defaultVtkWriter_->peakManagedBufferSize());
+
+        printMemoryUsage_(usage, "------------------------ Memory ------------------------");
+    }
+
+    /*!
+     * \brief Print the estimated memory footprints of the major data structures of the
+     *        simulation and the peak memory usage of the processes.
+     *
+     * In contrast to printMemoryUsage(), the caches and the linear system do not need to
+     * be allocated. The VTK output buffers are not considered. This is a collective
+     * operation, i.e., it must be called by all processes.
+     */
+    void printMemoryEstimate() const
+    {
+        MemoryUsage usage;
+        model().estimateMemoryUsage(usage);
+
+        printMemoryUsage_(usage, "------------------- Memory (estimated) -----------------");
     }
 
     /*!
@@ -510,16 +600,23 @@ public:
      */
     void timeIntegration()
     {
+        EWOMS_TIMEBLOCK(timeIntegration);
         unsigned maxFails = asImp_().maxTimeIntegrationFailures();
         Scalar minTimeStepSize = asImp_().minTimeStepSize();
 
         std::string errorMessage;
         for (unsigned i = 0; i < maxFails; ++i) {
             bool converged = model().update();
-            if (converged)
+            if (converged) {
+                Scalar solutionChange = 0.0;
+                if (timeStepController_->needsSolutionChange())
+                    solutionChange = solutionChange_();
+                timeStepController_->registerSuccess(simulator().timeStepSize(), solutionChange);
                 return;
+            }
 
             Scalar dt = simulator().timeStepSize();
+            timeStepController_->registerFailure(dt);
             Scalar nextDt = dt / 2.0;
             if (dt < minTimeStepSize*(1 + 1e-9)) {
                 if (asImp_().continueOnConvergenceError()) {
@@ -555,6 +652,12 @@ public:
         throw std::runtime_error(errorMessage);
     }
 
+    /*!
+     * \brief Returns the object which selects the size of the next time step.
+     */
+    const TimeStepController<Scalar>& timeStepController() const
+    { return *timeStepController_; }
+
     /*!
      * \brief Returns the minimum allowable size of a time step.
      */
@@ -592,8 +695,10 @@ public:
         if (nextTimeStepSize_ > 0.0)
             return nextTimeStepSize_;
 
+        Scalar dt = simulator().timeStepSize();
+        Scalar iterationDt = newtonMethod().suggestTimeStepSize(dt);
         Scalar dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize),
-                                 newtonMethod().suggestTimeStepSize(simulator().timeStepSize()));
+                                 timeStepController_->suggestTimeStepSize(dt, iterationDt));
 
         if (dtNext < simulator().maxTimeStepSize()
             && simulator().maxTimeStepSize() < dtNext*2)
@@ -782,6 +887,7 @@ public:
      */
     void writeOutput(bool verbose = true)
     {
+        EWOMS_TIMEBLOCK(writeOutput);
         if (!enableVtkOutput_())
             return;
 
@@ -808,11 +914,88 @@ public:
 
 protected:
     Scalar nextTimeStepSize_;
+    std::unique_ptr<TimeStepController<Scalar>> timeStepController_;
 
 private:
+    // print the footprints of a memory usage object and the peak resident set size of
+    // the processes below a title line
+    void printMemoryUsage_(const MemoryUsage& usage, const std::string& title) const
+    {
+        const auto& comm = gridView().comm();
+        double peakRss = static_cast<double>(RunRecord::peakResidentSetSize());
+        double maxPeakRss = comm.max(peakRss);
+        double totalPeakRss = comm.sum(peakRss);
+
+        if (comm.rank() == 0)
+            std::cout << title << "\n";
+        usage.print(std::cout, comm);
+        if (comm.rank() == 0)
+            std::cout << "Peak resident set size: "
+                      << MemoryUsage::humanReadableBytes(maxPeakRss) << " per process, "
+                      << MemoryUsage::humanReadableBytes(totalPeakRss) << " total\n"
+                      << "\n"
+                      << "----------------------------------------------------------------\n"
+                      << std::endl;
+    }
+
     bool enableVtkOutput_() const
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput); }
 
+    // write the timers and the iteration counts of the simulation to a file. the peak
+    // memory usage is the maximum of all processes and the CPU time is their sum.
+    void writeRunRecord_(const std::string& fileName) const
+    {
+        // these are collective operations
+        const auto& comm = gridView().comm();
+        double peakRss = comm.max(static_cast<double>(RunRecord::peakResidentSetSize()));
+        double cpuTime = simulator().executionTimer().globalCpuTimeElapsed();
+        if (comm.rank() != 0)
+            return;
+
+        const auto& newtonMethod = model().newtonMethod();
+        RunRecord record(asImp_().name());
+        record.add("processes", comm.size());
+        record.add("threadsPerProcess", ThreadManager::maxThreads());
+        record.add("setupTime", simulator().setupTimer().realTimeElapsed());
+        record.add("gridCreationTime", simulator().vanguardTimer().realTimeElapsed());
+        record.add("simulationTime", simulator().executionTimer().realTimeElapsed());
+        record.add("linearizeTime", simulator().linearizeTimer().realTimeElapsed());
+        record.add("solveTime", simulator().solveTimer().realTimeElapsed());
+        record.add("updateTime", simulator().updateTimer().realTimeElapsed());
+        record.add("prePostProcessTime", simulator().prePostProcessTimer().realTimeElapsed());
+        record.add("rollbackTime", model().rollbackTimer().realTimeElapsed());
+        record.add("writeTime", simulator().writeTimer().realTimeElapsed());
+        record.add("cpuTime", cpuTime);
+        record.add("timeSteps", timeStepController_->numSucceeded());
+        record.add("failedTimeSteps", timeStepController_->numFailed());
+        record.add("newtonIterations", newtonMethod.numTotalIterations());
+        record.add("linearIterations", newtonMethod.numLinearIterations());
+        record.add("peakRss", peakRss);
+        record.write(fileName);
+    }
+
+    // returns the maximum relative change of the primary variables over the time step
+    // which was just integrated. the primary variables are weighted in the same way as
+    // for the convergence criterion of the Newton method, i.e., large quantities like
+    // pressures are considered relative to their value while saturations and mole
+    // fractions are considered in absolute terms.
+    Scalar solutionChange_() const
+    {
+        const auto& curSol = model().solution(/*timeIdx=*/0);
+        const auto& oldSol = model().solution(/*timeIdx=*/1);
+
+        Scalar result = 0.0;
+        for (unsigned dofIdx = 0; dofIdx < model().numGridDof(); ++dofIdx) {
+            // ignore the DOFs in the overlap
+            if (model().dofTotalVolume(dofIdx) <= 0.0)
+                continue;
+
+            result = std::max(result, model().relativeDofError(dofIdx, oldSol[dofIdx], curSol[dofIdx]));
+        }
+
+        return gridView().comm().max(result);
+    }
+
     //! Returns the implementation of the problem (i.e. static polymorphism)
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -207,6 +207,21 @@ struct UseLinearizationLock { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct EnableGridAdaptation { using type = UndefinedProperty; };
 
+/*!
+ * \brief Switch to enable or disable the repartitioning of the grid based on the
+ *        measured computational costs of the elements
+ *
+ * The grid is repartitioned before it is adapted if the costs of the processes are
+ * distributed unevenly. This requires grid adaptation to be enabled.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableDynamicLoadBalancing { using type = UndefinedProperty; };
+
+//! The ratio between the largest and the mean computational costs of the processes
+//! above which the grid is repartitioned
+template<class TypeTag, class MyTypeTag>
+struct LoadBalancingImbalanceThreshold { using type = UndefinedProperty; };
+
 /*!
  * \brief The directory to which simulation output ought to be written to.
  */
@@ -222,6 +237,15 @@ struct OutputDir { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct EnableVtkOutput { using type = UndefinedProperty; };
 
+/*!
+ * \brief The file to which a summary of the performance of the simulation is written
+ *        at its end.
+ *
+ * If this is empty, no such run record is written.
+ */
+template<class TypeTag, class MyTypeTag>
+struct RunRecordFile { using type = UndefinedProperty; };
+
 /*!
  * \brief Determines if the VTK output is written to disk asynchronously
  *
@@ -273,6 +297,42 @@ struct MinTimeStepSize { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct MaxTimeStepDivisions { using type = UndefinedProperty; };
 
+/*!
+ * \brief The strategy used to select the size of the next time step.
+ *
+ * Valid values are "iteration-count", "pid" and "pid+iteration-count".
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepControl { using type = UndefinedProperty; };
+
+/*!
+ * \brief The targeted maximum relative change of the solution per time step for the
+ *        PID time step control.
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepControlTargetChange { using type = UndefinedProperty; };
+
+/*!
+ * \brief The maximum factor by which the PID time step control increases the time step
+ *        size.
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepControlMaxGrowth { using type = UndefinedProperty; };
+
+/*!
+ * \brief The number of successful time steps for which the size of the most recently
+ *        failed time step limits the size of the next ones.
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepFailureMemory { using type = UndefinedProperty; };
+
+/*!
+ * \brief The fraction of the size of a recently failed time step to which the time step
+ *        size is limited.
+ */
+template<class TypeTag, class MyTypeTag>
+struct TimeStepFailureSafetyFactor { using type = UndefinedProperty; };
+
 /*!
  * \brief Continue with a non-converged solution instead of giving up
  *        if we encounter a time step size smaller than the minimum time
@@ -296,12 +356,50 @@ struct EnableIntensiveQuantityCache { using type = UndefinedProperty; };
 /*!
  * \brief Specify whether the storage terms for previous solutions should be cached.
  *
- * This potentially reduces the CPU time, but comes at the cost of higher memory
- * consumption.
+ * If this is enabled, the previous time levels are represented by value-only records of
+ * their storage terms, i.e., the intensive quantities of the previous solutions are
+ * neither recomputed nor cached. This reduces both, the CPU time and the memory
+ * required by the cache for the intensive quantities. If thermodynamic hints are used,
+ * the fluid states of the previous solutions are kept as value-only records which
+ * serve as hints instead of their intensive quantities.
  */
 template<class TypeTag, class MyTypeTag>
 struct EnableStorageCache { using type = UndefinedProperty; };
 
+/*!
+ * \brief The type used to store the storage terms of previous solutions if the storage
+ *        cache is enabled.
+ *
+ * Using a type which is less precise than Scalar (e.g., float) reduces the memory and
+ * the memory bandwidth required by the storage cache at the cost of the accuracy of the
+ * accumulation term. For float, the relative rounding error of each cached storage
+ * term is bounded by half the machine epsilon of float, i.e., about 6e-8.
+ */
+template<class TypeTag, class MyTypeTag>
+struct StorageCacheScalar { using type = UndefinedProperty; };
+
+/*!
+ * \brief Specify whether the intensive quantities of the last converged solution should
+ *        be kept in order to restore them if a time step fails.
+ *
+ * This only has an effect if the cache for the intensive quantities is used. It
+ * requires a second buffer for the current slot of the intensive quantity cache, which
+ * is swapped with it after each time step, but it avoids recomputing the intensive
+ * quantities of the whole grid if the time step size needs to be reduced.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableTimeStepSnapshot { using type = UndefinedProperty; };
+
+/*!
+ * \brief Specify whether the finite volume geometry of all elements should be computed
+ *        once and be kept in memory.
+ *
+ * This avoids recomputing the stencil each time an element is visited, but it
+ * requires a copy of the stencil for each element of the grid.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableStencilCache { using type = UndefinedProperty; };
+
 /*!
  * \brief Specify whether to use the already calculated solutions as
  *        starting values of the intensive quantities.
@@ -347,6 +445,17 @@ struct TimeDiscHistorySize { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct ExtensiveStorageTerm { using type = UndefinedProperty; };
 
+/*!
+ * \brief Specify whether the source term of a degree of freedom only depends on its own
+ *        intensive quantities.
+ *
+ * This allows the finite difference linearizer to reuse the source terms of the degrees
+ * of freedom which are not deflected. Problems whose sources couple several degrees of
+ * freedom (e.g., wells) must not set this.
+ */
+template<class TypeTag, class MyTypeTag>
+struct LocalSourceTerms { using type = UndefinedProperty; };
+
 //! \brief Specify whether to use volumetric residuals or not
 template<class TypeTag, class MyTypeTag>
 struct UseVolumetricResidual { using type = UndefinedProperty; };
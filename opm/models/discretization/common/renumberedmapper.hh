@@ -0,0 +1,426 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::RenumberedMapper
+ */
+#ifndef EWOMS_RENUMBERED_MAPPER_HH
+#define EWOMS_RENUMBERED_MAPPER_HH
+
+#include <dune/common/fvector.hh>
+#include <dune/common/version.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/common/rangegenerators.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief The orderings of the degrees of freedom provided by the RenumberedMapper.
+ */
+enum class DofOrdering {
+    //! The ordering of the grid
+    Natural,
+
+    //! Reverse Cuthill-McKee ordering of the connectivity graph
+    ReverseCuthillMcKee,
+
+    //! Ordering of the centers of the entities along a Hilbert curve
+    Hilbert,
+
+    //! Ordering of the centers of the entities along a Morton (Z-order) curve
+    Morton
+};
+
+/*!
+ * \brief A mapper for the entities of a single codimension which renumbers them to
+ *        improve the locality of memory accesses.
+ *
+ * The grid's mappers often number the entities in an order which is unrelated to their
+ * spatial position, e.g., for unstructured grids or corner point grids with inactive
+ * cells. Since the degrees of freedom of the discretizations are numbered by a mapper,
+ * this order is inherited by the solution vectors, the caches and the rows of the
+ * Jacobian matrix. This mapper applies a permutation to the indices of the grid's
+ * mapper so that neighboring entities are likely to get similar indices.
+ *
+ * The mapper can be used as a drop-in replacement of the mappers of the grid, e.g.:
+ *
+ * \code
+ * template<class TypeTag>
+ * struct ElementMapper<TypeTag, TTag::YourTypeTag>
+ * {
+ *     using type = Opm::RenumberedMapper<GetPropType<TypeTag, Properties::GridView>,
+ *                                        Opm::DofOrdering::ReverseCuthillMcKee>;
+ * };
+ * \endcode
+ *
+ * Only layouts for either the elements or the vertices of the grid are supported. The
+ * permutation is applied to the indices of the mapper specified by the BaseMapper
+ * template parameter, which must provide the same interface as the grid's mappers.
+ */
+template <class GridView,
+          DofOrdering ordering,
+          class BaseMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView> >
+class RenumberedMapper
+{
+    using Element = typename GridView::template Codim<0>::Entity;
+
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+    using GlobalPosition = Dune::FieldVector<typename GridView::ctype, dimWorld>;
+
+public:
+    using Index = typename BaseMapper::Index;
+
+    RenumberedMapper(const GridView& gridView, const Dune::MCMGLayout& layout)
+        : gridView_(gridView)
+        , baseMapper_(gridView, layout)
+    { renumber_(); }
+
+    /*!
+     * \brief Map an entity to its renumbered index.
+     */
+    template <class EntityType>
+    Index index(const EntityType& e) const
+    { return permutation_[baseMapper_.index(e)]; }
+
+    /*!
+     * \brief Map a sub-entity of an element to its renumbered index.
+     */
+    Index subIndex(const Element& e, int i, unsigned int codim) const
+    {
+        assert(static_cast<int>(codim) == codim_);
+        return permutation_[baseMapper_.subIndex(e, i, codim)];
+    }
+
+    /*!
+     * \brief Returns the total number of entities which are mapped.
+     */
+    auto size() const
+    { return baseMapper_.size(); }
+
+    /*!
+     * \brief Re-create the mapping after the grid has changed.
+     */
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
+    void update(const GridView& gridView)
+    {
+        gridView_ = gridView;
+        baseMapper_.update(gridView);
+        renumber_();
+    }
+#else
+    void update()
+    {
+        baseMapper_.update();
+        renumber_();
+    }
+#endif
+
+    /*!
+     * \brief Returns the new index for each index of the base mapper.
+     */
+    const std::vector<Index>& permutation() const
+    { return permutation_; }
+
+    /*!
+     * \brief Returns the bandwidth of the connectivity graph for the ordering of the
+     *        base mapper.
+     */
+    std::size_t naturalBandwidth() const
+    { return naturalBandwidth_; }
+
+    /*!
+     * \brief Returns the bandwidth of the connectivity graph after renumbering.
+     *
+     * For the element centered discretization, this is the bandwidth of the Jacobian
+     * matrix.
+     */
+    std::size_t bandwidth() const
+    { return bandwidth_; }
+
+private:
+    void renumber_()
+    {
+        std::size_t numEntities = baseMapper_.size();
+        if (numEntities == static_cast<std::size_t>(gridView_.size(/*codim=*/0)))
+            codim_ = 0;
+        else if (numEntities == static_cast<std::size_t>(gridView_.size(/*codim=*/dim)))
+            codim_ = dim;
+        else
+            throw std::logic_error("The RenumberedMapper only supports layouts for either "
+                                   "the elements or the vertices of the grid");
+
+        std::vector<std::vector<Index>> neighbors = connectivity_();
+
+        std::vector<Index> order;
+        switch (ordering) {
+        case DofOrdering::Natural:
+            order.resize(numEntities);
+            std::iota(order.begin(), order.end(), Index(0));
+            break;
+        case DofOrdering::ReverseCuthillMcKee:
+            order = reverseCuthillMcKee_(neighbors);
+            break;
+        case DofOrdering::Hilbert:
+        case DofOrdering::Morton:
+            order = spaceFillingCurve_();
+            break;
+        }
+
+        // order contains the old index of each new one, the mapper needs the inverse
+        permutation_.resize(numEntities);
+        for (std::size_t newIdx = 0; newIdx < numEntities; ++newIdx)
+            permutation_[order[newIdx]] = static_cast<Index>(newIdx);
+
+        naturalBandwidth_ = 0;
+        bandwidth_ = 0;
+        for (std::size_t idx = 0; idx < numEntities; ++idx) {
+            for (Index neighborIdx : neighbors[idx]) {
+                std::size_t naturalDist = idx > neighborIdx ? idx - neighborIdx : neighborIdx - idx;
+                std::size_t dist = permutation_[idx] > permutation_[neighborIdx]
+                    ? permutation_[idx] - permutation_[neighborIdx]
+                    : permutation_[neighborIdx] - permutation_[idx];
+                naturalBandwidth_ = std::max(naturalBandwidth_, naturalDist);
+                bandwidth_ = std::max(bandwidth_, dist);
+            }
+        }
+    }
+
+    // returns the indices of the base mapper of the entities which are coupled with
+    // each entity. elements are coupled via their intersections, vertices if they
+    // belong to the same element.
+    std::vector<std::vector<Index>> connectivity_() const
+    {
+        std::vector<std::vector<Index>> neighbors(baseMapper_.size());
+        for (const auto& elem : elements(gridView_)) {
+            if (codim_ == 0) {
+                Index elemIdx = baseMapper_.index(elem);
+                for (const auto& intersection : intersections(gridView_, elem))
+                    if (intersection.neighbor())
+                        neighbors[elemIdx].push_back(baseMapper_.index(intersection.outside()));
+            }
+            else {
+                int numVertices = static_cast<int>(elem.subEntities(dim));
+                for (int i = 0; i < numVertices; ++i) {
+                    Index vertexIdx = baseMapper_.subIndex(elem, i, dim);
+                    for (int j = 0; j < numVertices; ++j)
+                        if (i != j)
+                            neighbors[vertexIdx].push_back(baseMapper_.subIndex(elem, j, dim));
+                }
+            }
+        }
+
+        for (auto& entityNeighbors : neighbors) {
+            std::sort(entityNeighbors.begin(), entityNeighbors.end());
+            entityNeighbors.erase(std::unique(entityNeighbors.begin(), entityNeighbors.end()),
+                                  entityNeighbors.end());
+        }
+
+        return neighbors;
+    }
+
+    std::vector<Index> reverseCuthillMcKee_(const std::vector<std::vector<Index>>& neighbors) const
+    {
+        std::size_t numEntities = neighbors.size();
+
+        // start each connected component at one of the entities with the fewest
+        // neighbors, which are usually located at the boundary of the domain
+        std::vector<Index> candidates(numEntities);
+        std::iota(candidates.begin(), candidates.end(), Index(0));
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&neighbors](Index a, Index b)
+                         { return neighbors[a].size() < neighbors[b].size(); });
+
+        std::vector<Index> order;
+        order.reserve(numEntities);
+        std::vector<bool> visited(numEntities, false);
+        std::vector<Index> newNeighbors;
+        for (Index startIdx : candidates) {
+            if (visited[startIdx])
+                continue;
+
+            std::queue<Index> queue;
+            queue.push(startIdx);
+            visited[startIdx] = true;
+            while (!queue.empty()) {
+                Index idx = queue.front();
+                queue.pop();
+                order.push_back(idx);
+
+                // visit the neighbors in the order of increasing degree
+                newNeighbors.clear();
+                for (Index neighborIdx : neighbors[idx])
+                    if (!visited[neighborIdx])
+                        newNeighbors.push_back(neighborIdx);
+                std::stable_sort(newNeighbors.begin(), newNeighbors.end(),
+                                 [&neighbors](Index a, Index b)
+                                 { return neighbors[a].size() < neighbors[b].size(); });
+                for (Index neighborIdx : newNeighbors) {
+                    visited[neighborIdx] = true;
+                    queue.push(neighborIdx);
+                }
+            }
+        }
+
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    std::vector<Index> spaceFillingCurve_() const
+    {
+        std::size_t numEntities = baseMapper_.size();
+
+        // compute the centers of all entities and their bounding box
+        std::vector<GlobalPosition> centers(numEntities);
+        for (const auto& elem : elements(gridView_)) {
+            if (codim_ == 0)
+                centers[baseMapper_.index(elem)] = elem.geometry().center();
+            else {
+                int numVertices = static_cast<int>(elem.subEntities(dim));
+                for (int i = 0; i < numVertices; ++i)
+                    centers[baseMapper_.subIndex(elem, i, dim)] = elem.geometry().corner(i);
+            }
+        }
+
+        GlobalPosition lower(std::numeric_limits<typename GridView::ctype>::max());
+        GlobalPosition upper(std::numeric_limits<typename GridView::ctype>::lowest());
+        for (const auto& center : centers) {
+            for (unsigned i = 0; i < dimWorld; ++i) {
+                lower[i] = std::min(lower[i], center[i]);
+                upper[i] = std::max(upper[i], center[i]);
+            }
+        }
+
+        // compute the position of the entities on the curve
+        std::vector<std::uint64_t> keys(numEntities);
+        for (std::size_t idx = 0; idx < numEntities; ++idx) {
+            std::uint32_t coords[dimWorld];
+            for (unsigned i = 0; i < dimWorld; ++i) {
+                double extent = upper[i] - lower[i];
+                double relPos = extent > 0.0 ? (centers[idx][i] - lower[i])/extent : 0.0;
+                coords[i] = static_cast<std::uint32_t>(relPos*((1u << bitsPerDim_) - 1));
+            }
+
+            if (ordering == DofOrdering::Hilbert)
+                hilbertTranspose_(coords);
+            keys[idx] = interleave_(coords);
+        }
+
+        std::vector<Index> order(numEntities);
+        std::iota(order.begin(), order.end(), Index(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&keys](Index a, Index b)
+                         { return keys[a] < keys[b]; });
+        return order;
+    }
+
+    // convert integer coordinates to the "transposed" Hilbert index (J. Skilling,
+    // "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004)
+    static void hilbertTranspose_(std::uint32_t* x)
+    {
+        const std::uint32_t m = 1u << (bitsPerDim_ - 1);
+
+        // inverse undo
+        for (std::uint32_t q = m; q > 1; q >>= 1) {
+            std::uint32_t p = q - 1;
+            for (unsigned i = 0; i < dimWorld; ++i) {
+                if (x[i] & q)
+                    x[0] ^= p;
+                else {
+                    std::uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+
+        // gray encode
+        for (unsigned i = 1; i < dimWorld; ++i)
+            x[i] ^= x[i - 1];
+        std::uint32_t t = 0;
+        for (std::uint32_t q = m; q > 1; q >>= 1)
+            if (x[dimWorld - 1] & q)
+                t ^= q - 1;
+        for (unsigned i = 0; i < dimWorld; ++i)
+            x[i] ^= t;
+    }
+
+    // interleave the bits of the coordinates, most significant bits first
+    static std::uint64_t interleave_(const std::uint32_t* x)
+    {
+        std::uint64_t key = 0;
+        for (int bitIdx = bitsPerDim_ - 1; bitIdx >= 0; --bitIdx)
+            for (unsigned i = 0; i < dimWorld; ++i)
+                key = (key << 1) | ((x[i] >> bitIdx) & 1u);
+        return key;
+    }
+
+    // the resolution of the space filling curves. the key of an entity must fit into
+    // 64 bits for up to three dimensions.
+    static constexpr int bitsPerDim_ = 21;
+
+    GridView gridView_;
+    BaseMapper baseMapper_;
+    int codim_{0};
+
+    std::vector<Index> permutation_;
+    std::size_t naturalBandwidth_{0};
+    std::size_t bandwidth_{0};
+};
+
+/*!
+ * \brief Returns the permutation which is applied by a mapper to the indices of the
+ *        grid's mapper.
+ *
+ * This is a null pointer for all mappers except the RenumberedMapper.
+ */
+template <class Mapper>
+const std::vector<typename Mapper::Index>* mapperPermutation(const Mapper&)
+{ return nullptr; }
+
+template <class GridView, DofOrdering ordering, class BaseMapper>
+const std::vector<typename RenumberedMapper<GridView, ordering, BaseMapper>::Index>*
+mapperPermutation(const RenumberedMapper<GridView, ordering, BaseMapper>& mapper)
+{
+    static_assert(std::is_same_v<BaseMapper, Dune::MultipleCodimMultipleGeomTypeMapper<GridView> >,
+                  "The permutation is only relative to the grid's mapper if the "
+                  "RenumberedMapper is based on it");
+    return &mapper.permutation();
+}
+
+} // namespace Opm
+
+#endif
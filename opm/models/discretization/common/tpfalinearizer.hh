@@ -35,6 +35,8 @@
 #include <opm/common/TimingMacros.hpp>
 
 #include <opm/models/discretization/common/baseauxiliarymodule.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <opm/grid/utility/SparseTable.hpp>
 #include <opm/input/eclipse/EclipseState/Grid/FaceDir.hpp>
@@ -43,6 +45,8 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <type_traits>
 #include <iostream>
 #include <vector>
@@ -146,6 +150,8 @@ public:
     void init(Simulator& simulator)
     {
         simulatorPtr_ = &simulator;
+        measureElementCosts_ = EWOMS_GET_PARAM(TypeTag, bool, EnableDynamicLoadBalancing);
+        elementCosts_.clear();
         eraseMatrix();
     }
 
@@ -189,35 +195,21 @@ public:
     void linearizeDomain()
     {
         OPM_TIMEBLOCK(linearizeDomain);
-        // we defer the initialization of the Jacobian matrix until here because the
-        // auxiliary modules usually assume the problem, model and grid to be fully
-        // initialized...
-        if (!jacobian_)
-            initFirstIteration_();
-
-        int succeeded;
-        try {
-            linearize_();
-            succeeded = 1;
-        }
-        catch (const std::exception& e)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing:" << e.what()
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-        catch (...)
-        {
-            std::cout << "rank " << simulator_().gridView().comm().rank()
-                      << " caught an exception while linearizing"
-                      << "\n"  << std::flush;
-            succeeded = 0;
-        }
-        succeeded = gridView_().comm().min(succeeded);
+        linearizeDomain_</*assembleJacobian=*/true>();
+    }
 
-        if (!succeeded)
-            throw NumericalProblem("A process did not succeed in linearizing the system");
+    /*!
+     * \brief Evaluate the residual of the spatial domain without touching the Jacobian
+     *        matrix.
+     *
+     * The residual is assembled from the same flux, storage, source and boundary terms
+     * as by linearizeDomain(), so it can be used in combination with a Jacobian matrix
+     * which was assembled during an earlier iteration.
+     */
+    void linearizeResidual()
+    {
+        OPM_TIMEBLOCK(linearizeResidual);
+        linearizeDomain_</*assembleJacobian=*/false>();
     }
 
     void finalize()
@@ -230,6 +222,7 @@ public:
     void linearizeAuxiliaryEquations()
     {
         OPM_TIMEBLOCK(linearizeAuxilaryEquations);
+        EWOMS_TIMEBLOCK(linearizeAuxiliaryEquations);
         // flush possible local caches into matrix structure
         jacobian_->commit();
 
@@ -314,6 +307,63 @@ public:
     const std::map<unsigned, Constraints> constraintsMap() const
     { return {}; }
 
+    /*!
+     * \brief Returns the computational costs of all elements.
+     *
+     * The costs are the wall clock time in seconds spent to linearize each cell,
+     * accumulated since the last call to resetElementCosts(). This object is only
+     * non-empty if the EnableDynamicLoadBalancing parameter is true.
+     */
+    const std::vector<double>& elementCosts() const
+    { return elementCosts_; }
+
+    /*!
+     * \brief Set the measured costs of all elements to zero.
+     */
+    void resetElementCosts()
+    { std::fill(elementCosts_.begin(), elementCosts_.end(), 0.0); }
+
+    /*!
+     * \brief Add the memory footprints of the linearized system.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        if (jacobian_)
+            usage.add("Jacobian matrix", memoryUsageOf(jacobian_->istlMatrix()));
+        usage.add("Residual", memoryUsageOf(residual_));
+        usage.add("Linearizer",
+                  memoryUsageOf(neighborInfo_)
+                  + memoryUsageOf(diagMatAddress_)
+                  + memoryUsageOf(boundaryInfo_)
+                  + memoryUsageOf(elementCosts_));
+        usage.add("Flows and flores", memoryUsageOf(flowsInfo_) + memoryUsageOf(floresInfo_));
+    }
+
+    /*!
+     * \brief Estimate the memory footprints of the linearized system without allocating
+     *        it.
+     *
+     * \param numRows The number of block rows of the Jacobian matrix
+     * \param numNonzeros The number of non-zero blocks of the Jacobian matrix
+     *
+     * Each off-diagonal block corresponds to one entry of the neighbor information. The
+     * boundary information as well as the flows and flores are not considered because
+     * their sizes depend on the problem.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage, std::size_t numRows, std::size_t numNonzeros) const
+    {
+        using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;
+        usage.add("Jacobian matrix", estimatedMemoryUsageOfMatrix<IstlMatrix>(numRows, numNonzeros));
+        usage.add("Residual", numRows*sizeof(typename GlobalEqVector::block_type));
+
+        std::size_t linearizerBytes =
+            (numNonzeros - numRows)*sizeof(NeighborInfo) + (numRows + 1)*sizeof(int)
+            + numRows*sizeof(MatrixBlock*);
+        if (measureElementCosts_)
+            linearizerBytes += numRows*sizeof(double);
+        usage.add("Linearizer", linearizerBytes);
+    }
+
 private:
     Simulator& simulator_()
     { return *simulatorPtr_; }
@@ -530,18 +580,67 @@ public:
     }
 
 private:
+    template <bool assembleJacobian>
+    void linearizeDomain_()
+    {
+        EWOMS_TIMEBLOCK(linearizeDomain);
+        // we defer the initialization of the Jacobian matrix until here because the
+        // auxiliary modules usually assume the problem, model and grid to be fully
+        // initialized...
+        if (!jacobian_)
+            initFirstIteration_();
+
+        int succeeded;
+        try {
+            linearize_<assembleJacobian>();
+            succeeded = 1;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing:" << e.what()
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+        catch (...)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while linearizing"
+                      << "\n"  << std::flush;
+            succeeded = 0;
+        }
+        succeeded = gridView_().comm().min(succeeded);
+
+        if (!succeeded)
+            throw NumericalProblem("A process did not succeed in linearizing the system");
+    }
+
+    // linearize the whole system. if assembleJacobian is false, only the residual is
+    // evaluated and the Jacobian matrix is left alone.
+    template <bool assembleJacobian>
     void linearize_()
     {
         OPM_TIMEBLOCK(linearize);
-        resetSystem_();
+        EWOMS_TIMEBLOCK(linearize);
+        if constexpr (assembleJacobian)
+            resetSystem_();
+        else
+            residual_ = 0.0;
         unsigned numCells = model_().numTotalDof();
         const bool& enableFlows = simulator_().problem().eclWriter()->eclOutputModule().hasFlows();
         const bool& enableFlores = simulator_().problem().eclWriter()->eclOutputModule().hasFlores();
+        // the cells are the elements of the grid for the two-point flux approximation
+        const bool measureElementCosts = assembleJacobian && measureElementCosts_;
+        if (measureElementCosts)
+            elementCosts_.resize(numCells, 0.0);
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
 #endif
         for (unsigned globI = 0; globI < numCells; globI++) {
             OPM_TIMEBLOCK_LOCAL(linearizationForEachCell);
+            std::chrono::steady_clock::time_point startTime;
+            if (measureElementCosts)
+                startTime = std::chrono::steady_clock::now();
             const auto& nbInfos = neighborInfo_[globI]; // this is a set but should maybe be changed
             VectorBlock res(0.0);
             MatrixBlock bMat(0.0);
@@ -586,11 +685,13 @@ private:
                 }
                 setResAndJacobi(res, bMat, adres);
                 residual_[globI] += res;
-                //SparseAdapter syntax:  jacobian_->addToBlock(globI, globI, bMat);
-                *diagMatAddress_[globI] += bMat;
-                bMat *= -1.0;
-                //SparseAdapter syntax: jacobian_->addToBlock(globJ, globI, bMat);
-                *nbInfo.matBlockAddress += bMat;
+                if constexpr (assembleJacobian) {
+                    //SparseAdapter syntax:  jacobian_->addToBlock(globI, globI, bMat);
+                    *diagMatAddress_[globI] += bMat;
+                    bMat *= -1.0;
+                    //SparseAdapter syntax: jacobian_->addToBlock(globJ, globI, bMat);
+                    *nbInfo.matBlockAddress += bMat;
+                }
                 ++loc;
             }
             }
@@ -615,15 +716,18 @@ private:
             bMat *= storefac;
             // residual_[globI] -= model_().cachedStorage(globI, 1); //*storefac;
             residual_[globI] += res;
-            //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
-            *diagMatAddress_[globI] += bMat;
+            if constexpr (assembleJacobian) {
+                //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
+                *diagMatAddress_[globI] += bMat;
+            }
 
             // Cell-wise source terms.
-            // This will include well sources if SeparateSparseSourceTerms is false.
+            // This will include well sources if SeparateSparseSourceTerms is false or
+            // if only the residual is evaluated.
             res = 0.0;
             bMat = 0.0;
             adres = 0.0;
-            if (separateSparseSourceTerms_) {
+            if (assembleJacobian && separateSparseSourceTerms_) {
                 LocalResidual::computeSourceDense(adres, problem_(), globI, 0);
             } else {
                 LocalResidual::computeSource(adres, problem_(), globI, 0);
@@ -631,12 +735,22 @@ private:
             adres *= -volume;
             setResAndJacobi(res, bMat, adres);
             residual_[globI] += res;
-            //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
-            *diagMatAddress_[globI] += bMat;
+            if constexpr (assembleJacobian) {
+                //SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
+                *diagMatAddress_[globI] += bMat;
+            }
+
+            if (measureElementCosts) {
+                std::chrono::duration<double> duration =
+                    std::chrono::steady_clock::now() - startTime;
+                elementCosts_[globI] += duration.count();
+            }
         } // end of loop for cell globI.
 
-        // Add sparse source terms. For now only wells.
-        if (separateSparseSourceTerms_) {
+        // Add sparse source terms. For now only wells. These are also added to the
+        // Jacobian matrix, so they are part of the cell-wise sources above if only the
+        // residual is evaluated.
+        if (assembleJacobian && separateSparseSourceTerms_) {
             problem_().wellModel().addReservoirSourceTerms(residual_, diagMatAddress_);
         }
 
@@ -654,8 +768,10 @@ private:
             adres *= bdyInfo.bcdata.faceArea;
             setResAndJacobi(res, bMat, adres);
             residual_[globI] += res;
-            ////SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
-            *diagMatAddress_[globI] += bMat;
+            if constexpr (assembleJacobian) {
+                ////SparseAdapter syntax: jacobian_->addToBlock(globI, globI, bMat);
+                *diagMatAddress_[globI] += bMat;
+            }
         }
     }
 
@@ -669,7 +785,7 @@ private:
         }
         unsigned numCells = model_().numTotalDof();
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
 #endif
         for (unsigned globI = 0; globI < numCells; globI++) {
             auto nbInfos = neighborInfo_[globI]; // nbInfos will be a SparseTable<...>::mutable_iterator_range.
@@ -729,6 +845,10 @@ private:
     };
     std::vector<BoundaryInfo> boundaryInfo_;
     bool separateSparseSourceTerms_ = false;
+
+    // the measured computational costs of the cells
+    bool measureElementCosts_{false};
+    std::vector<double> elementCosts_;
 };
 
 } // namespace Opm
@@ -57,9 +57,11 @@ struct Stencil<TypeTag, TTag::EcfvDiscretization>
 private:
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using ElementMapper = GetPropType<TypeTag, Properties::ElementMapper>;
 
 public:
-    using type = EcfvStencil<Scalar, GridView>;
+    using type = EcfvStencil<Scalar, GridView, /*needFaceIntegrationPos=*/true,
+                             /*needFaceNormal=*/true, ElementMapper>;
 };
 
 //! Mapper for the degrees of freedoms.
@@ -56,7 +56,8 @@ namespace Opm {
 template <class Scalar,
           class GridView,
           bool needFaceIntegrationPos = true,
-          bool needFaceNormal = true>
+          bool needFaceNormal = true,
+          class ElementMapperT = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>>
 class EcfvStencil
 {
     enum { dimWorld = GridView::dimensionworld };
@@ -65,7 +66,7 @@ class EcfvStencil
     using Intersection = typename GridView::Intersection;
     using Element = typename GridView::template Codim<0>::Entity;
 
-    using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using ElementMapper = ElementMapperT;
 
     using GlobalPosition = Dune::FieldVector<CoordScalar, dimWorld>;
 
@@ -261,6 +262,20 @@ public:
         assert(int(gridView.size(/*codim=*/0)) == int(elementMapper_.size()));
     }
 
+    /*!
+     * \brief Allocate the storage for a stencil of a given size.
+     *
+     * Since the storage is retained if the stencil shrinks, updating the stencil for
+     * elements which are not larger than this does not allocate any memory.
+     */
+    void reserve(size_t numDof, size_t numInteriorFaces, size_t numBoundaryFaces)
+    {
+        elements_.reserve(numDof);
+        subControlVolumes_.reserve(numDof);
+        interiorFaces_.reserve(numInteriorFaces);
+        boundaryFaces_.reserve(numBoundaryFaces);
+    }
+
     void updateTopology(const Element& element)
     {
         auto isIt = gridView_.ibegin(element);
@@ -462,7 +462,9 @@ VcfvScvGeometries<Scalar, /*dim=*/3, ElementType::cube>::scvGeoms_[
  * are constructed by connecting the element's center with each edge
  * of the element.
  */
-template <class Scalar, class GridView>
+template <class Scalar,
+          class GridView,
+          class VertexMapperT = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>>
 class VcfvStencil
 {
     enum{dim = GridView::dimension};
@@ -722,7 +724,7 @@ private:
 
 public:
     //! exported Mapper type
-    using Mapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using Mapper = VertexMapperT;
 
     class ScvGeometry
     {
@@ -1010,7 +1012,10 @@ public:
             }
         }
 
-        updateScvGeometry(e);
+        // refer to the copy of the element stored by the stencil. this keeps the
+        // stencil self-contained, so that it can be kept beyond the lifetime of the
+        // element object passed to this method.
+        updateScvGeometry(element_);
     }
 
     void updateScvGeometry(const Element& element)
@@ -1057,6 +1062,14 @@ public:
     }
 #endif
 
+    /*!
+     * \brief Allocate the storage for a stencil of a given size.
+     *
+     * The vertex-centered stencil uses fixed-size arrays, so this is a no-op.
+     */
+    void reserve(size_t, size_t, size_t)
+    {}
+
     unsigned numDof() const
     { return numVertices; }
 
@@ -0,0 +1,444 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::BatchedNcpFlash
+ */
+#ifndef EWOMS_BATCHED_NCP_FLASH_HH
+#define EWOMS_BATCHED_NCP_FLASH_HH
+
+#include <opm/material/fluidstates/CompositionalFluidState.hpp>
+#include <opm/material/densead/Evaluation.hpp>
+#include <opm/material/densead/Math.hpp>
+
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <exception>
+#include <limits>
+
+namespace Opm {
+
+/*!
+ * \ingroup FlashModel
+ *
+ * \brief Determines the chemical equilibrium of a batch of cells in lockstep.
+ *
+ * The equations, the primary variables, the damping and the convergence criterion are
+ * the ones of Opm::NcpFlash, but the Newton iterations of up to \c batchSize cells are
+ * done simultaneously: The Jacobians, the residuals and the primary variables of all
+ * lanes of the batch are stored as structures of arrays, so that the Gaussian
+ * eliminations, the damped updates and the convergence checks are loops over the lanes
+ * which the compiler can vectorize. Each lane has its own convergence mask. Lanes which
+ * have converged or failed keep an identity system and are not updated anymore, and the
+ * fluid system is only evaluated for the lanes which are still active. (The fluid
+ * systems are scalar code, so the thermodynamic relations are evaluated lane by lane.)
+ *
+ * Only the values of the results are computed. If their derivatives w.r.t. the total
+ * molarities are required, the results can be used as the starting point of the
+ * per-cell flash solver, which then converges within a single iteration.
+ */
+template <class Scalar, class FluidSystem, unsigned batchSize>
+class BatchedNcpFlash
+{
+    enum { numPhases = FluidSystem::numPhases };
+    enum { numComponents = FluidSystem::numComponents };
+
+    enum {
+        p0PvIdx = 0,
+        S0PvIdx = 1,
+        x00PvIdx = S0PvIdx + numPhases - 1
+    };
+
+    static constexpr unsigned numEq = numPhases*(numComponents + 1);
+    static constexpr unsigned maxIterations = 50;
+
+    using FlashEval = DenseAd::Evaluation<Scalar, numEq>;
+    using FlashFluidState = CompositionalFluidState<FlashEval, FluidSystem, /*energy=*/false>;
+    using FlashParamCache = typename FluidSystem::template ParameterCache<FlashEval>;
+
+    // a quantity for all lanes of the batch
+    using LaneVector = std::array<Scalar, batchSize>;
+    using LaneSystemVector = std::array<LaneVector, numEq>;
+    using LaneSystemMatrix = std::array<LaneSystemVector, numEq>;
+
+public:
+    using ComponentVector = Dune::FieldVector<Scalar, numComponents>;
+    using LaneMask = std::bitset<batchSize>;
+
+    /*!
+     * \brief Calculates the chemical equilibrium of a batch of cells.
+     *
+     * \param fluidStates The initial guesses of the lanes including their temperatures.
+     *                    For the lanes which converged, they are overwritten by the
+     *                    results.
+     * \param matParams The parameters of the material law of each lane.
+     * \param globalMolarities The total molarities of the components of each lane.
+     * \param numLanes The number of lanes which are used, i.e., only the first numLanes
+     *                 entries of the arrays are considered.
+     * \param tolerance The maximum weighted change of the primary variables of a
+     *                  converged lane. Non-positive values select the default of
+     *                  Opm::NcpFlash.
+     *
+     * \return The lanes for which the flash converged
+     */
+    template <class MaterialLaw, class FluidState>
+    static LaneMask solve(std::array<FluidState, batchSize>& fluidStates,
+                          const std::array<const typename MaterialLaw::Params*, batchSize>& matParams,
+                          const std::array<ComponentVector, batchSize>& globalMolarities,
+                          unsigned numLanes,
+                          Scalar tolerance = -1.0)
+    {
+        if (tolerance <= 0)
+            tolerance = std::min<Scalar>(1e-3, 1e8*std::numeric_limits<Scalar>::epsilon());
+
+        std::array<FlashFluidState, batchSize> flashFluidStates;
+        std::array<FlashParamCache, batchSize> paramCaches;
+        LaneSystemVector x;
+        LaneSystemMatrix J;
+        LaneSystemVector b;
+        LaneVector relError;
+
+        LaneMask active;
+        LaneMask converged;
+        for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+            if (laneIdx < numLanes) {
+                readPrimaryVariables_(x, laneIdx, fluidStates[laneIdx]);
+                flashFluidStates[laneIdx].setTemperature(fluidStates[laneIdx].temperature(/*phaseIdx=*/0));
+                if (completeLane_<MaterialLaw>(flashFluidStates[laneIdx],
+                                               paramCaches[laneIdx],
+                                               *matParams[laneIdx],
+                                               x,
+                                               laneIdx))
+                    active.set(laneIdx);
+            }
+            else {
+                for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                    x[pvIdx][laneIdx] = 0.0;
+            }
+        }
+
+        for (unsigned iterIdx = 0; iterIdx < maxIterations && active.any(); ++iterIdx) {
+            // linearize the defect of the active lanes. the other ones get an identity
+            // system and thus a zero update
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                if (active[laneIdx])
+                    linearizeLane_(J, b, laneIdx, flashFluidStates[laneIdx], globalMolarities[laneIdx]);
+                else
+                    setIdentityLane_(J, b, laneIdx);
+            }
+
+            active &= ~solveLinearSystems_(J, b);
+            update_(x, relError, b);
+
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                if (!active[laneIdx])
+                    continue;
+
+                if (!std::isfinite(relError[laneIdx])
+                    || !completeLane_<MaterialLaw>(flashFluidStates[laneIdx],
+                                                   paramCaches[laneIdx],
+                                                   *matParams[laneIdx],
+                                                   x,
+                                                   laneIdx))
+                {
+                    active.reset(laneIdx);
+                }
+                else if (relError[laneIdx] < tolerance) {
+                    active.reset(laneIdx);
+                    converged.set(laneIdx);
+                }
+            }
+        }
+
+        for (unsigned laneIdx = 0; laneIdx < numLanes; ++laneIdx)
+            if (converged[laneIdx])
+                assignOutputFluidState_(flashFluidStates[laneIdx], fluidStates[laneIdx]);
+
+        return converged;
+    }
+
+private:
+    template <class FluidState>
+    static void readPrimaryVariables_(LaneSystemVector& x,
+                                      unsigned laneIdx,
+                                      const FluidState& fluidState)
+    {
+        x[p0PvIdx][laneIdx] = fluidState.pressure(/*phaseIdx=*/0);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases - 1; ++phaseIdx)
+            x[S0PvIdx + phaseIdx][laneIdx] = fluidState.saturation(phaseIdx);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                x[x00PvIdx + phaseIdx*numComponents + compIdx][laneIdx] =
+                    fluidState.moleFraction(phaseIdx, compIdx);
+    }
+
+    // set the fluid state of a lane to its primary variables and calculate all
+    // quantities which depend on them. returns false if the fluid system failed.
+    template <class MaterialLaw>
+    static bool completeLane_(FlashFluidState& fluidState,
+                              FlashParamCache& paramCache,
+                              const typename MaterialLaw::Params& matParams,
+                              const LaneSystemVector& x,
+                              unsigned laneIdx)
+    {
+        // the saturation of the last phase is one minus the sum of the other ones
+        FlashEval sumSat = 0.0;
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases - 1; ++phaseIdx) {
+            FlashEval S = FlashEval::createVariable(x[S0PvIdx + phaseIdx][laneIdx],
+                                                    S0PvIdx + phaseIdx);
+            fluidState.setSaturation(phaseIdx, S);
+            sumSat += S;
+        }
+        fluidState.setSaturation(numPhases - 1, 1.0 - sumSat);
+
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                unsigned pvIdx = x00PvIdx + phaseIdx*numComponents + compIdx;
+                fluidState.setMoleFraction(phaseIdx, compIdx,
+                                           FlashEval::createVariable(x[pvIdx][laneIdx], pvIdx));
+            }
+        }
+
+        try {
+            // the pressures of the other phases are given by the capillary pressures
+            FlashEval p0 = FlashEval::createVariable(x[p0PvIdx][laneIdx], p0PvIdx);
+            std::array<FlashEval, numPhases> pc;
+            MaterialLaw::capillaryPressures(pc, matParams, fluidState);
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                fluidState.setPressure(phaseIdx, p0 + (pc[phaseIdx] - pc[0]));
+
+            paramCache.updateAll(fluidState);
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                fluidState.setDensity(phaseIdx,
+                                      FluidSystem::density(fluidState, paramCache, phaseIdx));
+
+                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                    const FlashEval& phi =
+                        FluidSystem::fugacityCoefficient(fluidState, paramCache, phaseIdx, compIdx);
+                    fluidState.setFugacityCoefficient(phaseIdx, compIdx, phi);
+                }
+            }
+        }
+        catch (const std::exception&) {
+            // the lane is left to the per-cell flash solver, which reports the problem
+            return false;
+        }
+
+        return true;
+    }
+
+    static void linearizeLane_(LaneSystemMatrix& J,
+                               LaneSystemVector& b,
+                               unsigned laneIdx,
+                               const FlashFluidState& fluidState,
+                               const ComponentVector& globalMolarities)
+    {
+        std::array<FlashEval, numEq> defect;
+        unsigned eqIdx = 0;
+
+        // the fugacity of each component must be the same in all phases
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            for (unsigned phaseIdx = 1; phaseIdx < numPhases; ++phaseIdx) {
+                defect[eqIdx] =
+                    fluidState.fugacity(/*phaseIdx=*/0, compIdx)
+                    - fluidState.fugacity(phaseIdx, compIdx);
+                ++eqIdx;
+            }
+        }
+
+        // the total molarities are given
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            defect[eqIdx] = 0.0;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                defect[eqIdx] +=
+                    fluidState.saturation(phaseIdx)
+                    * fluidState.molarity(phaseIdx, compIdx);
+
+            defect[eqIdx] -= globalMolarities[compIdx];
+            ++eqIdx;
+        }
+
+        // a phase is either absent or its mole fractions sum up to one
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            FlashEval oneMinusSumMoleFrac = 1.0;
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                oneMinusSumMoleFrac -= fluidState.moleFraction(phaseIdx, compIdx);
+
+            if (oneMinusSumMoleFrac > fluidState.saturation(phaseIdx))
+                defect[eqIdx] = fluidState.saturation(phaseIdx);
+            else
+                defect[eqIdx] = oneMinusSumMoleFrac;
+            ++eqIdx;
+        }
+
+        for (eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                J[eqIdx][pvIdx][laneIdx] = defect[eqIdx].derivative(pvIdx);
+            b[eqIdx][laneIdx] = defect[eqIdx].value();
+        }
+    }
+
+    static void setIdentityLane_(LaneSystemMatrix& J, LaneSystemVector& b, unsigned laneIdx)
+    {
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                J[eqIdx][pvIdx][laneIdx] = (eqIdx == pvIdx) ? 1.0 : 0.0;
+            b[eqIdx][laneIdx] = 0.0;
+        }
+    }
+
+    // solve the linear systems of all lanes using Gaussian elimination with partial
+    // pivoting. b is overwritten by the solutions. returns the lanes whose matrices are
+    // singular.
+    static LaneMask solveLinearSystems_(LaneSystemMatrix& J, LaneSystemVector& b)
+    {
+        // the same limit as the one used by Opm::NcpFlash
+        constexpr Scalar singularLimit = 1e-35;
+
+        LaneVector singular;
+        singular.fill(0.0);
+        for (unsigned k = 0; k < numEq; ++k) {
+            // find the pivot row of each lane
+            std::array<unsigned, batchSize> pivotRowIdx;
+            LaneVector pivotAbs;
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                pivotRowIdx[laneIdx] = k;
+                pivotAbs[laneIdx] = std::abs(J[k][k][laneIdx]);
+            }
+            for (unsigned i = k + 1; i < numEq; ++i) {
+                for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                    Scalar a = std::abs(J[i][k][laneIdx]);
+                    bool isLarger = a > pivotAbs[laneIdx];
+                    pivotAbs[laneIdx] = isLarger ? a : pivotAbs[laneIdx];
+                    pivotRowIdx[laneIdx] = isLarger ? i : pivotRowIdx[laneIdx];
+                }
+            }
+
+            // swap the pivot rows into place
+            for (unsigned j = k; j < numEq; ++j) {
+                for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                    unsigned p = pivotRowIdx[laneIdx];
+                    Scalar tmp = J[k][j][laneIdx];
+                    J[k][j][laneIdx] = J[p][j][laneIdx];
+                    J[p][j][laneIdx] = tmp;
+                }
+            }
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                unsigned p = pivotRowIdx[laneIdx];
+                Scalar tmp = b[k][laneIdx];
+                b[k][laneIdx] = b[p][laneIdx];
+                b[p][laneIdx] = tmp;
+            }
+
+            // singular lanes are eliminated using a unit pivot to keep the other
+            // lanes free of non-finite values. their results are discarded
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                bool isSingular = !(pivotAbs[laneIdx] >= singularLimit);
+                singular[laneIdx] = isSingular ? 1.0 : singular[laneIdx];
+                J[k][k][laneIdx] = isSingular ? 1.0 : J[k][k][laneIdx];
+            }
+
+            // eliminate the entries below the pivot
+            for (unsigned i = k + 1; i < numEq; ++i) {
+                LaneVector factor;
+                for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+                    factor[laneIdx] = J[i][k][laneIdx]/J[k][k][laneIdx];
+                for (unsigned j = k; j < numEq; ++j)
+                    for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+                        J[i][j][laneIdx] -= factor[laneIdx]*J[k][j][laneIdx];
+                for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+                    b[i][laneIdx] -= factor[laneIdx]*b[k][laneIdx];
+            }
+        }
+
+        // back substitution
+        for (int i = numEq - 1; i >= 0; --i) {
+            for (unsigned j = i + 1; j < numEq; ++j)
+                for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+                    b[i][laneIdx] -= J[i][j][laneIdx]*b[j][laneIdx];
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+                b[i][laneIdx] /= J[i][i][laneIdx];
+        }
+
+        LaneMask result;
+        for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx)
+            result[laneIdx] = singular[laneIdx] > 0.0;
+        return result;
+    }
+
+    // apply the damped Newton update to the primary variables of all lanes and compute
+    // the weighted size of the undamped updates. the lanes which are not active have a
+    // zero update.
+    static void update_(LaneSystemVector& x, LaneVector& relError, const LaneSystemVector& deltaX)
+    {
+        relError.fill(0.0);
+        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+            // the pressure is weighted such that 1 Pa corresponds to 1e-6
+            Scalar weight = (pvIdx == p0PvIdx) ? 1e-6 : 1.0;
+            for (unsigned laneIdx = 0; laneIdx < batchSize; ++laneIdx) {
+                Scalar delta = deltaX[pvIdx][laneIdx];
+                relError[laneIdx] = std::max(relError[laneIdx], std::abs(delta)*weight);
+
+                // dampen to at most 50% change in pressure, 25% change in saturation and
+                // 20% change in mole fraction per iteration
+                Scalar maxDelta;
+                if (pvIdx == p0PvIdx)
+                    maxDelta = 0.5*x[p0PvIdx][laneIdx];
+                else if (pvIdx < x00PvIdx)
+                    maxDelta = 0.25;
+                else
+                    maxDelta = 0.20;
+                delta = std::min(maxDelta, std::max(-maxDelta, delta));
+
+                x[pvIdx][laneIdx] -= delta;
+            }
+        }
+    }
+
+    template <class FluidState>
+    static void assignOutputFluidState_(const FlashFluidState& flashFluidState,
+                                        FluidState& fluidState)
+    {
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            fluidState.setPressure(phaseIdx, flashFluidState.pressure(phaseIdx).value());
+            fluidState.setSaturation(phaseIdx, flashFluidState.saturation(phaseIdx).value());
+            fluidState.setDensity(phaseIdx, flashFluidState.density(phaseIdx).value());
+
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                fluidState.setMoleFraction(phaseIdx, compIdx,
+                                           flashFluidState.moleFraction(phaseIdx, compIdx).value());
+                fluidState.setFugacityCoefficient(phaseIdx, compIdx,
+                                                  flashFluidState.fugacityCoefficient(phaseIdx, compIdx).value());
+            }
+        }
+    }
+};
+
+} // namespace Opm
+
+#endif
@@ -35,11 +35,17 @@
 #include <opm/models/common/diffusionmodule.hh>
 
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
+#include <opm/material/common/MathToolbox.hpp>
 #include <opm/material/common/Valgrind.hpp>
+#include <opm/material/densead/Evaluation.hpp>
 
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <array>
+#include <chrono>
+#include <type_traits>
+
 namespace Opm {
 
 /*!
@@ -77,8 +83,10 @@ class FlashIntensiveQuantities
     using Evaluation = GetPropType<TypeTag, Properties::Evaluation>;
     using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
     using FlashSolver = GetPropType<TypeTag, Properties::FlashSolver>;
+    using Toolbox = MathToolbox<Evaluation>;
 
     using ComponentVector = Dune::FieldVector<Evaluation, numComponents>;
+    using ScalarComponentVector = Dune::FieldVector<Scalar, numComponents>;
     using DimMatrix = Dune::FieldMatrix<Scalar, dimWorld, dimWorld>;
 
     using FluxIntensiveQuantities = typename FluxModule::FluxIntensiveQuantities;
@@ -89,6 +97,9 @@ public:
     //! The type of the object returned by the fluidState() method
     using FluidState = Opm::CompositionalFluidState<Evaluation, FluidSystem, enableEnergy>;
 
+    //! The type of the value-only records of the fluid state
+    using ScalarFluidState = Opm::CompositionalFluidState<Scalar, FluidSystem, enableEnergy>;
+
     FlashIntensiveQuantities()
     { }
 
@@ -107,33 +118,71 @@ public:
         const auto& priVars = elemCtx.primaryVars(dofIdx, timeIdx);
         const auto& problem = elemCtx.problem();
         Scalar flashTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, FlashTolerance);
-
-        // extract the total molar densities of the components
-        ComponentVector cTotal;
-        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
-            cTotal[compIdx] = priVars.makeEvaluation(cTot0Idx + compIdx, timeIdx);
-
         const auto *hint = elemCtx.thermodynamicHint(dofIdx, timeIdx);
-        if (hint) {
-            // use the same fluid state as the one of the hint, but
-            // make sure that we don't overwrite the temperature
-            // specified by the primary variables
-            Evaluation T = fluidState_.temperature(/*phaseIdx=*/0);
-            fluidState_.assign(hint->fluidState());
-            fluidState_.setTemperature(T);
-        }
-        else
-            FlashSolver::guessInitial(fluidState_, cTotal);
+        const MaterialLawParams& materialParams =
+            problem.materialLawParams(elemCtx, dofIdx, timeIdx);
 
         // compute the phase compositions, densities and pressures
         typename FluidSystem::template ParameterCache<Evaluation> paramCache;
-        const MaterialLawParams& materialParams =
-            problem.materialLawParams(elemCtx, dofIdx, timeIdx);
-        FlashSolver::template solve<MaterialLaw>(fluidState_,
-                                                 materialParams,
-                                                 paramCache,
-                                                 cTotal,
-                                                 flashTolerance);
+        if (auto* isatTable = elemCtx.model().isatTable()) {
+            // look up the result of the flash in the table of previous results. the
+            // derivatives are obtained using the sensitivities stored in the table.
+            tabulatedFlash_(*isatTable, priVars, timeIdx, hint, materialParams, flashTolerance);
+            paramCache.updateAll(fluidState_);
+        }
+        else if (timeIdx > 0 && !std::is_same<Evaluation, Scalar>::value) {
+            // the primary variables of previous time steps do not exhibit any
+            // derivatives, so the flash can be done using scalars. this is considerably
+            // cheaper than propagating zero derivatives through the flash solver. if
+            // the intensive quantities of the previous time steps are not cached, the
+            // record of their fluid state is used as the initial guess.
+            const ScalarFluidState* record = nullptr;
+            if (!hint)
+                record = elemCtx.model().cachedFluidStateRecord(elemCtx.globalSpaceIndex(dofIdx, timeIdx),
+                                                                timeIdx);
+            scalarFlash_(priVars, hint, record, materialParams, flashTolerance);
+            paramCache.updateAll(fluidState_);
+        }
+        else {
+            // extract the total molar densities of the components
+            ComponentVector cTotal;
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                cTotal[compIdx] = priVars.makeEvaluation(cTot0Idx + compIdx, timeIdx);
+
+            const ScalarFluidState* batchedResult = nullptr;
+            if (timeIdx == 0) {
+                ScalarComponentVector cTotalValues;
+                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                    cTotalValues[compIdx] = Toolbox::value(cTotal[compIdx]);
+                batchedResult =
+                    elemCtx.model().batchedFlashResult(elemCtx.globalSpaceIndex(dofIdx, timeIdx),
+                                                       cTotalValues,
+                                                       Toolbox::value(fluidState_.temperature(/*phaseIdx=*/0)));
+            }
+
+            if (batchedResult) {
+                // the flash has already been solved for these primary variables by the
+                // batched flash of the model. starting at its result, the flash solver
+                // converges within a single iteration, which yields the derivatives.
+                copyFlashResultValues_(fluidState_, *batchedResult);
+            }
+            else if (hint) {
+                // use the same fluid state as the one of the hint, but
+                // make sure that we don't overwrite the temperature
+                // specified by the primary variables
+                Evaluation T = fluidState_.temperature(/*phaseIdx=*/0);
+                fluidState_.assign(hint->fluidState());
+                fluidState_.setTemperature(T);
+            }
+            else
+                FlashSolver::guessInitial(fluidState_, cTotal);
+
+            FlashSolver::template solve<MaterialLaw>(fluidState_,
+                                                     materialParams,
+                                                     paramCache,
+                                                     cTotal,
+                                                     flashTolerance);
+        }
 
         // calculate relative permeabilities
         MaterialLaw::relativePermeabilities(relativePermeability_,
@@ -205,6 +254,162 @@ public:
     { return porosity_; }
 
 private:
+    // do the flash calculation for primary variables which do not exhibit derivatives
+    template <class PrimaryVariables, class IntensiveQuantities>
+    void scalarFlash_(const PrimaryVariables& priVars,
+                      const IntensiveQuantities* hint,
+                      const ScalarFluidState* record,
+                      const MaterialLawParams& materialParams,
+                      Scalar flashTolerance)
+    {
+        ScalarComponentVector cTotal;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            cTotal[compIdx] = priVars[cTot0Idx + compIdx];
+
+        // the temperature is specified by the primary variables
+        Scalar T = Toolbox::value(fluidState_.temperature(/*phaseIdx=*/0));
+        ScalarFluidState fs;
+        if (hint)
+            fs.assign(hint->fluidState());
+        else if (record)
+            fs = *record;
+        fs.setTemperature(T);
+        if (!hint && !record)
+            FlashSolver::guessInitial(fs, cTotal);
+
+        typename FluidSystem::template ParameterCache<Scalar> paramCache;
+        FlashSolver::template solve<MaterialLaw>(fs,
+                                                 materialParams,
+                                                 paramCache,
+                                                 cTotal,
+                                                 flashTolerance);
+
+        // copy the result to the fluid state of the intensive quantities
+        copyFlashResultValues_(fluidState_, fs);
+    }
+
+    // do the flash calculation using the in-situ adaptive tabulation of the model
+    template <class IsatTable, class PrimaryVariables, class IntensiveQuantities>
+    void tabulatedFlash_(IsatTable& isatTable,
+                         const PrimaryVariables& priVars,
+                         unsigned timeIdx,
+                         const IntensiveQuantities* hint,
+                         const MaterialLawParams& materialParams,
+                         Scalar flashTolerance)
+    {
+        using InputVector = typename IsatTable::InputVector;
+        using OutputVector = typename IsatTable::OutputVector;
+        using Jacobian = typename IsatTable::Jacobian;
+
+        // the inputs of the flash are the total molar densities of the components and
+        // the temperature
+        constexpr unsigned numInputs = numComponents + 1;
+        constexpr unsigned temperatureInputIdx = numComponents;
+        constexpr unsigned numPhaseOutputs = 3 + 2*numComponents;
+
+        std::array<Evaluation, numInputs> inputs;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            inputs[compIdx] = priVars.makeEvaluation(cTot0Idx + compIdx, timeIdx);
+        inputs[temperatureInputIdx] = fluidState_.temperature(/*phaseIdx=*/0);
+
+        InputVector x;
+        for (unsigned j = 0; j < numInputs; ++j)
+            x[j] = Toolbox::value(inputs[j]);
+
+        InputVector x0;
+        OutputVector f0;
+        Jacobian A;
+        if (!isatTable.retrieve(x, x0, f0, A)) {
+            auto startTime = std::chrono::steady_clock::now();
+
+            // solve the flash using an evaluation whose derivatives are the
+            // sensitivities of the results to the inputs
+            using IsatEvaluation = DenseAd::Evaluation<Scalar, numInputs>;
+            using IsatFluidState = CompositionalFluidState<IsatEvaluation, FluidSystem, enableEnergy>;
+
+            ScalarComponentVector cTotalValues;
+            Dune::FieldVector<IsatEvaluation, numComponents> cTotal;
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                cTotalValues[compIdx] = x[compIdx];
+                cTotal[compIdx] = IsatEvaluation::createVariable(x[compIdx], compIdx);
+            }
+
+            ScalarFluidState initialFs;
+            if (hint)
+                initialFs.assign(hint->fluidState());
+            initialFs.setTemperature(x[temperatureInputIdx]);
+            if (!hint)
+                FlashSolver::guessInitial(initialFs, cTotalValues);
+
+            IsatFluidState fs;
+            copyFlashResultValues_(fs, initialFs);
+            fs.setTemperature(IsatEvaluation::createVariable(x[temperatureInputIdx],
+                                                             temperatureInputIdx));
+
+            typename FluidSystem::template ParameterCache<IsatEvaluation> paramCache;
+            FlashSolver::template solve<MaterialLaw>(fs,
+                                                     materialParams,
+                                                     paramCache,
+                                                     cTotal,
+                                                     flashTolerance);
+
+            auto setOutput = [&f0, &A](unsigned outIdx, const IsatEvaluation& value) {
+                f0[outIdx] = value.value();
+                for (unsigned j = 0; j < numInputs; ++j)
+                    A[outIdx][j] = value.derivative(j);
+            };
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                unsigned offset = phaseIdx*numPhaseOutputs;
+                setOutput(offset + 0, fs.pressure(phaseIdx));
+                setOutput(offset + 1, fs.saturation(phaseIdx));
+                setOutput(offset + 2, fs.density(phaseIdx));
+                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                    setOutput(offset + 3 + 2*compIdx, fs.moleFraction(phaseIdx, compIdx));
+                    setOutput(offset + 4 + 2*compIdx, fs.fugacityCoefficient(phaseIdx, compIdx));
+                }
+            }
+            x0 = x;
+
+            std::chrono::duration<double> dt = std::chrono::steady_clock::now() - startTime;
+            isatTable.add(x, f0, A, dt.count());
+        }
+
+        // linearly extrapolate the record. by the chain rule, this also yields the
+        // derivatives of the results w.r.t. the primary variables.
+        auto output = [&](unsigned outIdx) {
+            Evaluation result = f0[outIdx];
+            for (unsigned j = 0; j < numInputs; ++j)
+                result += A[outIdx][j]*(inputs[j] - x0[j]);
+            return result;
+        };
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            unsigned offset = phaseIdx*numPhaseOutputs;
+            fluidState_.setPressure(phaseIdx, output(offset + 0));
+            fluidState_.setSaturation(phaseIdx, output(offset + 1));
+            fluidState_.setDensity(phaseIdx, output(offset + 2));
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                fluidState_.setMoleFraction(phaseIdx, compIdx, output(offset + 3 + 2*compIdx));
+                fluidState_.setFugacityCoefficient(phaseIdx, compIdx, output(offset + 4 + 2*compIdx));
+            }
+        }
+    }
+
+    // copy the quantities determined by the flash solver from a fluid state without
+    // derivatives
+    template <class DstFluidState>
+    static void copyFlashResultValues_(DstFluidState& dst, const ScalarFluidState& src)
+    {
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            dst.setPressure(phaseIdx, src.pressure(phaseIdx));
+            dst.setSaturation(phaseIdx, src.saturation(phaseIdx));
+            dst.setDensity(phaseIdx, src.density(phaseIdx));
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                dst.setMoleFraction(phaseIdx, compIdx, src.moleFraction(phaseIdx, compIdx));
+                dst.setFugacityCoefficient(phaseIdx, compIdx, src.fugacityCoefficient(phaseIdx, compIdx));
+            }
+        }
+    }
+
     DimMatrix intrinsicPerm_;
     FluidState fluidState_;
     Evaluation porosity_;
@@ -38,18 +38,29 @@
 #include "flashintensivequantities.hh"
 #include "flashextensivequantities.hh"
 #include "flashindices.hh"
+#include "flashnewtonmethod.hh"
+#include "batchedncpflash.hh"
 
 #include <opm/models/common/multiphasebasemodel.hh>
 #include <opm/models/common/energymodule.hh>
 #include <opm/models/io/vtkcompositionmodule.hh>
 #include <opm/models/io/vtkenergymodule.hh>
 #include <opm/models/io/vtkdiffusionmodule.hh>
+#include <opm/models/utils/isattable.hh>
+#include <opm/models/parallel/threadedentityiterator.hh>
 #include <opm/material/fluidmatrixinteractions/NullMaterial.hpp>
 #include <opm/material/fluidmatrixinteractions/MaterialTraits.hpp>
 #include <opm/material/constraintsolvers/NcpFlash.hpp>
+#include <opm/material/fluidstates/CompositionalFluidState.hpp>
 
+#include <dune/common/fvector.hh>
+
+#include <array>
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace Opm {
 template <class TypeTag>
@@ -84,10 +95,22 @@ struct FlashTolerance<TypeTag, TTag::FlashModel>
     static constexpr type value = -1.0;
 };
 
+//! Do not solve the flashes in batches by default
+template<class TypeTag>
+struct EnableBatchedFlash<TypeTag, TTag::FlashModel> { static constexpr bool value = false; };
+
+//! The number of cells whose flashes are solved in lockstep
+template<class TypeTag>
+struct FlashBatchSize<TypeTag, TTag::FlashModel> { static constexpr unsigned value = 16; };
+
 //! the Model property
 template<class TypeTag>
 struct Model<TypeTag, TTag::FlashModel> { using type = Opm::FlashModel<TypeTag>; };
 
+//! Use the Newton method which solves the flashes in batches
+template<class TypeTag>
+struct NewtonMethod<TypeTag, TTag::FlashModel> { using type = Opm::FlashNewtonMethod<TypeTag>; };
+
 //! the PrimaryVariables property
 template<class TypeTag>
 struct PrimaryVariables<TypeTag, TTag::FlashModel> { using type = Opm::FlashPrimaryVariables<TypeTag>; };
@@ -123,6 +146,12 @@ struct EnableIntensiveQuantityCache<TypeTag, TTag::FlashModel> { static constexp
 template<class TypeTag>
 struct EnableThermodynamicHints<TypeTag, TTag::FlashModel> { static constexpr bool value = true; };
 
+// cache the storage term of the previous time step instead of recalculating it with a
+// flash in every iteration. the fluid states of the previous time step are then kept as
+// value-only records which serve as the initial guess if the flash needs to be redone.
+template<class TypeTag>
+struct EnableStorageCache<TypeTag, TTag::FlashModel> { static constexpr bool value = true; };
+
 // disable molecular diffusion by default
 template<class TypeTag>
 struct EnableDiffusion<TypeTag, TTag::FlashModel> { static constexpr bool value = false; };
@@ -203,20 +232,70 @@ class FlashModel
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
     using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
+    using MaterialLaw = GetPropType<TypeTag, Properties::MaterialLaw>;
+    using MaterialLawParams = GetPropType<TypeTag, Properties::MaterialLawParams>;
+    using FlashSolver = GetPropType<TypeTag, Properties::FlashSolver>;
 
     using Indices = GetPropType<TypeTag, Properties::Indices>;
 
+    enum { numPhases = getPropValue<TypeTag, Properties::NumPhases>() };
     enum { numComponents = getPropValue<TypeTag, Properties::NumComponents>() };
     enum { enableDiffusion = getPropValue<TypeTag, Properties::EnableDiffusion>() };
     enum { enableEnergy = getPropValue<TypeTag, Properties::EnableEnergy>() };
+    enum { flashBatchSize = getPropValue<TypeTag, Properties::FlashBatchSize>() };
 
+    using ElementIterator = typename GridView::template Codim<0>::Iterator;
+    using ScalarComponentVector = Dune::FieldVector<Scalar, numComponents>;
+    using BatchedFlash = BatchedNcpFlash<Scalar, FluidSystem, flashBatchSize>;
 
     using EnergyModule = Opm::EnergyModule<TypeTag, enableEnergy>;
 
 public:
+    /*!
+     * \brief The table used to tabulate the results of the flash calculations.
+     *
+     * The inputs are the total molar densities of the components and the temperature.
+     * For each phase, the outputs are the pressure, the saturation, the density and the
+     * mole fractions and fugacity coefficients of all components.
+     */
+    using IsatTable = Opm::IsatTable<Scalar, numComponents + 1, numPhases*(3 + 2*numComponents)>;
+
+    //! The type of the fluid states which store the results of the batched flash
+    using BatchedFlashFluidState = Opm::CompositionalFluidState<Scalar, FluidSystem, enableEnergy>;
+
     FlashModel(Simulator& simulator)
         : ParentType(simulator)
-    {}
+    {
+        enableBatchedFlash_ = EWOMS_GET_PARAM(TypeTag, bool, EnableBatchedFlash);
+        flashTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, FlashTolerance);
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableIsat)) {
+            typename IsatTable::InputVector inputScales;
+            inputScales.fill(1.0);
+
+            typename IsatTable::OutputVector outputScales;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                unsigned offset = phaseIdx*(3 + 2*numComponents);
+                outputScales[offset + 0] = 1e3; // pressure [Pa]
+                outputScales[offset + 1] = 1.0; // saturation
+                outputScales[offset + 2] = 1.0; // density [kg/m^3]
+                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                    outputScales[offset + 3 + 2*compIdx] = 1.0; // mole fraction
+                    outputScales[offset + 4 + 2*compIdx] = 1e-10; // fugacity coefficient
+                }
+            }
+
+            std::size_t memoryBudget =
+                static_cast<std::size_t>(EWOMS_GET_PARAM(TypeTag, int, IsatMemoryBudget))*1024*1024;
+            isatTable_ = std::make_unique<IsatTable>(EWOMS_GET_PARAM(TypeTag, Scalar, IsatTolerance),
+                                                     EWOMS_GET_PARAM(TypeTag, Scalar, IsatBinWidth),
+                                                     memoryBudget,
+                                                     inputScales,
+                                                     outputScales);
+        }
+    }
 
     /*!
      * \brief Register all run-time parameters for the immiscible model.
@@ -237,6 +316,125 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, FlashTolerance,
                              "The maximum tolerance for the flash solver to "
                              "consider the solution converged");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIsat,
+                             "Tabulate the results of the flash calculations using "
+                             "in-situ adaptive tabulation");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IsatTolerance,
+                             "The maximum scaled error of flash results taken from the table");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IsatBinWidth,
+                             "The relative width of the bins of the flash table");
+        EWOMS_REGISTER_PARAM(TypeTag, int, IsatMemoryBudget,
+                             "The maximum amount of memory used by the flash table [MB]");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableBatchedFlash,
+                             "Solve the flashes of all cells whose intensive quantities "
+                             "need to be updated in batches before each linearization");
+    }
+
+    /*!
+     * \brief Returns the table of flash results or nullptr if tabulation is disabled.
+     */
+    IsatTable* isatTable() const
+    { return isatTable_.get(); }
+
+    /*!
+     * \brief Solve the flashes of all degrees of freedom whose intensive quantities are
+     *        not cached in batches.
+     *
+     * This is called by the Newton method before each linearization. The results are
+     * only used as starting points of the per-cell flash solver if the intensive
+     * quantities are updated for the same primary variables, so they do not need to be
+     * invalidated. Lanes which do not converge are left to the per-cell flash solver.
+     * Nothing is done unless the batched flash is enabled and the flash results are not
+     * tabulated.
+     */
+    void solveFlashesBatched()
+    {
+        if (!enableBatchedFlash_ || isatTable_)
+            return;
+
+        std::size_t numDof = this->numGridDof();
+        if (batchedFlashResults_.size() != numDof) {
+            // the grid has changed
+            batchedFlashResults_.clear();
+            batchedFlashResults_.resize(numDof);
+        }
+        batchedFlashClaimed_.assign(numDof, 0);
+
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(this->gridView());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            ElementContext elemCtx(this->simulator_);
+            BatchedFlashLanes lanes;
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                elemCtx.updatePrimaryStencil(*elemIt);
+                for (unsigned dofIdx = 0; dofIdx < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++dofIdx) {
+                    unsigned globalIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+
+                    // the degrees of freedom of the vertex centered discretization are
+                    // shared by the elements, so make sure that each one is only handled
+                    // by a single thread
+                    unsigned char wasClaimed;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+                    {
+                        wasClaimed = batchedFlashClaimed_[globalIdx];
+                        batchedFlashClaimed_[globalIdx] = 1;
+                    }
+                    if (wasClaimed || this->cachedIntensiveQuantities(globalIdx, /*timeIdx=*/0))
+                        continue;
+
+                    addBatchedFlashLane_(lanes, elemCtx, dofIdx, globalIdx);
+                    if (lanes.numLanes == flashBatchSize)
+                        solveBatchedFlashLanes_(lanes);
+                }
+            }
+
+            if (lanes.numLanes > 0)
+                solveBatchedFlashLanes_(lanes);
+        }
+    }
+
+    /*!
+     * \brief Returns the result of the batched flash of a degree of freedom.
+     *
+     * If the batched flash did not converge for the given total molarities and
+     * temperature, nullptr is returned.
+     */
+    const BatchedFlashFluidState* batchedFlashResult(unsigned globalIdx,
+                                                     const ScalarComponentVector& cTotal,
+                                                     Scalar temperature) const
+    {
+        if (globalIdx >= batchedFlashResults_.size())
+            return nullptr;
+
+        const auto& result = batchedFlashResults_[globalIdx];
+        if (!result.isConverged || result.cTotal != cTotal || result.temperature != temperature)
+            return nullptr;
+
+        return &result.fluidState;
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::finalize
+     */
+    void finalize()
+    {
+        ParentType::finalize();
+
+        if (!isatTable_)
+            return;
+
+        const auto& comm = this->simulator_.gridView().comm();
+        auto stats = IsatTable::globalStatistics(comm, isatTable_->statistics());
+        if (comm.rank() == 0) {
+            std::cout << "Flash tabulation:\n";
+            IsatTable::printStatistics(std::cout, stats);
+            std::cout << std::flush;
+        }
     }
 
     /*!
@@ -331,6 +529,100 @@ public:
         if (enableEnergy)
             this->addOutputModule(new Opm::VtkEnergyModule<TypeTag>(this->simulator_));
     }
+
+private:
+    struct BatchedFlashResult
+    {
+        ScalarComponentVector cTotal;
+        Scalar temperature{0.0};
+        BatchedFlashFluidState fluidState;
+
+        // the fluid state can be used as the initial guess for the next batched flash
+        bool hasInitialGuess{false};
+
+        // the fluid state is the result for cTotal and temperature
+        bool isConverged{false};
+    };
+
+    struct BatchedFlashLanes
+    {
+        std::array<BatchedFlashFluidState, flashBatchSize> fluidStates;
+        std::array<MaterialLawParams, flashBatchSize> materialParams;
+        std::array<ScalarComponentVector, flashBatchSize> cTotal;
+        std::array<unsigned, flashBatchSize> globalIdx;
+        unsigned numLanes{0};
+    };
+
+    void addBatchedFlashLane_(BatchedFlashLanes& lanes,
+                              const ElementContext& elemCtx,
+                              unsigned dofIdx,
+                              unsigned globalIdx) const
+    {
+        const auto& priVars = this->solution(/*timeIdx=*/0)[globalIdx];
+        const auto& problem = elemCtx.problem();
+
+        ScalarComponentVector cTotal;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            cTotal[compIdx] = priVars[Indices::cTot0Idx + compIdx];
+
+        Scalar T;
+        if constexpr (enableEnergy)
+            T = priVars[Indices::temperatureIdx];
+        else
+            T = problem.temperature(elemCtx, dofIdx, /*timeIdx=*/0);
+
+        const auto& result = batchedFlashResults_[globalIdx];
+        if (result.isConverged && result.cTotal == cTotal && result.temperature == T)
+            // the intensive quantities were invalidated, but the solution did not change
+            return;
+
+        unsigned laneIdx = lanes.numLanes++;
+        auto& fs = lanes.fluidStates[laneIdx];
+        fs.setTemperature(T);
+        if (result.hasInitialGuess) {
+            fs = result.fluidState;
+            fs.setTemperature(T);
+        }
+        else
+            FlashSolver::guessInitial(fs, cTotal);
+
+        // the parameters are copied because problems are not required to return
+        // references which stay valid for other elements
+        lanes.materialParams[laneIdx] = problem.materialLawParams(elemCtx, dofIdx, /*timeIdx=*/0);
+        lanes.cTotal[laneIdx] = cTotal;
+        lanes.globalIdx[laneIdx] = globalIdx;
+    }
+
+    void solveBatchedFlashLanes_(BatchedFlashLanes& lanes)
+    {
+        std::array<const MaterialLawParams*, flashBatchSize> materialParams;
+        for (unsigned laneIdx = 0; laneIdx < flashBatchSize; ++laneIdx)
+            materialParams[laneIdx] = &lanes.materialParams[laneIdx];
+
+        auto converged = BatchedFlash::template solve<MaterialLaw>(lanes.fluidStates,
+                                                                   materialParams,
+                                                                   lanes.cTotal,
+                                                                   lanes.numLanes,
+                                                                   flashTolerance_);
+
+        for (unsigned laneIdx = 0; laneIdx < lanes.numLanes; ++laneIdx) {
+            auto& result = batchedFlashResults_[lanes.globalIdx[laneIdx]];
+            result.cTotal = lanes.cTotal[laneIdx];
+            result.temperature = lanes.fluidStates[laneIdx].temperature(/*phaseIdx=*/0);
+            result.fluidState = lanes.fluidStates[laneIdx];
+            result.hasInitialGuess = true;
+            result.isConverged = converged[laneIdx];
+        }
+
+        lanes.numLanes = 0;
+    }
+
+    std::unique_ptr<IsatTable> isatTable_;
+
+    bool enableBatchedFlash_;
+    Scalar flashTolerance_;
+    std::vector<BatchedFlashResult> batchedFlashResults_;
+    std::vector<unsigned char> batchedFlashClaimed_;
 };
 
 } // namespace Opm
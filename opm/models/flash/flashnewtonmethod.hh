@@ -0,0 +1,83 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::FlashNewtonMethod
+ */
+#ifndef EWOMS_FLASH_NEWTON_METHOD_HH
+#define EWOMS_FLASH_NEWTON_METHOD_HH
+
+#include "flashproperties.hh"
+
+#include <opm/models/nonlinear/newtonmethod.hh>
+
+namespace Opm::Properties {
+
+template <class TypeTag, class MyTypeTag>
+struct DiscNewtonMethod;
+
+} // namespace Opm::Properties
+
+namespace Opm {
+
+/*!
+ * \ingroup FlashModel
+ *
+ * \brief A Newton solver specific to the flash model.
+ *
+ * Before the system of equations is linearized, the flashes of all degrees of freedom
+ * whose intensive quantities need to be updated are solved in batches.
+ */
+template <class TypeTag>
+class FlashNewtonMethod : public GetPropType<TypeTag, Properties::DiscNewtonMethod>
+{
+    using ParentType = GetPropType<TypeTag, Properties::DiscNewtonMethod>;
+
+    using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+
+public:
+    /*!
+     * \copydoc FvBaseNewtonMethod::FvBaseNewtonMethod(Problem& )
+     */
+    FlashNewtonMethod(Simulator& simulator) : ParentType(simulator)
+    {}
+
+protected:
+    friend ParentType;
+    friend NewtonMethod<TypeTag>;
+
+    /*!
+     * \copydoc FvBaseNewtonMethod::beginIteration_
+     */
+    void beginIteration_()
+    {
+        ParentType::beginIteration_();
+
+        this->model().solveFlashesBatched();
+    }
+};
+
+} // namespace Opm
+
+#endif
@@ -43,6 +43,12 @@ struct FlashSolver { using type = UndefinedProperty; };
 //! The maximum accepted error of the flash solver
 template<class TypeTag, class MyTypeTag>
 struct FlashTolerance { using type = UndefinedProperty; };
+//! Solve the flashes of the cells in batches at the beginning of each Newton iteration
+template<class TypeTag, class MyTypeTag>
+struct EnableBatchedFlash { using type = UndefinedProperty; };
+//! The number of cells whose flashes are solved in lockstep by the batched flash solver
+template<class TypeTag, class MyTypeTag>
+struct FlashBatchSize { using type = UndefinedProperty; };
 
 } // namespace Opm::Properties
 
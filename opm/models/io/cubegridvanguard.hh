@@ -34,6 +34,12 @@
 
 #include <dune/grid/utility/structuredgridfactory.hh>
 
+#if HAVE_DUNE_ALUGRID
+// make sure that the structured grid factory specialized for ALUGrid is used, which
+// creates the macro grid of each process in parallel
+#include <dune/alugrid/common/structuredgridfactory.hh>
+#endif
+
 #include <dune/common/fvector.hh>
 
 #include <memory>
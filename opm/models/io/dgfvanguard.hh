@@ -180,6 +180,8 @@ protected:
                     fractureMapper_.addFractureEdge(vertexIndices[0], vertexIndices[1]);
             }
         }
+
+        fractureMapper_.finalize();
     }
 
 private:
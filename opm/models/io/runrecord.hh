@@ -0,0 +1,118 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::RunRecord
+ */
+#ifndef EWOMS_RUN_RECORD_HH
+#define EWOMS_RUN_RECORD_HH
+
+#include <sys/resource.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \ingroup InputOutput
+ *
+ * \brief Summarizes the performance of a simulation run in a machine-readable form.
+ *
+ * A run record consists of the name of the simulation and a flat list of named
+ * quantities, e.g., the time spent in the phases of the simulation or the number of
+ * iterations of the solvers. It is written as a JSON object with one quantity per line,
+ * so that it can be compared with the record of a previous run by simple tools (see
+ * bin/compareperf.sh).
+ */
+class RunRecord
+{
+public:
+    explicit RunRecord(const std::string& name)
+        : name_(name)
+    {}
+
+    /*!
+     * \brief Add a quantity to the record.
+     */
+    void add(const std::string& key, double value)
+    { values_.emplace_back(key, value); }
+
+    /*!
+     * \brief Write the record to a stream.
+     */
+    void write(std::ostream& os) const
+    {
+        os << "{\n  \"name\": \"" << name_ << "\"";
+        for (const auto& [key, value] : values_) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.9g", value);
+            os << ",\n  \"" << key << "\": " << buf;
+        }
+        os << "\n}\n";
+    }
+
+    /*!
+     * \brief Write the record to a file.
+     */
+    void write(const std::string& fileName) const
+    {
+        std::ofstream os(fileName);
+        if (!os)
+            throw std::runtime_error("Could not open file '"+fileName+"' to write the run record");
+        write(os);
+    }
+
+    /*!
+     * \brief Returns the largest amount of physical memory in bytes which has been used
+     *        by the calling process so far.
+     */
+    static std::size_t peakResidentSetSize()
+    {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+#ifdef __APPLE__
+        // macOS reports bytes...
+        return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+        // ... Linux and the BSDs kilobytes
+        return static_cast<std::size_t>(usage.ru_maxrss)*1024;
+#endif
+    }
+
+private:
+    std::string name_;
+    std::vector<std::pair<std::string, double> > values_;
+};
+
+} // namespace Opm
+
+#endif
@@ -32,18 +32,21 @@
 #include <opm/models/utils/parametersystem.hh>
 
 #include <dune/grid/yaspgrid.hh>
-#include <dune/grid/io/file/dgfparser/dgfyasp.hh>
+#include <dune/grid/utility/structuredgridfactory.hh>
 
 #if HAVE_DUNE_ALUGRID
 #include <dune/alugrid/grid.hh>
-#include <dune/alugrid/dgf.hh>
+#include <dune/alugrid/common/structuredgridfactory.hh>
 #endif
 
 #include <dune/common/fvector.hh>
 #include <dune/common/version.hh>
 
-#include <vector>
+#include <array>
+#include <bitset>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace Opm {
 
@@ -133,37 +136,41 @@ public:
     StructuredGridVanguard(Simulator& simulator)
         : ParentType(simulator)
     {
-        Dune::FieldVector<int, dim> cellRes;
+        std::array<unsigned, dim> cellRes;
 
         using GridScalar = double;
         Dune::FieldVector<GridScalar, dim> upperRight;
         Dune::FieldVector<GridScalar, dim> lowerLeft( 0 );
 
         upperRight[0] = EWOMS_GET_PARAM(TypeTag, Scalar, DomainSizeX);
-        upperRight[1] = EWOMS_GET_PARAM(TypeTag, Scalar, DomainSizeY);
-
         cellRes[0] = EWOMS_GET_PARAM(TypeTag, unsigned, CellsX);
-        cellRes[1] = EWOMS_GET_PARAM(TypeTag, unsigned, CellsY);
-        if (dim == 3) {
+        if (dim > 1) {
+            upperRight[1] = EWOMS_GET_PARAM(TypeTag, Scalar, DomainSizeY);
+            cellRes[1] = EWOMS_GET_PARAM(TypeTag, unsigned, CellsY);
+        }
+        if (dim > 2) {
             upperRight[2] = EWOMS_GET_PARAM(TypeTag, Scalar, DomainSizeZ);
             cellRes[2] = EWOMS_GET_PARAM(TypeTag, unsigned, CellsZ);
         }
 
-        std::stringstream dgffile;
-        dgffile << "DGF" << std::endl;
-        dgffile << "INTERVAL" << std::endl;
-        dgffile << lowerLeft  << std::endl;
-        dgffile << upperRight << std::endl;
-        dgffile << cellRes    << std::endl;
-        dgffile << "#" << std::endl;
-        dgffile << "GridParameter" << std::endl;
-        dgffile << "overlap 1" << std::endl;
-        dgffile << "#" << std::endl;
-        dgffile << "Simplex" << std::endl;
-        dgffile << "#" << std::endl;
-
-        // use DGF parser to create a grid from interval block
-        gridPtr_.reset( Dune::GridPtr< Grid >( dgffile ).release() );
+        // create the grid directly instead of writing an INTERVAL block to a DGF
+        // description and parsing it again. YaspGrid is structured by construction and
+        // partitions itself amongst the processes, for all other grids (ALUGrid in
+        // particular) the structured grid factory specialized for the grid manager is
+        // used. For ALUGrid, this factory creates the macro elements of each process'
+        // partition in parallel.
+        if constexpr (std::is_same_v<Grid, Dune::YaspGrid<dim>>) {
+            std::array<int, dim> yaspCellRes;
+            for (unsigned i = 0; i < dim; ++i)
+                yaspCellRes[i] = static_cast<int>(cellRes[i]);
+
+            gridPtr_.reset(new Grid(upperRight,
+                                    yaspCellRes,
+                                    /*periodic=*/std::bitset<dim>(),
+                                    /*overlap=*/1));
+        }
+        else
+            gridPtr_ = Dune::StructuredGridFactory<Grid>::createCubeGrid(lowerLeft, upperRight, cellRes);
 
         unsigned numRefinements = EWOMS_GET_PARAM(TypeTag, unsigned, GridGlobalRefinements);
         gridPtr_->globalRefine(static_cast<int>(numRefinements));
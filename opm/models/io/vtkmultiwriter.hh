@@ -45,8 +45,11 @@
 #include <mpi.h>
 #endif
 
+#include <algorithm>
+#include <cstddef>
 #include <filesystem>
 #include <list>
+#include <vector>
 #include <string>
 #include <limits>
 #include <sstream>
@@ -99,8 +102,50 @@ class VtkMultiWriter : public BaseOutputWriter
 
     enum { dim = GridView::dimension };
 
-    using VertexMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
-    using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using BaseMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using Index = typename BaseMapper::Index;
+
+    // the mapper of the grid with an optional permutation of the indices. this is
+    // required to write buffers which are indexed by renumbered mappers.
+    class PermutedMapper
+    {
+    public:
+        PermutedMapper(const GridView& gridView, const Dune::MCMGLayout& layout)
+            : baseMapper_(gridView, layout)
+        {}
+
+        template <class EntityType>
+        Index index(const EntityType& e) const
+        { return permute_(baseMapper_.index(e)); }
+
+        template <class Element>
+        Index subIndex(const Element& e, int i, unsigned int codim) const
+        { return permute_(baseMapper_.subIndex(e, i, codim)); }
+
+        auto size() const
+        { return baseMapper_.size(); }
+
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
+        void update(const GridView& gridView)
+        { baseMapper_.update(gridView); }
+#else
+        void update()
+        { baseMapper_.update(); }
+#endif
+
+        void setPermutation(const std::vector<Index>* permutation)
+        { permutation_ = permutation; }
+
+    private:
+        Index permute_(Index idx) const
+        { return permutation_ ? (*permutation_)[idx] : idx; }
+
+        BaseMapper baseMapper_;
+        const std::vector<Index>* permutation_{nullptr};
+    };
+
+    using VertexMapper = PermutedMapper;
+    using ElementMapper = PermutedMapper;
 
 public:
     using Scalar = BaseOutputWriter::Scalar;
@@ -148,6 +193,21 @@ public:
             multiFile_.close();
     }
 
+    /*!
+     * \brief Specify the permutations of the indices of the buffers.
+     *
+     * This is required if the buffers are indexed by mappers which renumber the
+     * entities of the grid (see RenumberedMapper). The permutations map the indices of
+     * the grid's mappers to the ones of the buffers and must exist as long as the
+     * writer. A null pointer means that the buffers are indexed by the grid's mappers.
+     */
+    void setPermutations(const std::vector<Index>* elementPermutation,
+                         const std::vector<Index>* vertexPermutation)
+    {
+        elementMapper_.setPermutation(elementPermutation);
+        vertexMapper_.setPermutation(vertexPermutation);
+    }
+
     /*!
      * \brief Returns the number of the current VTK file.
      */
@@ -203,6 +263,7 @@ public:
     {
         ScalarBuffer *buf = new ScalarBuffer(numEntities);
         managedScalarBuffers_.push_back(buf);
+        addManagedBufferSize_(numEntities*sizeof(double));
         return buf;
     }
 
@@ -219,9 +280,17 @@ public:
             (*buf)[i].resize(numInner);
 
         managedVectorBuffers_.push_back(buf);
+        addManagedBufferSize_(numOuter*(sizeof((*buf)[0]) + numInner*sizeof(double)));
         return buf;
     }
 
+    /*!
+     * \brief Returns the largest number of bytes which have been occupied by the managed
+     *        buffers of a single output file so far.
+     */
+    std::size_t peakManagedBufferSize() const
+    { return peakManagedBufferSize_; }
+
     /*!
      * \brief Add a finished vertex centered vector field to the
      *        output.
@@ -540,6 +609,13 @@ private:
             delete managedVectorBuffers_.front();
             managedVectorBuffers_.pop_front();
         }
+        managedBufferSize_ = 0;
+    }
+
+    void addManagedBufferSize_(std::size_t bytes)
+    {
+        managedBufferSize_ += bytes;
+        peakManagedBufferSize_ = std::max(peakManagedBufferSize_, managedBufferSize_);
     }
 
     const GridView gridView_;
@@ -561,6 +637,8 @@ private:
 
     std::list<ScalarBuffer *> managedScalarBuffers_;
     std::list<VectorBuffer *> managedVectorBuffers_;
+    std::size_t managedBufferSize_{0};
+    std::size_t peakManagedBufferSize_{0};
 
     TaskletRunner taskletRunner_;
 };
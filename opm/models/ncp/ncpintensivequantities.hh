@@ -37,10 +37,14 @@
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
 #include <opm/material/constraintsolvers/CompositionFromFugacities.hpp>
 #include <opm/material/common/Valgrind.hpp>
+#include <opm/material/densead/Evaluation.hpp>
 
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
 
+#include <array>
+#include <chrono>
+
 namespace Opm {
 /*!
  * \ingroup NcpModel
@@ -81,6 +85,7 @@ class NcpIntensiveQuantities
     using CompositionFromFugacitiesSolver = Opm::CompositionFromFugacities<Scalar, FluidSystem, Evaluation>;
     using FluidState = Opm::CompositionalFluidState<Evaluation, FluidSystem, /*storeEnthalpy=*/enableEnergy>;
     using ComponentVector = Dune::FieldVector<Evaluation, numComponents>;
+    using Toolbox = MathToolbox<Evaluation>;
     using DimMatrix = Dune::FieldMatrix<Scalar, dimWorld, dimWorld>;
     using DiffusionIntensiveQuantities = Opm::DiffusionIntensiveQuantities<TypeTag, enableDiffusion>;
     using EnergyIntensiveQuantities = Opm::EnergyIntensiveQuantities<TypeTag, enableEnergy>;
@@ -140,6 +145,13 @@ public:
         // calculate phase compositions
         const auto *hint = elemCtx.thermodynamicHint(dofIdx, timeIdx);
         for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            if (auto* isatTable = elemCtx.model().isatTable(phaseIdx)) {
+                // look up the phase composition in the table of previous results
+                tabulatedComposition_(*isatTable, phaseIdx, fug, hint);
+                paramCache.updatePhase(fluidState_, phaseIdx);
+                continue;
+            }
+
             // initial guess
             if (hint) {
                 for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
@@ -233,6 +245,95 @@ public:
     }
 
 private:
+    // determine the composition of a fluid phase using the in-situ adaptive tabulation
+    // of the model
+    template <class IsatTable, class IntensiveQuantities>
+    void tabulatedComposition_(IsatTable& isatTable,
+                               unsigned phaseIdx,
+                               const ComponentVector& fug,
+                               const IntensiveQuantities* hint)
+    {
+        using InputVector = typename IsatTable::InputVector;
+        using OutputVector = typename IsatTable::OutputVector;
+        using Jacobian = typename IsatTable::Jacobian;
+
+        // the inputs are the temperature, the pressure of the phase and the fugacities
+        // of the components
+        constexpr unsigned numInputs = numComponents + 2;
+
+        std::array<Evaluation, numInputs> inputs;
+        inputs[0] = fluidState_.temperature(phaseIdx);
+        inputs[1] = fluidState_.pressure(phaseIdx);
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            inputs[2 + compIdx] = fug[compIdx];
+
+        InputVector x;
+        for (unsigned j = 0; j < numInputs; ++j)
+            x[j] = Toolbox::value(inputs[j]);
+
+        InputVector x0;
+        OutputVector f0;
+        Jacobian A;
+        if (!isatTable.retrieve(x, x0, f0, A)) {
+            auto startTime = std::chrono::steady_clock::now();
+
+            // solve for the composition using an evaluation whose derivatives are the
+            // sensitivities of the results to the inputs
+            using IsatEvaluation = DenseAd::Evaluation<Scalar, numInputs>;
+            using IsatFluidState = CompositionalFluidState<IsatEvaluation, FluidSystem, /*storeEnthalpy=*/false>;
+            using IsatSolver = CompositionFromFugacities<Scalar, FluidSystem, IsatEvaluation>;
+
+            IsatFluidState fs;
+            fs.setTemperature(IsatEvaluation::createVariable(x[0], 0));
+            fs.setPressure(phaseIdx, IsatEvaluation::createVariable(x[1], 1));
+            fs.setSaturation(phaseIdx, Toolbox::value(fluidState_.saturation(phaseIdx)));
+
+            Dune::FieldVector<IsatEvaluation, numComponents> isatFug;
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                isatFug[compIdx] = IsatEvaluation::createVariable(x[2 + compIdx], 2 + compIdx);
+
+            if (hint) {
+                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                    fs.setMoleFraction(phaseIdx, compIdx,
+                                       Toolbox::value(hint->fluidState().moleFraction(phaseIdx, compIdx)));
+            }
+            else
+                IsatSolver::guessInitial(fs, phaseIdx, isatFug);
+
+            typename FluidSystem::template ParameterCache<IsatEvaluation> paramCache;
+            IsatSolver::solve(fs, paramCache, phaseIdx, isatFug);
+
+            auto setOutput = [&f0, &A](unsigned outIdx, const IsatEvaluation& value) {
+                f0[outIdx] = value.value();
+                for (unsigned j = 0; j < numInputs; ++j)
+                    A[outIdx][j] = value.derivative(j);
+            };
+            setOutput(0, fs.density(phaseIdx));
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                setOutput(1 + 2*compIdx, fs.moleFraction(phaseIdx, compIdx));
+                setOutput(2 + 2*compIdx, fs.fugacityCoefficient(phaseIdx, compIdx));
+            }
+            x0 = x;
+
+            std::chrono::duration<double> dt = std::chrono::steady_clock::now() - startTime;
+            isatTable.add(x, f0, A, dt.count());
+        }
+
+        // linearly extrapolate the record. by the chain rule, this also yields the
+        // derivatives of the results w.r.t. the primary variables.
+        auto output = [&](unsigned outIdx) {
+            Evaluation result = f0[outIdx];
+            for (unsigned j = 0; j < numInputs; ++j)
+                result += A[outIdx][j]*(inputs[j] - x0[j]);
+            return result;
+        };
+        fluidState_.setDensity(phaseIdx, output(0));
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            fluidState_.setMoleFraction(phaseIdx, compIdx, output(1 + 2*compIdx));
+            fluidState_.setFugacityCoefficient(phaseIdx, compIdx, output(2 + 2*compIdx));
+        }
+    }
+
     DimMatrix intrinsicPerm_;
     FluidState fluidState_;
     Evaluation porosity_;
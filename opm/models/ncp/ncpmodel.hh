@@ -48,11 +48,14 @@
 #include <opm/models/io/vtkcompositionmodule.hh>
 #include <opm/models/io/vtkenergymodule.hh>
 #include <opm/models/io/vtkdiffusionmodule.hh>
+#include <opm/models/utils/isattable.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 
 #include <dune/common/fvector.hh>
 
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -254,9 +257,43 @@ class NcpModel
     using DiffusionModule = Opm::DiffusionModule<TypeTag, enableDiffusion>;
 
 public:
+    /*!
+     * \brief The table used to tabulate the compositions of a fluid phase.
+     *
+     * The inputs are the temperature, the pressure of the phase and the fugacities of
+     * all components. The outputs are the density of the phase and the mole fractions
+     * and fugacity coefficients of all components.
+     */
+    using IsatTable = Opm::IsatTable<Scalar, numComponents + 2, 1 + 2*numComponents>;
+
     NcpModel(Simulator& simulator)
         : ParentType(simulator)
-    {}
+    {
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableIsat)) {
+            typename IsatTable::InputVector inputScales;
+            inputScales[0] = 1.0; // temperature [K]
+            inputScales[1] = 1e3; // pressure [Pa]
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                inputScales[2 + compIdx] = 1.0; // fugacity [Pa]
+
+            typename IsatTable::OutputVector outputScales;
+            outputScales[0] = 1.0; // density [kg/m^3]
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                outputScales[1 + 2*compIdx] = 1.0; // mole fraction
+                outputScales[2 + 2*compIdx] = 1e-10; // fugacity coefficient
+            }
+
+            std::size_t memoryBudget =
+                static_cast<std::size_t>(EWOMS_GET_PARAM(TypeTag, int, IsatMemoryBudget))*1024*1024;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                isatTables_[phaseIdx] =
+                    std::make_unique<IsatTable>(EWOMS_GET_PARAM(TypeTag, Scalar, IsatTolerance),
+                                                EWOMS_GET_PARAM(TypeTag, Scalar, IsatBinWidth),
+                                                memoryBudget/numPhases,
+                                                inputScales,
+                                                outputScales);
+        }
+    }
 
     /*!
      * \brief Register all run-time parameters for the immiscible model.
@@ -276,6 +313,46 @@ public:
 
         if (enableEnergy)
             VtkEnergyModule<TypeTag>::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIsat,
+                             "Tabulate the phase compositions using in-situ adaptive "
+                             "tabulation");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IsatTolerance,
+                             "The maximum scaled error of phase compositions taken from the table");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IsatBinWidth,
+                             "The relative width of the bins of the composition tables");
+        EWOMS_REGISTER_PARAM(TypeTag, int, IsatMemoryBudget,
+                             "The maximum amount of memory used by the composition tables [MB]");
+    }
+
+    /*!
+     * \brief Returns the table of the compositions of a fluid phase or nullptr if
+     *        tabulation is disabled.
+     */
+    IsatTable* isatTable(unsigned phaseIdx) const
+    { return isatTables_[phaseIdx].get(); }
+
+    /*!
+     * \copydoc FvBaseDiscretization::finalize
+     */
+    void finalize()
+    {
+        ParentType::finalize();
+
+        if (!isatTables_[0])
+            return;
+
+        const auto& comm = this->simulator_.gridView().comm();
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            auto stats = IsatTable::globalStatistics(comm, isatTables_[phaseIdx]->statistics());
+            if (comm.rank() == 0) {
+                std::cout << "Composition tabulation of phase '"
+                          << FluidSystem::phaseName(phaseIdx) << "':\n";
+                IsatTable::printStatistics(std::cout, stats);
+            }
+        }
+        if (comm.rank() == 0)
+            std::cout << std::flush;
     }
 
     /*!
@@ -477,6 +554,9 @@ public:
 
     mutable Scalar referencePressure_;
     mutable std::vector<ComponentVector> minActivityCoeff_;
+
+private:
+    std::array<std::unique_ptr<IsatTable>, numPhases> isatTables_;
 };
 
 } // namespace Opm
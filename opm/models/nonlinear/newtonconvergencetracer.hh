@@ -0,0 +1,442 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::NewtonConvergenceTracer
+ */
+#ifndef EWOMS_NEWTON_CONVERGENCE_TRACER_HH
+#define EWOMS_NEWTON_CONVERGENCE_TRACER_HH
+
+#include "newtonmethodproperties.hh"
+
+#include <opm/models/discretization/common/fvbaseproperties.hh>
+#include <opm/models/utils/parametersystem.hh>
+#include <opm/models/utils/propertysystem.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm {
+/*!
+ * \ingroup Newton
+ *
+ * \brief Records the convergence behaviour of the Newton method in a compact binary
+ *        trace file.
+ *
+ * In contrast to the convergence writer, which writes a full VTK file for each Newton
+ * iteration, this class only records a few numbers per iteration. It is thus cheap
+ * enough to be enabled for production runs. For each Newton iteration, the following is
+ * recorded:
+ *
+ * - the weighted residual of each equation in the L2 and the maximum norms,
+ * - the maximum and the L2 norm of the update of each primary variable,
+ * - the number of degrees of freedom for which the meaning of the primary variables
+ *   was switched (or -1 if the Newton method does not provide this information),
+ * - the degrees of freedom exhibiting the largest weighted residuals and
+ * - optionally, the weighted residuals of all degrees of freedom where it exceeds a
+ *   given threshold.
+ *
+ * Each process writes its own file named "$OUTPUT_DIR/$PROBLEM_NAME.newtontrace" (with
+ * "-$RANK" appended for parallel runs). All indices of degrees of freedom are local to
+ * the process. The file starts with the header
+ *
+ * \code
+ * char[8] magic ("EWNWTTRC"); uint32 version; uint32 numEq; uint32 rank;
+ * uint32 numProcesses; uint32 numWorstDofs; double dumpThreshold
+ * \endcode
+ *
+ * which is followed by a sequence of records which are introduced by an uint32 that
+ * specifies their type:
+ *
+ * \code
+ * 1: uint32 timeStepIdx; double time; double timeStepSize
+ * 2: uint32 timeStepIdx; uint32 iterationIdx; double error; int32 numPriVarsSwitched;
+ *    uint32 flags (1: has residual, 2: has update);
+ *    double residualL2[numEq]; double residualMax[numEq];
+ *    double updateL2[numEq]; double updateMax[numEq];
+ *    uint32 n; n times { uint32 dofIdx; double weightedResidual[numEq] }  (worst DOFs)
+ *    uint32 m; m times { uint32 dofIdx; double weightedResidual[numEq] }  (dumped DOFs)
+ * 3: uint32 timeStepIdx; uint32 converged; uint32 numIterations
+ * \endcode
+ *
+ * All values are stored using the native byte order.
+ */
+template <class TypeTag>
+class NewtonConvergenceTracer
+{
+    using NewtonMethod = GetPropType<TypeTag, Properties::NewtonMethod>;
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using GlobalEqVector = GetPropType<TypeTag, Properties::GlobalEqVector>;
+
+    enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
+
+    enum : uint32_t {
+        timeStepBeginRecord = 1,
+        iterationRecord = 2,
+        timeStepEndRecord = 3
+    };
+
+    enum : uint32_t {
+        hasResidualFlag = 1,
+        hasUpdateFlag = 2
+    };
+
+    using EqArray = std::array<double, numEq>;
+
+    struct DofEntry
+    {
+        uint32_t dofIdx;
+        double maxValue;
+        EqArray values;
+
+        // used to maintain a min-heap of the worst degrees of freedom
+        bool operator<(const DofEntry& other) const
+        { return maxValue > other.maxValue; }
+    };
+
+public:
+    static constexpr uint32_t formatVersion = 1;
+
+    NewtonConvergenceTracer(NewtonMethod& nm)
+        : newtonMethod_(nm)
+    {
+        enabled_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonTraceConvergence);
+        numWorstDofs_ = static_cast<unsigned>(std::max(0, EWOMS_GET_PARAM(TypeTag, int, NewtonTraceWorstDofs)));
+        dumpThreshold_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonTraceDumpThreshold);
+        worstDofs_.reserve(numWorstDofs_);
+    }
+
+    /*!
+     * \brief Register all run-time parameters for the convergence tracer.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonTraceConvergence,
+                             "Record the convergence behaviour of the Newton method "
+                             "in a compact binary trace file");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonTraceWorstDofs,
+                             "The number of degrees of freedom with the largest "
+                             "residuals which are recorded for each Newton iteration");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonTraceDumpThreshold,
+                             "The weighted residual above which the residual of a "
+                             "degree of freedom is recorded in the Newton trace. "
+                             "Values smaller or equal to zero disable this");
+    }
+
+    /*!
+     * \brief Returns true iff the convergence behaviour ought to be recorded.
+     */
+    bool enabled() const
+    { return enabled_; }
+
+    /*!
+     * \brief Called by the Newton method before the actual algorithm is started for any
+     *        given time step.
+     */
+    void beginTimeStep()
+    {
+        if (!enabled_)
+            return;
+
+        if (!outStream_.is_open())
+            openFile_();
+
+        const auto& simulator = newtonMethod_.problem().simulator();
+        recordBuffer_.clear();
+        append_(uint32_t(timeStepBeginRecord));
+        append_(uint32_t(simulator.timeStepIndex()));
+        append_(double(simulator.time()));
+        append_(double(simulator.timeStepSize()));
+        writeRecord_();
+
+        iterationPending_ = false;
+    }
+
+    /*!
+     * \brief Called by the Newton method before an iteration is started.
+     */
+    void beginIteration()
+    {
+        if (!enabled_)
+            return;
+
+        flags_ = 0;
+        residualL2_.fill(0.0);
+        residualMax_.fill(0.0);
+        updateL2_.fill(0.0);
+        updateMax_.fill(0.0);
+        worstDofs_.clear();
+        dumpBuffer_.clear();
+        numDumpedDofs_ = 0;
+        iterationPending_ = true;
+    }
+
+    /*!
+     * \brief Record the residual of the current Newton iteration.
+     *
+     * \param residual The global residual at the beginning of the iteration
+     */
+    void recordResidual(const GlobalEqVector& residual)
+    {
+        if (!enabled_)
+            return;
+
+        const auto& model = newtonMethod_.model();
+        const auto& constraintsMap = model.linearizer().constraintsMap();
+        unsigned numGridDof = model.numGridDof();
+        EqArray weightedResid;
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            // like for the error of the Newton method, do not consider auxiliary and
+            // constraint degrees of freedom
+            if (model.dofTotalVolume(dofIdx) <= 0.0)
+                continue;
+            if (enableConstraints_() && constraintsMap.count(dofIdx) > 0)
+                continue;
+
+            const auto& r = residual[dofIdx];
+            double dofMax = 0.0;
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                double w = std::abs(static_cast<double>(r[eqIdx]*model.eqWeight(dofIdx, eqIdx)));
+                weightedResid[eqIdx] = w;
+                residualL2_[eqIdx] += w*w;
+                residualMax_[eqIdx] = std::max(residualMax_[eqIdx], w);
+                dofMax = std::max(dofMax, w);
+            }
+
+            if (numWorstDofs_ > 0)
+                considerWorstDof_(dofIdx, dofMax, weightedResid);
+
+            if (dumpThreshold_ > 0.0 && dofMax > dumpThreshold_) {
+                append_(dumpBuffer_, uint32_t(dofIdx));
+                append_(dumpBuffer_, weightedResid);
+                ++numDumpedDofs_;
+            }
+        }
+
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            residualL2_[eqIdx] = std::sqrt(residualL2_[eqIdx]);
+
+        flags_ |= hasResidualFlag;
+    }
+
+    /*!
+     * \brief Record the update of the primary variables of the current Newton iteration.
+     *
+     * \param solutionUpdate The negative difference between the solution vectors of the
+     *                       current and of the next iteration
+     */
+    void recordUpdate(const GlobalEqVector& solutionUpdate)
+    {
+        if (!enabled_)
+            return;
+
+        unsigned numGridDof = newtonMethod_.model().numGridDof();
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            const auto& du = solutionUpdate[dofIdx];
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                double d = std::abs(static_cast<double>(du[pvIdx]));
+                updateL2_[pvIdx] += d*d;
+                updateMax_[pvIdx] = std::max(updateMax_[pvIdx], d);
+            }
+        }
+
+        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+            updateL2_[pvIdx] = std::sqrt(updateL2_[pvIdx]);
+
+        flags_ |= hasUpdateFlag;
+    }
+
+    /*!
+     * \brief Called by the Newton method after an iteration has been completed.
+     *
+     * \param iterationIdx The index of the iteration which has been completed
+     * \param error The error of the Newton method for this iteration
+     */
+    void endIteration(unsigned iterationIdx, Scalar error)
+    {
+        if (!enabled_ || !iterationPending_)
+            return;
+
+        writeIteration_(iterationIdx, error);
+    }
+
+    /*!
+     * \brief Called by the Newton method after it has finished for a given time step.
+     *
+     * If the Newton method was aborted in the middle of an iteration, the data recorded
+     * for this iteration is written as well.
+     *
+     * \param converged Specifies whether the Newton method converged
+     * \param error The most recent error of the Newton method
+     */
+    void endTimeStep(bool converged, Scalar error)
+    {
+        if (!enabled_)
+            return;
+
+        unsigned numIterations = static_cast<unsigned>(newtonMethod_.numIterations());
+        if (iterationPending_)
+            writeIteration_(numIterations + 1, error);
+
+        const auto& simulator = newtonMethod_.problem().simulator();
+        recordBuffer_.clear();
+        append_(uint32_t(timeStepEndRecord));
+        append_(uint32_t(simulator.timeStepIndex()));
+        append_(uint32_t(converged));
+        append_(uint32_t(numIterations));
+        writeRecord_();
+
+        outStream_.flush();
+    }
+
+private:
+    void openFile_()
+    {
+        const auto& problem = newtonMethod_.problem();
+        const auto& comm = problem.gridView().comm();
+
+        std::string fileName = problem.outputDir() + "/" + problem.name();
+        if (comm.size() > 1)
+            fileName += "-" + std::to_string(comm.rank());
+        fileName += ".newtontrace";
+
+        outStream_.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!outStream_)
+            throw std::runtime_error("Could not open Newton convergence trace file '"
+                                     + fileName + "'");
+
+        recordBuffer_.clear();
+        const char magic[8] = { 'E', 'W', 'N', 'W', 'T', 'T', 'R', 'C' };
+        recordBuffer_.insert(recordBuffer_.end(), magic, magic + sizeof(magic));
+        append_(formatVersion);
+        append_(uint32_t(numEq));
+        append_(uint32_t(comm.rank()));
+        append_(uint32_t(comm.size()));
+        append_(uint32_t(numWorstDofs_));
+        append_(double(dumpThreshold_));
+        writeRecord_();
+    }
+
+    void considerWorstDof_(unsigned dofIdx, double dofMax, const EqArray& values)
+    {
+        if (worstDofs_.size() < numWorstDofs_) {
+            worstDofs_.push_back(DofEntry{static_cast<uint32_t>(dofIdx), dofMax, values});
+            std::push_heap(worstDofs_.begin(), worstDofs_.end());
+        }
+        else if (dofMax > worstDofs_.front().maxValue) {
+            std::pop_heap(worstDofs_.begin(), worstDofs_.end());
+            worstDofs_.back() = DofEntry{static_cast<uint32_t>(dofIdx), dofMax, values};
+            std::push_heap(worstDofs_.begin(), worstDofs_.end());
+        }
+    }
+
+    void writeIteration_(unsigned iterationIdx, Scalar error)
+    {
+        const auto& simulator = newtonMethod_.problem().simulator();
+
+        // the worst degrees of freedom come first
+        std::sort_heap(worstDofs_.begin(), worstDofs_.end());
+
+        recordBuffer_.clear();
+        append_(uint32_t(iterationRecord));
+        append_(uint32_t(simulator.timeStepIndex()));
+        append_(uint32_t(iterationIdx));
+        append_(double(error));
+        append_(int32_t(numPriVarsSwitched_(newtonMethod_, 0)));
+        append_(uint32_t(flags_));
+        append_(residualL2_);
+        append_(residualMax_);
+        append_(updateL2_);
+        append_(updateMax_);
+        append_(uint32_t(worstDofs_.size()));
+        for (const auto& entry : worstDofs_) {
+            append_(entry.dofIdx);
+            append_(entry.values);
+        }
+        append_(uint32_t(numDumpedDofs_));
+        recordBuffer_.insert(recordBuffer_.end(), dumpBuffer_.begin(), dumpBuffer_.end());
+        writeRecord_();
+
+        iterationPending_ = false;
+    }
+
+    // use the number of switched primary variables if the Newton method provides it
+    template <class NM>
+    static auto numPriVarsSwitched_(const NM& nm, int)
+        -> decltype(static_cast<int>(nm.numPriVarsSwitched()))
+    { return static_cast<int>(nm.numPriVarsSwitched()); }
+
+    template <class NM>
+    static int numPriVarsSwitched_(const NM&, long)
+    { return -1; }
+
+    template <class T>
+    static void append_(std::vector<char>& buffer, const T& value)
+    {
+        const char* begin = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), begin, begin + sizeof(T));
+    }
+
+    template <class T>
+    void append_(const T& value)
+    { append_(recordBuffer_, value); }
+
+    void writeRecord_()
+    { outStream_.write(recordBuffer_.data(), static_cast<std::streamsize>(recordBuffer_.size())); }
+
+    static bool enableConstraints_()
+    { return getPropValue<TypeTag, Properties::EnableConstraints>(); }
+
+    NewtonMethod& newtonMethod_;
+
+    bool enabled_;
+    unsigned numWorstDofs_;
+    Scalar dumpThreshold_;
+
+    std::ofstream outStream_;
+
+    // the data of the current iteration
+    bool iterationPending_{false};
+    uint32_t flags_{0};
+    EqArray residualL2_;
+    EqArray residualMax_;
+    EqArray updateL2_;
+    EqArray updateMax_;
+    std::vector<DofEntry> worstDofs_;
+    std::vector<char> dumpBuffer_;
+    unsigned numDumpedDofs_{0};
+
+    std::vector<char> recordBuffer_;
+};
+
+} // namespace Opm
+
+#endif
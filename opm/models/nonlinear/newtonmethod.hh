@@ -28,6 +28,7 @@
 #define EWOMS_NEWTON_METHOD_HH
 
 #include "nullconvergencewriter.hh"
+#include "newtonconvergencetracer.hh"
 
 #include "newtonmethodproperties.hh"
 
@@ -36,6 +37,7 @@
 #include <opm/material/densead/Math.hpp>
 
 #include <opm/models/discretization/common/fvbaseproperties.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 
@@ -45,6 +47,9 @@
 #include <dune/common/classname.hh>
 #include <dune/common/parallel/mpihelper.hh>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <sstream>
 
@@ -80,6 +85,17 @@ struct NewtonWriteConvergence<TypeTag, TTag::NewtonMethod> { static constexpr bo
 template<class TypeTag>
 struct NewtonVerbose<TypeTag, TTag::NewtonMethod> { static constexpr bool value = true; };
 template<class TypeTag>
+struct NewtonTraceConvergence<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
+struct NewtonTraceWorstDofs<TypeTag, TTag::NewtonMethod> { static constexpr int value = 10; };
+// do not dump the residuals of individual degrees of freedom by default
+template<class TypeTag>
+struct NewtonTraceDumpThreshold<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.0;
+};
+template<class TypeTag>
 struct NewtonTolerance<TypeTag, TTag::NewtonMethod>
 {
     using type = GetPropType<TypeTag, Scalar>;
@@ -97,6 +113,30 @@ template<class TypeTag>
 struct NewtonTargetIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 10; };
 template<class TypeTag>
 struct NewtonMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 20; };
+template<class TypeTag>
+struct NewtonJacobianReuse<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
+struct NewtonJacobianReuseMaxContraction<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.2;
+};
+template<class TypeTag>
+struct NewtonJacobianReuseMaxIterations<TypeTag, TTag::NewtonMethod> { static constexpr int value = 2; };
+template<class TypeTag>
+struct NewtonAdaptiveLinearTolerance<TypeTag, TTag::NewtonMethod> { static constexpr bool value = false; };
+template<class TypeTag>
+struct NewtonMinLinearTolerance<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1e-5;
+};
+template<class TypeTag>
+struct NewtonMaxLinearTolerance<TypeTag, TTag::NewtonMethod>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.1;
+};
 
 } // namespace Opm::Properties
 
@@ -125,6 +165,7 @@ class NewtonMethod
     using Linearizer = GetPropType<TypeTag, Properties::Linearizer>;
     using LinearSolverBackend = GetPropType<TypeTag, Properties::LinearSolverBackend>;
     using ConvergenceWriter = GetPropType<TypeTag, Properties::NewtonConvergenceWriter>;
+    using ConvergenceTracer = NewtonConvergenceTracer<TypeTag>;
 
     using Communicator = typename Dune::MPIHelper::MPICommunicator;
     using CollectiveCommunication = typename Dune::Communication<typename Dune::MPIHelper::MPICommunicator>;
@@ -136,12 +177,22 @@ public:
         , linearSolver_(simulator)
         , comm_(Dune::MPIHelper::getCommunicator())
         , convergenceWriter_(asImp_())
+        , convergenceTracer_(asImp_())
     {
         lastError_ = 1e100;
         error_ = 1e100;
         tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonTolerance);
 
         numIterations_ = 0;
+
+        enableJacobianReuse_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonJacobianReuse);
+        jacobianReuseMaxContraction_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonJacobianReuseMaxContraction);
+        jacobianReuseMaxIterations_ = EWOMS_GET_PARAM(TypeTag, int, NewtonJacobianReuseMaxIterations);
+
+        enableAdaptiveLinearTolerance_ = EWOMS_GET_PARAM(TypeTag, bool, NewtonAdaptiveLinearTolerance);
+        minLinearTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMinLinearTolerance);
+        maxLinearTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance);
+        linearTolerance_ = maxLinearTolerance_;
     }
 
     /*!
@@ -150,6 +201,7 @@ public:
     static void registerParameters()
     {
         LinearSolverBackend::registerParameters();
+        ConvergenceTracer::registerParameters();
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonVerbose,
                              "Specify whether the Newton method should inform "
@@ -170,6 +222,25 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxError,
                              "The maximum error tolerated by the Newton "
                              "method to which does not cause an abort");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonJacobianReuse,
+                             "Only evaluate the residual and reuse the Jacobian and the "
+                             "preconditioner of the previous Newton iteration if the "
+                             "method converges quickly");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonJacobianReuseMaxContraction,
+                             "The maximum ratio between the errors of two subsequent Newton "
+                             "iterations for which the Jacobian is reused");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonJacobianReuseMaxIterations,
+                             "The maximum number of subsequent Newton iterations which reuse "
+                             "the Jacobian");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonAdaptiveLinearTolerance,
+                             "Adapt the tolerance of the linear solver to the convergence of "
+                             "the Newton method using the Eisenstat-Walker forcing terms");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMinLinearTolerance,
+                             "The smallest tolerance of the linear solver if it is adapted "
+                             "by the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance,
+                             "The largest tolerance of the linear solver if it is adapted "
+                             "by the Newton method");
     }
 
     /*!
@@ -219,6 +290,14 @@ public:
     int numIterations() const
     { return numIterations_; }
 
+    /*!
+     * \brief Returns the total number of iterations done by the Newton method so far.
+     *
+     * This includes the iterations of failed attempts to solve a time step.
+     */
+    std::size_t numTotalIterations() const
+    { return numTotalIterations_; }
+
     /*!
      * \brief Set the index of current iteration.
      *
@@ -251,6 +330,8 @@ public:
      */
     bool apply()
     {
+        EWOMS_TIMEBLOCK(newtonMethod);
+
         // Clear the current line using an ansi escape
         // sequence.  For an explanation see
         // http://en.wikipedia.org/wiki/ANSI_escape_code
@@ -288,6 +369,8 @@ public:
             // execute the method as long as the implementation thinks
             // that we should do another iteration
             while (asImp_().proceed_()) {
+                EWOMS_TIMEBLOCK(newtonIteration);
+
                 // linearize the problem at the current solution
 
                 // notify the implementation that we're about to start
@@ -305,10 +388,25 @@ public:
                               << std::flush;
                 }
 
-                // do the actual linearization
+                // do the actual linearization. if the Newton method converges quickly,
+                // the Jacobian of the last iteration is reused and only the residual
+                // is evaluated.
+                bool reuseJacobian = asImp_().canReuseJacobian_();
+                if (reuseJacobian)
+                    numSubsequentJacobianReuses_ = jacobianReused_ ? numSubsequentJacobianReuses_ + 1 : 1;
+                else
+                    numSubsequentJacobianReuses_ = 0;
+                jacobianReused_ = reuseJacobian;
+
                 linearizeTimer_.start();
-                asImp_().linearizeDomain_();
-                asImp_().linearizeAuxiliaryEquations_();
+                if (jacobianReused_) {
+                    asImp_().evalResidual_();
+                    ++numJacobianReuses_;
+                }
+                else {
+                    asImp_().linearizeDomain_();
+                    asImp_().linearizeAuxiliaryEquations_();
+                }
                 linearizeTimer_.stop();
 
                 solveTimer_.start();
@@ -323,9 +421,27 @@ public:
                 // something else in addition. TODO: should its costs be counted to
                 // the linearization or to the update?
                 updateTimer_.start();
+                convergenceTracer_.recordResidual(residual);
                 asImp_().preSolve_(currentSolution, residual);
                 updateTimer_.stop();
 
+                // monitor the contraction rate of the error to decide whether the
+                // Jacobian can be reused for the next iteration
+                if (numIterations_ > 0 && previousError_ > 0.0)
+                    contraction_ = error_/previousError_;
+                else
+                    contraction_ = 1.0;
+                previousError_ = error_;
+                if (jacobianReused_)
+                    endIterMsg() << ", Jacobian reused";
+
+                // determine how accurately the linear system needs to be solved
+                if (enableAdaptiveLinearTolerance_) {
+                    linearTolerance_ = asImp_().computeLinearTolerance_();
+                    linearSolver_.setTolerance(linearTolerance_);
+                    endIterMsg() << ", linear tolerance=" << linearTolerance_;
+                }
+
                 if (!asImp_().proceed_()) {
                     if (asImp_().verbose_() && isatty(fileno(stdout)))
                         std::cout << clearRemainingLine
@@ -349,9 +465,7 @@ public:
                 solveTimer_.start();
                 // solve A x = b, where b is the residual, A is its Jacobian and x is the
                 // update of the solution
-                linearSolver_.setMatrix(jacobian);
-                solutionUpdate = 0.0;
-                bool converged = linearSolver_.solve(solutionUpdate);
+                bool converged = asImp_().solveLinearSystem_(jacobian, residual, solutionUpdate);
                 solveTimer_.stop();
 
                 if (!converged) {
@@ -380,6 +494,7 @@ public:
                                     residual,
                                     solutionUpdate);
                 asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                convergenceTracer_.recordUpdate(solutionUpdate);
                 updateTimer_.stop();
 
                 if (asImp_().verbose_() && isatty(fileno(stdout)))
@@ -391,6 +506,10 @@ public:
                 prePostProcessTimer_.start();
                 asImp_().endIteration_(nextSolution, currentSolution);
                 prePostProcessTimer_.stop();
+
+                // the Jacobian of this iteration does not match the next one if the
+                // meaning of any primary variable has changed
+                priVarsSwitched_ = asImp_().primaryVarsSwitched_();
             }
         }
         catch (const Dune::Exception& e)
@@ -488,6 +607,20 @@ public:
         return nextDt;
     }
 
+    /*!
+     * \brief Returns the total number of Newton iterations which reused the Jacobian of a
+     *        previous iteration.
+     */
+    unsigned numJacobianReuses() const
+    { return numJacobianReuses_; }
+
+    /*!
+     * \brief Returns the total number of iterations of the linear solver used by the
+     *        Newton method so far.
+     */
+    std::size_t numLinearIterations() const
+    { return numLinearIterations_; }
+
     /*!
      * \brief Message that should be printed for the user after the
      *        end of an iteration.
@@ -544,9 +677,14 @@ protected:
     void begin_(const SolutionVector&)
     {
         numIterations_ = 0;
+        jacobianReused_ = false;
+        numSubsequentJacobianReuses_ = 0;
+        priVarsSwitched_ = false;
 
         if (EWOMS_GET_PARAM(TypeTag, bool, NewtonWriteConvergence))
             convergenceWriter_.beginTimeStep();
+
+        convergenceTracer_.beginTimeStep();
     }
 
     /*!
@@ -575,6 +713,8 @@ protected:
             throw NumericalProblem("pre processing of the problem failed");
 
         lastError_ = error_;
+
+        convergenceTracer_.beginIteration();
     }
 
     /*!
@@ -629,6 +769,113 @@ protected:
                                    + std::to_string(double(newtonMaxError)));
     }
 
+    /*!
+     * \brief Solve the linearized system of equations for the update of the solution.
+     *
+     * The linear solver has already been prepared for the Jacobian and the residual
+     * at this point. Implementations may override this method to use a different
+     * solution strategy for some iterations.
+     *
+     * \param jacobian The Jacobian matrix of the residual
+     * \param residual The residual of the current iteration's solution
+     * \param solutionUpdate Receives the difference between the current and the next
+     *                       solution
+     *
+     * \return true iff the linear system was solved successfully
+     */
+    template <class Jacobian>
+    bool solveLinearSystem_(const Jacobian& jacobian,
+                            const GlobalEqVector&,
+                            GlobalEqVector& solutionUpdate)
+    {
+        // if the Jacobian was reused, the linear solver still holds the matrix and the
+        // preconditioner of the previous iteration
+        if (!jacobianReused_)
+            linearSolver_.setMatrix(jacobian);
+        solutionUpdate = 0.0;
+        bool converged = linearSolver_.solve(solutionUpdate);
+        numLinearIterations_ += linearSolver_.iterations();
+        return converged;
+    }
+
+    /*!
+     * \brief Returns the reduction of the residual which the linear solver needs to
+     *        achieve for the current iteration.
+     *
+     * This uses the second choice of the forcing terms proposed by Eisenstat and
+     * Walker, i.e., the tolerance is proportional to the square of the reduction of the
+     * error by the last iteration. The tolerance is kept from decreasing too quickly and
+     * the linear system is not solved more accurately than required to reach the
+     * tolerance of the Newton method. The result is bounded by the NewtonMinLinearTolerance
+     * and NewtonMaxLinearTolerance parameters.
+     */
+    Scalar computeLinearTolerance_() const
+    {
+        static constexpr Scalar gamma = 0.9;
+        static constexpr Scalar alpha = 2.0;
+
+        if (numIterations_ == 0)
+            return maxLinearTolerance_;
+
+        Scalar eta = gamma*std::pow(contraction_, alpha);
+
+        // safeguard against oversolving if the previous tolerance was large
+        Scalar etaSafeguard = gamma*std::pow(linearTolerance_, alpha);
+        if (etaSafeguard > 0.1)
+            eta = std::max(eta, etaSafeguard);
+
+        // safeguard against oversolving close to convergence
+        if (error_ > 0.0)
+            eta = std::max(eta, 0.5*tolerance_/error_);
+
+        return std::clamp(eta, minLinearTolerance_, maxLinearTolerance_);
+    }
+
+    /*!
+     * \brief Returns true iff the Jacobian of the previous iteration ought to be used for
+     *        the current one.
+     *
+     * This is the case if the error was reduced quickly by the last iteration. The
+     * Jacobian is never reused for the first iteration of a time step, if auxiliary
+     * equations are present, for parallel runs or if the primary variables of any
+     * degree of freedom were switched by the last iteration.
+     */
+    bool canReuseJacobian_() const
+    {
+        if (!enableJacobianReuse_ || numIterations_ == 0)
+            return false;
+        if (priVarsSwitched_)
+            return false;
+        if (model().numAuxiliaryModules() > 0 || simulator_.gridView().comm().size() > 1)
+            return false;
+
+        // do not reuse the Jacobian for too many subsequent iterations
+        if (jacobianReused_ && numSubsequentJacobianReuses_ >= jacobianReuseMaxIterations_)
+            return false;
+
+        return contraction_ <= jacobianReuseMaxContraction_;
+    }
+
+    /*!
+     * \brief Evaluate the residual of the current solution without linearizing the
+     *        system.
+     *
+     * The result is stored in the residual vector of the linearizer while its Jacobian
+     * matrix is left untouched.
+     */
+    void evalResidual_()
+    { model().linearizer().linearizeResidual(); }
+
+    /*!
+     * \brief Returns true if the meaning of the primary variables of any degree of
+     *        freedom was changed by the last iteration.
+     *
+     * This is called after endIteration_(). Models which do not switch primary
+     * variables do not need to overload it.
+     */
+    bool primaryVarsSwitched_() const
+    { return false; }
+
     /*!
      * \brief Update the error of the solution given the previous
      *        iteration.
@@ -690,6 +937,7 @@ protected:
                  const GlobalEqVector& solutionUpdate,
                  const GlobalEqVector& currentResidual)
     {
+        EWOMS_TIMEBLOCK(newtonUpdate);
         const auto& constraintsMap = model().linearizer().constraintsMap();
 
         // first, write out the current solution to make convergence
@@ -779,6 +1027,7 @@ protected:
                        const SolutionVector&)
     {
         ++numIterations_;
+        ++numTotalIterations_;
 
         const auto& comm = simulator_.gridView().comm();
         bool succeeded = true;
@@ -798,6 +1047,8 @@ protected:
         if (!succeeded)
             throw NumericalProblem("post processing of the problem failed");
 
+        convergenceTracer_.endIteration(static_cast<unsigned>(numIterations_), error_);
+
         if (asImp_().verbose_()) {
             std::cout << "Newton iteration " << numIterations_ << ""
                       << " error: " << error_
@@ -844,7 +1095,11 @@ protected:
      * This method is called _after_ end_()
      */
     void failed_()
-    { numIterations_ = targetIterations_() * 2; }
+    {
+        convergenceTracer_.endTimeStep(/*converged=*/false, error_);
+
+        numIterations_ = targetIterations_() * 2;
+    }
 
     /*!
      * \brief Called if the Newton method was successful.
@@ -852,7 +1107,7 @@ protected:
      * This method is called _after_ end_()
      */
     void succeeded_()
-    {}
+    { convergenceTracer_.endTimeStep(/*converged=*/true, error_); }
 
     // optimal number of iterations we want to achieve
     int targetIterations_() const
@@ -879,6 +1134,25 @@ protected:
 
     // actual number of iterations done so far
     int numIterations_;
+    std::size_t numTotalIterations_{0};
+
+    // reuse of the Jacobian of previous iterations
+    bool enableJacobianReuse_;
+    Scalar jacobianReuseMaxContraction_;
+    int jacobianReuseMaxIterations_;
+    bool jacobianReused_{false};
+    int numSubsequentJacobianReuses_{0};
+    bool priVarsSwitched_{false};
+    unsigned numJacobianReuses_{0};
+    Scalar previousError_{0.0};
+    Scalar contraction_{1.0};
+
+    // adaptive tolerance of the linear solver
+    bool enableAdaptiveLinearTolerance_;
+    Scalar minLinearTolerance_;
+    Scalar maxLinearTolerance_;
+    Scalar linearTolerance_;
+    std::size_t numLinearIterations_{0};
 
     // the linear solver
     LinearSolverBackend linearSolver_;
@@ -891,6 +1165,10 @@ protected:
     // method to disk
     ConvergenceWriter convergenceWriter_;
 
+    // the object which records a compact trace of the convergence behaviour of the
+    // Newton method
+    ConvergenceTracer convergenceTracer_;
+
 private:
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -53,6 +53,21 @@ struct NewtonWriteConvergence { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct ConvergenceWriter { using type = UndefinedProperty; };
 
+//! Specifies whether the convergence behaviour of the Newton method should be recorded
+//! in a compact binary trace file
+template<class TypeTag, class MyTypeTag>
+struct NewtonTraceConvergence { using type = UndefinedProperty; };
+
+//! The number of degrees of freedom with the largest residuals which are recorded by
+//! the trace of the Newton method for each iteration
+template<class TypeTag, class MyTypeTag>
+struct NewtonTraceWorstDofs { using type = UndefinedProperty; };
+
+//! The weighted residual above which the residual of a degree of freedom is recorded
+//! by the trace of the Newton method
+template<class TypeTag, class MyTypeTag>
+struct NewtonTraceDumpThreshold { using type = UndefinedProperty; };
+
 /*!
  * \brief The value for the error below which convergence is declared
  *
@@ -82,6 +97,45 @@ struct NewtonTargetIterations { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct NewtonMaxIterations { using type = UndefinedProperty; };
 
+/*!
+ * \brief Specifies whether the Jacobian of the previous Newton iteration may be reused
+ *        if the Newton method converges quickly.
+ *
+ * In this case, only the residual is evaluated for an iteration and the Jacobian matrix
+ * and the preconditioner of the linear solver are taken from the previous iteration.
+ */
+template<class TypeTag, class MyTypeTag>
+struct NewtonJacobianReuse { using type = UndefinedProperty; };
+
+//! The maximum ratio between the errors of two subsequent Newton iterations for which
+//! the Jacobian is reused for the next iteration
+template<class TypeTag, class MyTypeTag>
+struct NewtonJacobianReuseMaxContraction { using type = UndefinedProperty; };
+
+//! The maximum number of subsequent Newton iterations which reuse the Jacobian
+template<class TypeTag, class MyTypeTag>
+struct NewtonJacobianReuseMaxIterations { using type = UndefinedProperty; };
+
+/*!
+ * \brief Specifies whether the tolerance of the linear solver is adapted to the
+ *        convergence of the Newton method.
+ *
+ * If enabled, the reduction of the residual which the linear solver needs to achieve
+ * is determined for each iteration using the forcing terms of Eisenstat and Walker,
+ * i.e., the linear systems are only solved accurately when the Newton method is close
+ * to convergence.
+ */
+template<class TypeTag, class MyTypeTag>
+struct NewtonAdaptiveLinearTolerance { using type = UndefinedProperty; };
+
+//! The smallest tolerance of the linear solver used by the adaptive linear tolerance
+template<class TypeTag, class MyTypeTag>
+struct NewtonMinLinearTolerance { using type = UndefinedProperty; };
+
+//! The largest tolerance of the linear solver used by the adaptive linear tolerance
+template<class TypeTag, class MyTypeTag>
+struct NewtonMaxLinearTolerance { using type = UndefinedProperty; };
+
 } // end namespace  Opm::Properties
 
 #endif
@@ -0,0 +1,183 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::ElementCostBalancer
+ */
+#ifndef EWOMS_ELEMENT_COST_BALANCER_HH
+#define EWOMS_ELEMENT_COST_BALANCER_HH
+
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/common/rangegenerators.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Repartitions a grid based on the measured computational costs of its
+ *        elements.
+ *
+ * The costs of the elements (e.g., the time required to linearize them, which includes
+ * the iterations of local flash calculations) are collected into a vector which is
+ * indexed by the element mapper. From this, the imbalance of the work between the
+ * processes is determined as the ratio between the maximum and the mean of the costs
+ * of all processes.
+ *
+ * If the grid supports weighted load balancing in the style of dune-alugrid, the
+ * costs are passed to the partitioner as element weights. Otherwise, the default load
+ * balancing of the grid is used.
+ */
+template <class GridView, class ElementMapper>
+class ElementCostBalancer
+{
+    using Element = typename GridView::template Codim<0>::Entity;
+
+public:
+    /*!
+     * \brief Provides the element weights to the partitioner of the grid.
+     *
+     * The weights are scaled such that the cheapest element gets a weight of one
+     * because some partitioners only accept integral weights.
+     */
+    class WeightsHandle
+    {
+    public:
+        WeightsHandle(const ElementMapper& elementMapper,
+                      const std::vector<double>& elementCosts,
+                      double minCost)
+            : elementMapper_(elementMapper)
+            , elementCosts_(elementCosts)
+            , minCost_(minCost)
+        {}
+
+        bool userDefinedPartitioning() const
+        { return false; }
+
+        bool userDefinedLoadWeights() const
+        { return true; }
+
+        bool repartition() const
+        { return true; }
+
+        int loadWeight(const Element& elem) const
+        {
+            double cost = elementCosts_[elementMapper_.index(elem)];
+            double weight = std::min(std::round(cost/minCost_), maxWeight_);
+            return std::max(1, static_cast<int>(weight));
+        }
+
+        int destination(const Element&) const
+        { return -1; }
+
+        bool importRanks(std::set<int>&) const
+        { return false; }
+
+    private:
+        static constexpr double maxWeight_ = 1e6;
+
+        const ElementMapper& elementMapper_;
+        const std::vector<double>& elementCosts_;
+        double minCost_;
+    };
+
+    ElementCostBalancer(const GridView& gridView,
+                        const ElementMapper& elementMapper,
+                        const std::vector<double>& elementCosts)
+        : gridView_(gridView)
+        , elementMapper_(elementMapper)
+        , elementCosts_(elementCosts)
+    {}
+
+    /*!
+     * \brief Returns the ratio between the largest costs of a process and the mean
+     *        costs of all processes.
+     *
+     * Only the interior elements of each process are considered. A value of one means
+     * that the work is perfectly balanced.
+     */
+    double imbalance() const
+    {
+        double localCost = 0.0;
+        for (const auto& elem : elements(gridView_, Dune::Partitions::interior))
+            localCost += elementCosts_[elementMapper_.index(elem)];
+
+        const auto& comm = gridView_.comm();
+        double maxCost = comm.max(localCost);
+        double meanCost = comm.sum(localCost)/comm.size();
+        if (meanCost <= 0.0)
+            return 1.0;
+
+        return maxCost/meanCost;
+    }
+
+    /*!
+     * \brief Repartition the grid using the element costs as weights.
+     *
+     * \param grid The grid which is to be repartitioned
+     * \param dataHandle The data handle which migrates the data attached to the
+     *                   elements
+     *
+     * \return true iff the partitioning of the grid has changed
+     */
+    template <class Grid, class DataHandle>
+    bool repartition(Grid& grid, DataHandle& dataHandle) const
+    {
+        double minCost = std::numeric_limits<double>::max();
+        for (const auto& elem : elements(gridView_, Dune::Partitions::interior)) {
+            double cost = elementCosts_[elementMapper_.index(elem)];
+            if (cost > 0.0)
+                minCost = std::min(minCost, cost);
+        }
+        minCost = gridView_.comm().min(minCost);
+        if (minCost == std::numeric_limits<double>::max())
+            minCost = 1.0;
+
+        WeightsHandle weights(elementMapper_, elementCosts_, minCost);
+        return loadBalance_(grid, weights, dataHandle, 0);
+    }
+
+private:
+    // use the weights if the grid supports them...
+    template <class Grid, class DataHandle>
+    static auto loadBalance_(Grid& grid, WeightsHandle& weights, DataHandle& dataHandle, int)
+        -> decltype(grid.loadBalance(weights, dataHandle))
+    { return grid.loadBalance(weights, dataHandle); }
+
+    // ... else fall back to the default partitioner of the grid
+    template <class Grid, class DataHandle>
+    static bool loadBalance_(Grid& grid, WeightsHandle&, DataHandle& dataHandle, long)
+    { return grid.loadBalance(dataHandle); }
+
+    const GridView& gridView_;
+    const ElementMapper& elementMapper_;
+    const std::vector<double>& elementCosts_;
+};
+
+} // namespace Opm
+
+#endif
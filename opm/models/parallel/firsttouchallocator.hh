@@ -0,0 +1,153 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::FirstTouchAllocator
+ */
+#ifndef EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+#define EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace Opm {
+
+/*!
+ * \brief An allocator which places the memory pages of large arrays on the NUMA nodes
+ *        of the threads which work on them.
+ *
+ * Operating systems usually map a page of memory to the NUMA node of the thread which
+ * writes to it first. If a large array is allocated and initialized by the master
+ * thread, all of its pages thus end up on the memory of a single socket, and the
+ * threads running on the other sockets need to access remote memory in every kernel.
+ *
+ * To avoid this, this allocator writes to every page of a freshly allocated array
+ * from within an OpenMP loop that uses a static schedule over the array's
+ * elements. Subsequent initialization by the master thread (e.g., by the constructors
+ * which are called by std::vector::resize()) does not move the pages anymore. Threaded
+ * loops over the array that use the same static schedule thus mostly access the memory
+ * which is local to their socket.
+ *
+ * Small allocations, allocations from within parallel regions and programs which are
+ * run using a single thread are passed through to the base allocator unmodified.
+ */
+template <class T, class BaseAllocator = std::allocator<T> >
+class FirstTouchAllocator : public BaseAllocator
+{
+    using BaseTraits = std::allocator_traits<BaseAllocator>;
+
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template <class U>
+    struct rebind {
+        using other = FirstTouchAllocator<U, typename BaseTraits::template rebind_alloc<U> >;
+    };
+
+    FirstTouchAllocator() noexcept = default;
+
+    template <class U, class OtherBaseAllocator>
+    FirstTouchAllocator(const FirstTouchAllocator<U, OtherBaseAllocator>&) noexcept
+    {}
+
+    pointer allocate(size_type n)
+    {
+        pointer p = BaseTraits::allocate(*this, n);
+        firstTouch_(p, n);
+        return p;
+    }
+
+    void deallocate(pointer p, size_type n)
+    { BaseTraits::deallocate(*this, p, n); }
+
+private:
+    // arrays smaller than this number of pages are not worth to be distributed
+    static constexpr std::size_t minPages_ = 16;
+
+    static std::size_t pageSize_()
+    {
+        static const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return pageSize;
+    }
+
+    static void firstTouch_([[maybe_unused]] pointer p, [[maybe_unused]] size_type n)
+    {
+#ifdef _OPENMP
+        const std::size_t pageSize = pageSize_();
+        if (n*sizeof(T) < minPages_*pageSize || omp_in_parallel() || omp_get_max_threads() < 2)
+            return;
+
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(p);
+        const std::ptrdiff_t numElems = static_cast<std::ptrdiff_t>(n);
+
+        // every thread writes to the pages which start within the storage of the
+        // elements it is responsible for. the page which contains the beginning of the
+        // array is touched by the thread which deals with the first element.
+#pragma omp parallel for schedule(static)
+        for (std::ptrdiff_t elemIdx = 0; elemIdx < numElems; ++elemIdx) {
+            const std::uintptr_t elemBegin = base + static_cast<std::uintptr_t>(elemIdx)*sizeof(T);
+            const std::uintptr_t elemEnd = elemBegin + sizeof(T);
+
+            if (elemIdx == 0)
+                *reinterpret_cast<volatile char*>(elemBegin) = 0;
+
+            std::uintptr_t pageBegin = (elemBegin + pageSize - 1)/pageSize*pageSize;
+            for (; pageBegin < elemEnd; pageBegin += pageSize)
+                *reinterpret_cast<volatile char*>(pageBegin) = 0;
+        }
+#endif
+    }
+};
+
+template <class T1, class B1, class T2, class B2>
+inline bool operator==(const FirstTouchAllocator<T1, B1>&, const FirstTouchAllocator<T2, B2>&) noexcept
+{ return true; }
+
+template <class T1, class B1, class T2, class B2>
+inline bool operator!=(const FirstTouchAllocator<T1, B1>&, const FirstTouchAllocator<T2, B2>&) noexcept
+{ return false; }
+
+/*!
+ * \brief The FirstTouchAllocator if first touch allocation is enabled, else the base
+ *        allocator.
+ */
+template <class T, bool enableFirstTouch, class BaseAllocator = std::allocator<T> >
+using OptionalFirstTouchAllocator = std::conditional_t<enableFirstTouch,
+                                                       FirstTouchAllocator<T, BaseAllocator>,
+                                                       BaseAllocator>;
+
+} // namespace Opm
+
+#endif
@@ -36,6 +36,8 @@
 
 #include <dune/common/version.hh>
 
+#include <string>
+
 namespace Opm {
 
 /*!
@@ -103,6 +105,20 @@ public:
     static unsigned maxThreads()
     { return static_cast<unsigned>(numThreads_); }
 
+    /*!
+     * \brief Return the number of threads which work on the current parallel region
+     *
+     * Outside of a parallel region, this is always 1.
+     */
+    static unsigned numActiveThreads()
+    {
+#ifdef _OPENMP
+        return static_cast<unsigned>(omp_get_num_threads());
+#else
+        return 1;
+#endif
+    }
+
     /*!
      * \brief Return the index of the current OpenMP thread
      */
@@ -115,6 +131,41 @@ public:
 #endif
     }
 
+    /*!
+     * \brief Return a human readable description of how the threads are pinned to the
+     *        processors.
+     *
+     * Pinning the threads is optional and is controlled by the OMP_PROC_BIND and
+     * OMP_PLACES environment variables. It is required for the memory of the per-DOF
+     * arrays to stay local to the threads which work on them (see FirstTouchAllocator).
+     */
+    static std::string threadPinning()
+    {
+#ifdef _OPENMP
+        std::string policy;
+        switch (omp_get_proc_bind()) {
+        case omp_proc_bind_false:
+            return "none";
+        case omp_proc_bind_true:
+            policy = "true";
+            break;
+        case omp_proc_bind_master:
+            policy = "master";
+            break;
+        case omp_proc_bind_close:
+            policy = "close";
+            break;
+        case omp_proc_bind_spread:
+            policy = "spread";
+            break;
+        }
+
+        return policy + " (" + std::to_string(omp_get_num_places()) + " places)";
+#else
+        return "none";
+#endif
+    }
+
 private:
     static int numThreads_;
 };
@@ -130,6 +130,12 @@ protected:
         this->problem().model().switchPrimaryVars_();
     }
 
+    /*!
+     * \copydoc NewtonMethod::primaryVarsSwitched_
+     */
+    bool primaryVarsSwitched_() const
+    { return this->problem().model().switched(); }
+
     void clampValue_(Scalar& val, Scalar minVal, Scalar maxVal) const
     { val = std::max(minVal, std::min(val, maxVal)); }
 };
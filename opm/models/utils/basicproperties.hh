@@ -128,6 +128,28 @@ struct PrintProperties { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PrintParameters { using type = UndefinedProperty; };
 
+/*!
+ * \brief Only set up the simulation and estimate its memory footprint?
+ *
+ * If this is true, the grid and the model are set up, but the caches of the model, the
+ * linear system and the structures of the linear solver are not allocated. Instead,
+ * their footprints are estimated from the number of degrees of freedom and of the
+ * non-zero blocks of the Jacobian matrix and printed. No time step is computed.
+ */
+template<class TypeTag, class MyTypeTag>
+struct MemoryDryRun { using type = UndefinedProperty; };
+
+/*!
+ * \brief Place the pages of the large per-DOF arrays on the NUMA nodes of the threads
+ *        which work on them?
+ *
+ * If this is true, the caches of the model, the global residual and the Jacobian
+ * matrix are allocated using the FirstTouchAllocator. Note that this changes the types
+ * of the GlobalEqVector and the SparseMatrixAdapter properties.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableFirstTouchAllocation { using type = UndefinedProperty; };
+
 //! The default value for the simulation's end time
 template<class TypeTag, class MyTypeTag>
 struct EndTime { using type = UndefinedProperty; };
@@ -246,6 +268,14 @@ struct PrintProperties<TypeTag, TTag::NumericModel> { static constexpr int value
 template<class TypeTag>
 struct PrintParameters<TypeTag, TTag::NumericModel> { static constexpr int value = 2; };
 
+//! By default, run the simulation
+template<class TypeTag>
+struct MemoryDryRun<TypeTag, TTag::NumericModel> { static constexpr bool value = false; };
+
+//! By default, use the standard allocators for all arrays
+template<class TypeTag>
+struct EnableFirstTouchAllocation<TypeTag, TTag::NumericModel> { static constexpr bool value = false; };
+
 //! The default value for the simulation's end time
 template<class TypeTag>
 struct EndTime<TypeTag, TTag::NumericModel>
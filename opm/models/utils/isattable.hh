@@ -0,0 +1,368 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::IsatTable
+ */
+#ifndef EWOMS_ISAT_TABLE_HH
+#define EWOMS_ISAT_TABLE_HH
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace Opm {
+/*!
+ * \ingroup Common
+ *
+ * \brief A thread-safe in-situ adaptive tabulation of an expensive function.
+ *
+ * The table stores the values \f$f(x_0)\f$ and the sensitivities \f$A = \partial f /
+ * \partial x (x_0)\f$ of the function at the points at which it was evaluated. A query
+ * for a point \f$x\f$ is answered by the linear extrapolation \f$f(x_0) + A (x -
+ * x_0)\f$ of a record if \f$x\f$ is within the region of accuracy of the record. The
+ * region of accuracy of each record starts out empty. It is grown whenever the function
+ * is evaluated at a point for which the extrapolation of the closest record is found to
+ * be within the error tolerance.
+ *
+ * Records are only considered for a query if both points are in the same bin, where the
+ * bins are spaced logarithmically in each input dimension. The number of records is
+ * bounded; if the table is full, the least recently used record is evicted.
+ */
+template <class Scalar, int numInputs, int numOutputs>
+class IsatTable
+{
+    // the table is split into shards with separate locks to reduce contention
+    static constexpr unsigned numShards = 64;
+
+    using Key = std::array<int32_t, numInputs>;
+
+public:
+    using InputVector = std::array<Scalar, numInputs>;
+    using OutputVector = std::array<Scalar, numOutputs>;
+    using Jacobian = std::array<std::array<Scalar, numInputs>, numOutputs>;
+
+    struct Statistics
+    {
+        uint64_t numQueries{0};
+        uint64_t numRetrieves{0};
+        uint64_t numGrowths{0};
+        uint64_t numAdditions{0};
+        uint64_t numEvictions{0};
+        Scalar maxGrowthError{0.0};
+        double retrieveTime{0.0};
+        double evaluateTime{0.0};
+    };
+
+    /*!
+     * \brief Create an empty table
+     *
+     * \param tolerance The maximum scaled error of the extrapolated outputs
+     * \param binWidth The relative width of the bins in each input dimension
+     * \param memoryBudget The approximate maximum size of the table in bytes
+     * \param inputScales The magnitude below which the inputs are considered as absolute
+     * \param outputScales The magnitude below which the outputs are considered as absolute
+     */
+    IsatTable(Scalar tolerance,
+              Scalar binWidth,
+              std::size_t memoryBudget,
+              const InputVector& inputScales,
+              const OutputVector& outputScales)
+        : tolerance_(tolerance)
+        , logBinWidth_(std::log1p(binWidth))
+        , inputScales_(inputScales)
+        , outputScales_(outputScales)
+    {
+        // besides the record itself, each entry requires a node of the LRU list and
+        // an entry in the vector of its bin
+        std::size_t recordSize = sizeof(Record) + 4*sizeof(void*);
+        shardCapacity_ = std::max<std::size_t>(1, memoryBudget/recordSize/numShards);
+    }
+
+    IsatTable(const IsatTable&) = delete;
+    IsatTable& operator=(const IsatTable&) = delete;
+
+    /*!
+     * \brief Look up a record which can be used to approximate the function at a point.
+     *
+     * \return true if such a record exists. In this case, x0, f0 and A are set to the
+     *         point, the value and the sensitivities of the record.
+     */
+    bool retrieve(const InputVector& x, InputVector& x0, OutputVector& f0, Jacobian& A)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        Key key = key_(x);
+        Shard& shard = shard_(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        ++shard.stats.numQueries;
+        bool found = false;
+        auto binIt = shard.bins.find(key);
+        if (binIt != shard.bins.end()) {
+            for (auto recordIt : binIt->second) {
+                if (distance_(x, recordIt->x) <= recordIt->radius) {
+                    x0 = recordIt->x;
+                    f0 = recordIt->f;
+                    A = recordIt->A;
+
+                    // the record is now the most recently used one
+                    shard.records.splice(shard.records.begin(), shard.records, recordIt);
+                    ++shard.stats.numRetrieves;
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - startTime;
+        shard.stats.retrieveTime += dt.count();
+        return found;
+    }
+
+    /*!
+     * \brief Add the result of an evaluation of the function which could not be
+     *        retrieved from the table.
+     *
+     * \param x The point at which the function was evaluated
+     * \param f The value of the function at x
+     * \param A The sensitivities of the function at x
+     * \param evaluateTime The time [s] required to evaluate the function
+     */
+    void add(const InputVector& x, const OutputVector& f, const Jacobian& A, double evaluateTime)
+    {
+        Key key = key_(x);
+        Shard& shard = shard_(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        shard.stats.evaluateTime += evaluateTime;
+
+        auto& bin = shard.bins[key];
+
+        // find the closest record in the same bin and grow its region of accuracy if its
+        // extrapolation is accurate enough
+        RecordIterator closestIt = shard.records.end();
+        Scalar closestDistance = 0.0;
+        for (auto recordIt : bin) {
+            Scalar d = distance_(x, recordIt->x);
+            if (closestIt == shard.records.end() || d < closestDistance) {
+                closestIt = recordIt;
+                closestDistance = d;
+            }
+        }
+
+        if (closestIt != shard.records.end()) {
+            Scalar err = extrapolationError_(*closestIt, x, f);
+            if (err <= tolerance_) {
+                closestIt->radius = std::max(closestIt->radius, closestDistance);
+                shard.records.splice(shard.records.begin(), shard.records, closestIt);
+                ++shard.stats.numGrowths;
+                shard.stats.maxGrowthError = std::max(shard.stats.maxGrowthError, err);
+                return;
+            }
+        }
+
+        // add a new record
+        shard.records.push_front(Record{key, x, f, A, /*radius=*/0.0});
+        bin.push_back(shard.records.begin());
+        ++shard.stats.numAdditions;
+
+        // evict the least recently used records if the shard is full
+        while (shard.records.size() > shardCapacity_) {
+            auto lruIt = std::prev(shard.records.end());
+            auto& lruBin = shard.bins[lruIt->key];
+            lruBin.erase(std::find(lruBin.begin(), lruBin.end(), lruIt));
+            if (lruBin.empty())
+                shard.bins.erase(lruIt->key);
+            shard.records.erase(lruIt);
+            ++shard.stats.numEvictions;
+        }
+    }
+
+    /*!
+     * \brief Returns the accumulated statistics of the table.
+     */
+    Statistics statistics() const
+    {
+        Statistics result;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.numQueries += shard.stats.numQueries;
+            result.numRetrieves += shard.stats.numRetrieves;
+            result.numGrowths += shard.stats.numGrowths;
+            result.numAdditions += shard.stats.numAdditions;
+            result.numEvictions += shard.stats.numEvictions;
+            result.maxGrowthError = std::max(result.maxGrowthError, shard.stats.maxGrowthError);
+            result.retrieveTime += shard.stats.retrieveTime;
+            result.evaluateTime += shard.stats.evaluateTime;
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Accumulate the statistics of the tables of all processes.
+     */
+    template <class Communicator>
+    static Statistics globalStatistics(const Communicator& comm, const Statistics& localStats)
+    {
+        // the counters are communicated as doubles because not all MPI wrappers are
+        // able to deal with 64 bit integers
+        std::array<double, 5> counters = {
+            static_cast<double>(localStats.numQueries),
+            static_cast<double>(localStats.numRetrieves),
+            static_cast<double>(localStats.numGrowths),
+            static_cast<double>(localStats.numAdditions),
+            static_cast<double>(localStats.numEvictions)
+        };
+        comm.sum(counters.data(), counters.size());
+
+        Statistics result;
+        result.numQueries = static_cast<uint64_t>(counters[0]);
+        result.numRetrieves = static_cast<uint64_t>(counters[1]);
+        result.numGrowths = static_cast<uint64_t>(counters[2]);
+        result.numAdditions = static_cast<uint64_t>(counters[3]);
+        result.numEvictions = static_cast<uint64_t>(counters[4]);
+        result.maxGrowthError = comm.max(localStats.maxGrowthError);
+        result.retrieveTime = comm.sum(localStats.retrieveTime);
+        result.evaluateTime = comm.sum(localStats.evaluateTime);
+        return result;
+    }
+
+    /*!
+     * \brief Print a summary of the statistics of the table.
+     *
+     * The speedup is estimated from the average time required to evaluate the function
+     * and the time spent on queries.
+     */
+    static void printStatistics(std::ostream& os, const Statistics& stats)
+    {
+        uint64_t numEvaluations = stats.numQueries - stats.numRetrieves;
+        double hitRate = stats.numQueries > 0
+            ? static_cast<double>(stats.numRetrieves)/stats.numQueries : 0.0;
+        double avgEvaluateTime = numEvaluations > 0
+            ? stats.evaluateTime/numEvaluations : 0.0;
+        double actualTime = stats.evaluateTime + stats.retrieveTime;
+        double speedup = actualTime > 0.0
+            ? avgEvaluateTime*stats.numQueries/actualTime : 1.0;
+
+        os << "    Queries: " << stats.numQueries
+           << ", retrieves: " << stats.numRetrieves << " (hit rate: " << hitRate*100 << "%)\n"
+           << "    Growths: " << stats.numGrowths
+           << ", additions: " << stats.numAdditions
+           << ", evictions: " << stats.numEvictions << "\n"
+           << "    Maximum verified extrapolation error: " << stats.maxGrowthError << "\n"
+           << "    Estimated speedup: " << speedup << "\n";
+    }
+
+private:
+    struct Record
+    {
+        Key key;
+        InputVector x;
+        OutputVector f;
+        Jacobian A;
+        Scalar radius;
+    };
+
+    using RecordIterator = typename std::list<Record>::iterator;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            std::size_t seed = 0;
+            for (int32_t k : key)
+                seed ^= std::hash<int32_t>()(k) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::list<Record> records;
+        std::unordered_map<Key, std::vector<RecordIterator>, KeyHash> bins;
+        Statistics stats;
+    };
+
+    Key key_(const InputVector& x) const
+    {
+        Key key;
+        for (unsigned j = 0; j < numInputs; ++j) {
+            Scalar v = std::max(std::abs(x[j]), inputScales_[j]);
+            int32_t k = static_cast<int32_t>(std::floor(std::log(v)/logBinWidth_));
+            key[j] = 2*k + (x[j] < 0 ? 1 : 0);
+        }
+        return key;
+    }
+
+    Shard& shard_(const Key& key)
+    { return shards_[KeyHash()(key) % numShards]; }
+
+    // the scaled maximum norm of the difference of two inputs
+    Scalar distance_(const InputVector& x, const InputVector& x0) const
+    {
+        Scalar result = 0.0;
+        for (unsigned j = 0; j < numInputs; ++j)
+            result = std::max(result,
+                              std::abs(x[j] - x0[j])/std::max(std::abs(x0[j]), inputScales_[j]));
+        return result;
+    }
+
+    // the scaled maximum norm of the error of the extrapolation of a record
+    Scalar extrapolationError_(const Record& record, const InputVector& x, const OutputVector& f) const
+    {
+        Scalar result = 0.0;
+        for (unsigned i = 0; i < numOutputs; ++i) {
+            Scalar fExtrapolated = record.f[i];
+            for (unsigned j = 0; j < numInputs; ++j)
+                fExtrapolated += record.A[i][j]*(x[j] - record.x[j]);
+            result = std::max(result,
+                              std::abs(f[i] - fExtrapolated)/std::max(std::abs(f[i]), outputScales_[i]));
+        }
+        return result;
+    }
+
+    Scalar tolerance_;
+    Scalar logBinWidth_;
+    InputVector inputScales_;
+    OutputVector outputScales_;
+    std::size_t shardCapacity_;
+
+    std::array<Shard, numShards> shards_;
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,338 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::MemoryUsage
+ */
+#ifndef EWOMS_MEMORY_USAGE_HH
+#define EWOMS_MEMORY_USAGE_HH
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+template <class DataType>
+class MpiBuffer;
+
+template <typename T>
+class SparseTable;
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Collects the memory footprints of the major data structures of a simulation.
+ *
+ * Each data structure reports the number of bytes it occupies on the heap under a
+ * name which describes the subsystem it belongs to. The footprints of data structures
+ * which are reported under the same name are summed up.
+ */
+class MemoryUsage
+{
+public:
+    /*!
+     * \brief Add the footprint of a data structure.
+     */
+    void add(const std::string& name, std::size_t bytes)
+    {
+        for (auto& entry : entries_) {
+            if (entry.first == name) {
+                entry.second += bytes;
+                return;
+            }
+        }
+        entries_.emplace_back(name, bytes);
+    }
+
+    /*!
+     * \brief Returns the footprints of all subsystems in the order in which they
+     *        have been added.
+     */
+    const std::vector<std::pair<std::string, std::size_t> >& entries() const
+    { return entries_; }
+
+    /*!
+     * \brief Returns the sum of the footprints of all subsystems.
+     */
+    std::size_t total() const
+    {
+        std::size_t result = 0;
+        for (const auto& entry : entries_)
+            result += entry.second;
+        return result;
+    }
+
+    /*!
+     * \brief Print the footprints aggregated over all processes.
+     *
+     * For each subsystem, the minimum and the maximum footprint of a process as well
+     * as the sum over all processes are printed by the first process. This is a
+     * collective operation, i.e., all processes must call it with the same subsystems.
+     */
+    template <class Communication>
+    void print(std::ostream& os, const Communication& comm) const
+    {
+        if (comm.rank() == 0)
+            os << pad_("Subsystem", 40) << pad_("min/process", 14)
+               << pad_("max/process", 14) << "total\n";
+
+        for (const auto& [name, bytes] : entries_)
+            printLine_(os, comm, name, bytes);
+        printLine_(os, comm, "Total", total());
+    }
+
+    /*!
+     * \brief Convert a number of bytes into a human readable string.
+     */
+    static std::string humanReadableBytes(double bytes)
+    {
+        static const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+        unsigned unitIdx = 0;
+        while (bytes >= 1024.0 && unitIdx < 4) {
+            bytes /= 1024.0;
+            ++unitIdx;
+        }
+
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.1f %s", bytes, units[unitIdx]);
+        return buf;
+    }
+
+private:
+    template <class Communication>
+    static void printLine_(std::ostream& os,
+                           const Communication& comm,
+                           const std::string& name,
+                           std::size_t bytes)
+    {
+        double value = static_cast<double>(bytes);
+        double minValue = comm.min(value);
+        double maxValue = comm.max(value);
+        double sumValue = comm.sum(value);
+        if (comm.rank() == 0)
+            os << pad_(name+":", 40)
+               << pad_(humanReadableBytes(minValue), 14)
+               << pad_(humanReadableBytes(maxValue), 14)
+               << humanReadableBytes(sumValue) << "\n";
+    }
+
+    static std::string pad_(const std::string& s, std::size_t width)
+    { return s.size() < width ? s + std::string(width - s.size(), ' ') : s + " "; }
+
+    std::vector<std::pair<std::string, std::size_t> > entries_;
+};
+
+/*!
+ * \brief Returns the number of bytes which are occupied by an object on the heap.
+ *
+ * For the containers of the standard library the sizes of the nodes are estimated from
+ * the size of their values and a few pointers for the bookkeeping. Objects which are
+ * not containers are assumed not to allocate any memory.
+ */
+template <class T>
+std::size_t memoryUsageOf(const T&);
+
+template <class T, class Allocator>
+std::size_t memoryUsageOf(const std::vector<T, Allocator>& v);
+
+template <class Allocator>
+std::size_t memoryUsageOf(const std::vector<bool, Allocator>& v);
+
+template <class Key, class Value, class Compare, class Allocator>
+std::size_t memoryUsageOf(const std::map<Key, Value, Compare, Allocator>& m);
+
+template <class Key, class Compare, class Allocator>
+std::size_t memoryUsageOf(const std::set<Key, Compare, Allocator>& s);
+
+template <class Key, class Value, class Hash, class Equal, class Allocator>
+std::size_t memoryUsageOf(const std::unordered_map<Key, Value, Hash, Equal, Allocator>& m);
+
+template <class Block, class Allocator>
+std::size_t memoryUsageOf(const Dune::BlockVector<Block, Allocator>& v);
+
+template <class Block, class Allocator>
+std::size_t memoryUsageOf(const Dune::BCRSMatrix<Block, Allocator>& m);
+
+template <class T>
+std::size_t memoryUsageOf(const SparseTable<T>& t);
+
+template <class DataType>
+std::size_t memoryUsageOf(const MpiBuffer<DataType>& b);
+
+template <class T>
+std::size_t memoryUsageOf(const T&)
+{ return 0; }
+
+template <class T, class Allocator>
+std::size_t memoryUsageOf(const std::vector<T, Allocator>& v)
+{
+    std::size_t result = v.capacity()*sizeof(T);
+    for (const auto& value : v)
+        result += memoryUsageOf(value);
+    return result;
+}
+
+template <class Allocator>
+std::size_t memoryUsageOf(const std::vector<bool, Allocator>& v)
+{ return v.capacity()/8; }
+
+template <class Key, class Value, class Compare, class Allocator>
+std::size_t memoryUsageOf(const std::map<Key, Value, Compare, Allocator>& m)
+{
+    // the nodes of red-black trees contain three pointers and the color
+    std::size_t result = m.size()*(sizeof(std::pair<const Key, Value>) + 4*sizeof(void*));
+    for (const auto& [key, value] : m)
+        result += memoryUsageOf(key) + memoryUsageOf(value);
+    return result;
+}
+
+template <class Key, class Compare, class Allocator>
+std::size_t memoryUsageOf(const std::set<Key, Compare, Allocator>& s)
+{
+    std::size_t result = s.size()*(sizeof(Key) + 4*sizeof(void*));
+    for (const auto& key : s)
+        result += memoryUsageOf(key);
+    return result;
+}
+
+template <class Key, class Value, class Hash, class Equal, class Allocator>
+std::size_t memoryUsageOf(const std::unordered_map<Key, Value, Hash, Equal, Allocator>& m)
+{
+    // the nodes of hash tables contain a pointer to the next node and the hash value
+    std::size_t result =
+        m.size()*(sizeof(std::pair<const Key, Value>) + 2*sizeof(void*))
+        + m.bucket_count()*sizeof(void*);
+    for (const auto& [key, value] : m)
+        result += memoryUsageOf(key) + memoryUsageOf(value);
+    return result;
+}
+
+template <class Block, class Allocator>
+std::size_t memoryUsageOf(const Dune::BlockVector<Block, Allocator>& v)
+{ return v.capacity()*sizeof(Block); }
+
+/*!
+ * \brief Returns the number of bytes which a BCRS matrix with a given number of rows and
+ *        non-zero blocks occupies on the heap.
+ *
+ * This allows to estimate the footprint of a matrix without allocating it.
+ */
+template <class Matrix>
+std::size_t estimatedMemoryUsageOfMatrix(std::size_t numRows, std::size_t numNonzeros)
+{
+    // the values and column indices of the non-zero blocks plus the row descriptors
+    return numNonzeros*(sizeof(typename Matrix::block_type) + sizeof(typename Matrix::size_type))
+        + numRows*sizeof(typename Matrix::row_type);
+}
+
+template <class Block, class Allocator>
+std::size_t memoryUsageOf(const Dune::BCRSMatrix<Block, Allocator>& m)
+{ return estimatedMemoryUsageOfMatrix<Dune::BCRSMatrix<Block, Allocator> >(m.N(), m.nonzeroes()); }
+
+template <class T>
+std::size_t memoryUsageOf(const SparseTable<T>& t)
+{
+    // the values plus the start indices of the rows
+    return t.dataSize()*sizeof(T) + (t.size() + 1)*sizeof(int);
+}
+
+template <class DataType>
+std::size_t memoryUsageOf(const MpiBuffer<DataType>& b)
+{ return b.size()*sizeof(DataType); }
+
+/*!
+ * \brief Returns the number of bytes which are occupied by the objects which are
+ *        referenced by the (smart) pointers stored as the values of a map.
+ */
+template <class Map>
+std::size_t memoryUsageOfMappedPointees(const Map& m)
+{
+    std::size_t result = 0;
+    for (const auto& [key, ptr] : m)
+        if (ptr)
+            result += sizeof(*ptr) + memoryUsageOf(*ptr);
+    return result;
+}
+
+namespace detail {
+template <class T>
+auto addMemoryUsage_(const T& obj, MemoryUsage& usage, int)
+    -> decltype(obj.addMemoryUsage(usage), void())
+{ obj.addMemoryUsage(usage); }
+
+template <class T>
+void addMemoryUsage_(const T&, MemoryUsage&, long)
+{}
+
+template <class T>
+auto estimateMemoryUsage_(const T& obj,
+                          MemoryUsage& usage,
+                          std::size_t numRows,
+                          std::size_t numNonzeros,
+                          int)
+    -> decltype(obj.estimateMemoryUsage(usage, numRows, numNonzeros), void())
+{ obj.estimateMemoryUsage(usage, numRows, numNonzeros); }
+
+template <class T>
+void estimateMemoryUsage_(const T&, MemoryUsage&, std::size_t, std::size_t, long)
+{}
+} // namespace detail
+
+/*!
+ * \brief Let an object add its memory footprint if it supports this.
+ *
+ * This calls obj.addMemoryUsage(usage) if the object provides such a method and does
+ * nothing otherwise.
+ */
+template <class T>
+void addMemoryUsage(const T& obj, MemoryUsage& usage)
+{ detail::addMemoryUsage_(obj, usage, 0); }
+
+/*!
+ * \brief Let an object estimate its memory footprint for a linear system of a given
+ *        size if it supports this.
+ *
+ * This calls obj.estimateMemoryUsage(usage, numRows, numNonzeros) if the object provides
+ * such a method and does nothing otherwise. numRows and numNonzeros are the number of
+ * block rows and of non-zero blocks of the Jacobian matrix.
+ */
+template <class T>
+void estimateMemoryUsage(const T& obj,
+                         MemoryUsage& usage,
+                         std::size_t numRows,
+                         std::size_t numNonzeros)
+{ detail::estimateMemoryUsage_(obj, usage, numRows, numNonzeros, 0); }
+
+} // namespace Opm
+
+#endif
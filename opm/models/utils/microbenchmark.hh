@@ -0,0 +1,417 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::MicroBenchmark
+ */
+#ifndef EWOMS_MICRO_BENCHMARK_HH
+#define EWOMS_MICRO_BENCHMARK_HH
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#define EWOMS_HAVE_PERF_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Reads the hardware performance counters of all threads of a process.
+ *
+ * On Linux, one set of counters is opened for each OpenMP thread via the
+ * perf_event_open() system call. If this is not possible (e.g., because the
+ * kernel.perf_event_paranoid setting does not allow it or because the program runs
+ * inside a virtual machine without a virtual PMU), the counters are unavailable and
+ * all methods of this class are no-ops.
+ */
+class HardwareCounters
+{
+public:
+    static constexpr unsigned numEvents = 4;
+
+    using Values = std::array<std::uint64_t, numEvents>;
+
+    HardwareCounters()
+    {
+#ifdef EWOMS_HAVE_PERF_EVENTS
+        int numThreads = 1;
+#ifdef _OPENMP
+        numThreads = omp_get_max_threads();
+#endif
+        fds_.resize(numThreads*numEvents, -1);
+
+        // counters opened with pid == 0 and cpu == -1 only count the events of the
+        // calling thread, so every thread needs to open its own set.
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+        {
+            int threadId = 0;
+#ifdef _OPENMP
+            threadId = omp_get_thread_num();
+#endif
+            for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+                fds_[threadId*numEvents + eventIdx] = openCounter_(eventConfig_(eventIdx));
+        }
+
+        available_ = std::none_of(fds_.begin(), fds_.end(), [](int fd) { return fd < 0; });
+        if (!available_)
+            close_();
+#endif
+    }
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    ~HardwareCounters()
+    { close_(); }
+
+    /*!
+     * \brief Returns true iff the counters can be read on this system.
+     */
+    bool available() const
+    { return available_; }
+
+    /*!
+     * \brief Returns the name of a counted event.
+     */
+    static const char* eventName(unsigned eventIdx)
+    {
+        static const char* names[numEvents] =
+            { "cycles", "instructions", "cacheMisses", "branchMisses" };
+        return names[eventIdx];
+    }
+
+    /*!
+     * \brief Resets the counters of all threads to zero and starts counting.
+     */
+    void start()
+    {
+#ifdef EWOMS_HAVE_PERF_EVENTS
+        if (!available_)
+            return;
+
+        for (int fd : fds_) {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /*!
+     * \brief Stops counting and returns the events of all threads since start().
+     */
+    Values stop()
+    {
+        Values result;
+        result.fill(0);
+#ifdef EWOMS_HAVE_PERF_EVENTS
+        if (!available_)
+            return result;
+
+        for (int fd : fds_)
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        for (std::size_t i = 0; i < fds_.size(); ++i) {
+            std::uint64_t value = 0;
+            if (::read(fds_[i], &value, sizeof(value)) == sizeof(value))
+                result[i % numEvents] += value;
+        }
+#endif
+        return result;
+    }
+
+private:
+#ifdef EWOMS_HAVE_PERF_EVENTS
+    static std::uint64_t eventConfig_(unsigned eventIdx)
+    {
+        static const std::uint64_t configs[numEvents] =
+            { PERF_COUNT_HW_CPU_CYCLES,
+              PERF_COUNT_HW_INSTRUCTIONS,
+              PERF_COUNT_HW_CACHE_MISSES,
+              PERF_COUNT_HW_BRANCH_MISSES };
+        return configs[eventIdx];
+    }
+
+    static int openCounter_(std::uint64_t config)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        return static_cast<int>(::syscall(__NR_perf_event_open, &attr,
+                                          /*pid=*/0, /*cpu=*/-1,
+                                          /*groupFd=*/-1, /*flags=*/0UL));
+    }
+#endif
+
+    void close_()
+    {
+#ifdef EWOMS_HAVE_PERF_EVENTS
+        for (int& fd : fds_) {
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    std::vector<int> fds_;
+    bool available_{false};
+};
+
+/*!
+ * \brief A minimal harness to measure the performance of the computational kernels
+ *        of the simulator.
+ *
+ * Each kernel is called a few times to warm up the caches and the memory allocators,
+ * and then a given number of times during which the wall clock time and, if available,
+ * the hardware performance counters are recorded for each repetition. Since the
+ * distribution of the run times usually has a long tail, the median of the
+ * repetitions is the figure of merit.
+ *
+ * The results of all kernels can be written in the JSON format for automated
+ * processing.
+ */
+class MicroBenchmark
+{
+public:
+    struct Result
+    {
+        std::string name;
+        std::size_t numItems;
+        std::vector<double> times;
+        std::vector<HardwareCounters::Values> counters;
+
+        double min() const
+        { return *std::min_element(times.begin(), times.end()); }
+
+        double mean() const
+        { return std::accumulate(times.begin(), times.end(), 0.0)/times.size(); }
+
+        double median() const
+        { return median_(times); }
+
+        std::uint64_t counterMedian(unsigned eventIdx) const
+        {
+            std::vector<std::uint64_t> values;
+            for (const auto& c : counters)
+                values.push_back(c[eventIdx]);
+            return median_(values);
+        }
+
+    private:
+        template <class T>
+        static T median_(std::vector<T> values)
+        {
+            std::size_t n = values.size();
+            std::nth_element(values.begin(), values.begin() + n/2, values.end());
+            T upper = values[n/2];
+            if (n % 2 == 1)
+                return upper;
+
+            T lower = *std::max_element(values.begin(), values.begin() + n/2);
+            return (lower + upper)/2;
+        }
+    };
+
+    /*!
+     * \param repetitions The number of timed calls of each kernel
+     * \param warmupRepetitions The number of calls of each kernel before the timing
+     *                          starts
+     */
+    explicit MicroBenchmark(unsigned repetitions, unsigned warmupRepetitions = 1)
+        : repetitions_(std::max(repetitions, 1u))
+        , warmupRepetitions_(warmupRepetitions)
+    {}
+
+    /*!
+     * \brief Attach some information about the benchmarked configuration to the
+     *        results (e.g., the size of the grid or the number of threads).
+     */
+    template <class T>
+    void addMetadata(const std::string& key, const T& value)
+    { metadata_.emplace_back(key, toJson_(value)); }
+
+    /*!
+     * \brief Returns true iff the hardware performance counters are recorded.
+     */
+    bool haveHardwareCounters() const
+    { return counters_.available(); }
+
+    /*!
+     * \brief Measure a kernel.
+     *
+     * If the kernel returns nothing, the wall clock time of each call is recorded. If
+     * it returns a floating point value, this value is taken as the time in seconds
+     * spent by the call. This allows kernels to exclude the preparation of their input
+     * data from the measurement, but the hardware performance counters are not
+     * recorded for them because they include the preparation.
+     *
+     * \param name The name of the kernel in the results
+     * \param numItems The number of work items (e.g., elements or faces) processed by
+     *                 a single call of the kernel.
+     * \param kernel The callable which runs the kernel once
+     */
+    template <class Kernel>
+    const Result& run(const std::string& name, std::size_t numItems, Kernel&& kernel)
+    {
+        static constexpr bool selfTimed = !std::is_void_v<decltype(kernel())>;
+
+        for (unsigned i = 0; i < warmupRepetitions_; ++i)
+            kernel();
+
+        Result result;
+        result.name = name;
+        result.numItems = numItems;
+        for (unsigned i = 0; i < repetitions_; ++i) {
+            if constexpr (selfTimed)
+                result.times.push_back(static_cast<double>(kernel()));
+            else {
+                counters_.start();
+                auto startTime = std::chrono::steady_clock::now();
+
+                kernel();
+
+                std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+                auto counterValues = counters_.stop();
+
+                result.times.push_back(duration.count());
+                if (counters_.available())
+                    result.counters.push_back(counterValues);
+            }
+        }
+
+        results_.push_back(std::move(result));
+        return results_.back();
+    }
+
+    /*!
+     * \brief Returns the results of all kernels which have been measured so far.
+     */
+    const std::vector<Result>& results() const
+    { return results_; }
+
+    /*!
+     * \brief Write the results of all kernels to a stream using the JSON format.
+     */
+    void writeJson(std::ostream& os) const
+    {
+        os << "{\n  \"metadata\": {";
+        for (std::size_t i = 0; i < metadata_.size(); ++i)
+            os << (i == 0 ? "\n" : ",\n")
+               << "    " << toJson_(metadata_[i].first) << ": " << metadata_[i].second;
+        os << "\n  },\n  \"benchmarks\": [";
+
+        for (std::size_t resultIdx = 0; resultIdx < results_.size(); ++resultIdx) {
+            const Result& r = results_[resultIdx];
+            os << (resultIdx == 0 ? "\n" : ",\n")
+               << "    {\n"
+               << "      \"name\": " << toJson_(r.name) << ",\n"
+               << "      \"items\": " << r.numItems << ",\n"
+               << "      \"repetitions\": " << r.times.size() << ",\n"
+               << "      \"times\": [";
+            for (std::size_t i = 0; i < r.times.size(); ++i)
+                os << (i == 0 ? "" : ", ") << toJson_(r.times[i]);
+            os << "],\n"
+               << "      \"min\": " << toJson_(r.min()) << ",\n"
+               << "      \"mean\": " << toJson_(r.mean()) << ",\n"
+               << "      \"median\": " << toJson_(r.median()) << ",\n"
+               << "      \"medianPerItem\": " << toJson_(r.median()/std::max<std::size_t>(r.numItems, 1));
+
+            if (!r.counters.empty()) {
+                os << ",\n      \"counters\": {";
+                for (unsigned eventIdx = 0; eventIdx < HardwareCounters::numEvents; ++eventIdx)
+                    os << (eventIdx == 0 ? "\n" : ",\n")
+                       << "        " << toJson_(std::string(HardwareCounters::eventName(eventIdx)))
+                       << ": " << r.counterMedian(eventIdx);
+                os << "\n      }";
+            }
+            os << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+private:
+    static std::string toJson_(const std::string& value)
+    {
+        std::string result = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result + "\"";
+    }
+
+    static std::string toJson_(const char* value)
+    { return toJson_(std::string(value)); }
+
+    static std::string toJson_(bool value)
+    { return value ? "true" : "false"; }
+
+    template <class T>
+    static std::string toJson_(const T& value)
+    { return std::to_string(value); }
+
+    static std::string toJson_(double value)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9g", value);
+        return buf;
+    }
+
+    unsigned repetitions_;
+    unsigned warmupRepetitions_;
+    HardwareCounters counters_;
+    std::vector<std::pair<std::string, std::string> > metadata_;
+    std::vector<Result> results_;
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,408 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Provides a hierarchical profiler for scoped code regions.
+ *
+ * Regions are marked using the EWOMS_TIMEBLOCK(name) macro, which measures the time
+ * spent until the end of the enclosing scope. The macro expands to nothing unless the
+ * code is compiled with EWOMS_ENABLE_PROFILING set to a non-zero value, i.e., the
+ * profiler has no cost at all if it is disabled.
+ */
+#ifndef EWOMS_PROFILER_HH
+#define EWOMS_PROFILER_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace Opm {
+/*!
+ * \ingroup Common
+ *
+ * \brief Records the time spent in nested code regions for each thread.
+ *
+ * Each thread which enters a region gets its own data which is not shared with other
+ * threads, i.e., apart from the registration of new threads and regions, no
+ * synchronization is required. For each thread, the most recent events are kept in a
+ * ring buffer which can be exported in the Chrome trace event format, while the
+ * accumulated statistics of each region cover the whole run. Note that the statistics
+ * of regions which are entered by multiple threads are summed over the threads.
+ */
+class Profiler
+{
+public:
+    //! The maximum number of events which are kept for the trace of each thread
+    static constexpr std::size_t ringBufferSize = 1 << 16;
+
+    /*!
+     * \brief Returns the profiler object of the process.
+     */
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    /*!
+     * \brief Register a region and return its index.
+     *
+     * \param name The name of the region. This must point to memory which lives as
+     *             long as the program.
+     */
+    unsigned registerRegion(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        regionNames_.push_back(name);
+        return static_cast<unsigned>(regionNames_.size() - 1);
+    }
+
+    /*!
+     * \brief Enter a region on the current thread.
+     */
+    void beginRegion(unsigned regionIdx)
+    {
+        auto& data = localThreadData_();
+        data.openRegions.push_back(OpenRegion{regionIdx, now_(), /*childNs=*/0});
+    }
+
+    /*!
+     * \brief Leave the most recently entered region of the current thread.
+     */
+    void endRegion()
+    {
+        auto& data = localThreadData_();
+        uint64_t endNs = now_();
+
+        const OpenRegion region = data.openRegions.back();
+        data.openRegions.pop_back();
+
+        uint64_t durationNs = endNs - region.beginNs;
+        if (data.stats.size() <= region.regionIdx)
+            data.stats.resize(region.regionIdx + 1);
+        auto& stats = data.stats[region.regionIdx];
+        ++stats.numCalls;
+        stats.inclusiveNs += durationNs;
+        stats.childNs += region.childNs;
+
+        if (!data.openRegions.empty())
+            data.openRegions.back().childNs += durationNs;
+
+        data.events[data.numEvents % ringBufferSize] =
+            Event{region.beginNs, endNs, region.regionIdx,
+                  static_cast<uint32_t>(data.openRegions.size())};
+        ++data.numEvents;
+    }
+
+    /*!
+     * \brief Write the trace, and print a summary of all regions to an output stream.
+     *
+     * This method is collective, i.e., it must be called by all processes. The trace
+     * of each process is written to "$OUTPUT_DIR/$NAME.trace.json" (with "-$RANK"
+     * appended to the name for parallel runs) and the summary is only printed by the
+     * process of rank 0. No thread may be within a region while this method is called.
+     */
+    void report(const std::string& outputDir, const std::string& name, std::ostream& os)
+    {
+        int rank = 0;
+        int numProcesses = 1;
+#if HAVE_MPI
+        int mpiIsInitialized = 0;
+        MPI_Initialized(&mpiIsInitialized);
+        if (mpiIsInitialized) {
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+        }
+#endif
+
+        std::string fileName = outputDir + "/" + name;
+        if (numProcesses > 1)
+            fileName += "-" + std::to_string(rank);
+        fileName += ".trace.json";
+        writeChromeTrace(fileName, rank);
+
+        printSummary_(os, rank, numProcesses);
+    }
+
+    /*!
+     * \brief Write the events kept by the ring buffers of all threads to a file using
+     *        the Chrome trace event format.
+     *
+     * The resulting file can be visualized using e.g. chrome://tracing or Perfetto.
+     */
+    void writeChromeTrace(const std::string& fileName, int rank) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::ofstream os(fileName);
+        os << std::fixed << std::setprecision(3);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (std::size_t threadIdx = 0; threadIdx < threadData_.size(); ++threadIdx) {
+            const auto& data = *threadData_[threadIdx];
+            uint64_t firstEventIdx =
+                data.numEvents > ringBufferSize ? data.numEvents - ringBufferSize : 0;
+            for (uint64_t eventIdx = firstEventIdx; eventIdx < data.numEvents; ++eventIdx) {
+                const Event& event = data.events[eventIdx % ringBufferSize];
+                os << (first ? "\n" : ",\n")
+                   << "{\"name\":\"" << regionNames_[event.regionIdx] << "\""
+                   << ",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":" << threadIdx
+                   << ",\"ts\":" << static_cast<double>(event.beginNs)/1e3
+                   << ",\"dur\":" << static_cast<double>(event.endNs - event.beginNs)/1e3
+                   << ",\"args\":{\"depth\":" << event.depth << "}}";
+                first = false;
+            }
+        }
+        os << "\n]}\n";
+    }
+
+private:
+    struct Event
+    {
+        uint64_t beginNs;
+        uint64_t endNs;
+        uint32_t regionIdx;
+        uint32_t depth;
+    };
+
+    struct OpenRegion
+    {
+        unsigned regionIdx;
+        uint64_t beginNs;
+        uint64_t childNs;
+    };
+
+    struct RegionStats
+    {
+        uint64_t numCalls{0};
+        uint64_t inclusiveNs{0};
+        uint64_t childNs{0};
+    };
+
+    struct ThreadData
+    {
+        ThreadData()
+            : events(ringBufferSize)
+        { openRegions.reserve(32); }
+
+        std::vector<OpenRegion> openRegions;
+        std::vector<RegionStats> stats;
+        std::vector<Event> events;
+        uint64_t numEvents{0};
+    };
+
+    Profiler()
+        : epoch_(std::chrono::steady_clock::now())
+    {}
+
+    uint64_t now_() const
+    {
+        auto dt = std::chrono::steady_clock::now() - epoch_;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+    }
+
+    ThreadData& localThreadData_()
+    {
+        thread_local ThreadData* data = nullptr;
+        if (!data) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threadData_.emplace_back(new ThreadData);
+            data = threadData_.back().get();
+        }
+        return *data;
+    }
+
+    // returns the statistics of all regions of the local process. the regions are
+    // identified by name, so regions which are registered multiple times get merged.
+    std::map<std::string, RegionStats> localStats_() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::map<std::string, RegionStats> result;
+        for (const auto& data : threadData_) {
+            for (std::size_t regionIdx = 0; regionIdx < data->stats.size(); ++regionIdx) {
+                const auto& stats = data->stats[regionIdx];
+                if (stats.numCalls == 0)
+                    continue;
+
+                auto& resultStats = result[regionNames_[regionIdx]];
+                resultStats.numCalls += stats.numCalls;
+                resultStats.inclusiveNs += stats.inclusiveNs;
+                resultStats.childNs += stats.childNs;
+            }
+        }
+        return result;
+    }
+
+    void printSummary_(std::ostream& os, int rank, int numProcesses) const
+    {
+        // serialize the statistics of the local process
+        std::ostringstream localOss;
+        for (const auto& [regionName, stats] : localStats_())
+            localOss << regionName << " " << stats.numCalls << " " << stats.inclusiveNs
+                     << " " << stats.inclusiveNs - stats.childNs << "\n";
+        std::string localString = localOss.str();
+
+        // collect them on the first process
+        std::string allString = localString;
+#if HAVE_MPI
+        if (numProcesses > 1) {
+            int localSize = static_cast<int>(localString.size());
+            std::vector<int> sizes(numProcesses);
+            MPI_Gather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, /*root=*/0, MPI_COMM_WORLD);
+
+            std::vector<int> offsets(numProcesses, 0);
+            for (int i = 1; i < numProcesses; ++i)
+                offsets[i] = offsets[i - 1] + sizes[i - 1];
+
+            std::vector<char> allChars(rank == 0 ? offsets.back() + sizes.back() : 0);
+            MPI_Gatherv(localString.data(), localSize, MPI_CHAR,
+                        allChars.data(), sizes.data(), offsets.data(), MPI_CHAR,
+                        /*root=*/0, MPI_COMM_WORLD);
+            allString.assign(allChars.begin(), allChars.end());
+        }
+#endif
+
+        if (rank != 0)
+            return;
+
+        struct SummaryEntry
+        {
+            uint64_t numCalls{0};
+            double inclusiveSum{0.0};
+            double inclusiveMax{0.0};
+            double selfSum{0.0};
+        };
+        std::map<std::string, SummaryEntry> summary;
+
+        std::istringstream iss(allString);
+        std::string regionName;
+        uint64_t numCalls, inclusiveNs, selfNs;
+        while (iss >> regionName >> numCalls >> inclusiveNs >> selfNs) {
+            auto& entry = summary[regionName];
+            entry.numCalls += numCalls;
+            entry.inclusiveSum += static_cast<double>(inclusiveNs)/1e9;
+            entry.inclusiveMax = std::max(entry.inclusiveMax, static_cast<double>(inclusiveNs)/1e9);
+            entry.selfSum += static_cast<double>(selfNs)/1e9;
+        }
+
+        std::vector<std::pair<std::string, SummaryEntry>> sortedSummary(summary.begin(), summary.end());
+        std::sort(sortedSummary.begin(), sortedSummary.end(),
+                  [](const auto& a, const auto& b)
+                  { return a.second.inclusiveSum > b.second.inclusiveSum; });
+
+        std::size_t nameWidth = 6;
+        for (const auto& entry : sortedSummary)
+            nameWidth = std::max(nameWidth, entry.first.size());
+
+        os << "Profile of " << numProcesses << " process(es), "
+           << "times are summed over the threads of each process:\n"
+           << "    " << std::left << std::setw(static_cast<int>(nameWidth)) << "Region"
+           << std::right
+           << std::setw(12) << "Calls"
+           << std::setw(16) << "Avg. incl. [s]"
+           << std::setw(16) << "Max. incl. [s]"
+           << std::setw(16) << "Avg. self [s]" << "\n";
+        for (const auto& [name, entry] : sortedSummary) {
+            os << "    " << std::left << std::setw(static_cast<int>(nameWidth)) << name
+               << std::right
+               << std::setw(12) << entry.numCalls
+               << std::setw(16) << entry.inclusiveSum/numProcesses
+               << std::setw(16) << entry.inclusiveMax
+               << std::setw(16) << entry.selfSum/numProcesses << "\n";
+        }
+
+        uint64_t numDropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& data : threadData_)
+                if (data->numEvents > ringBufferSize)
+                    numDropped += data->numEvents - ringBufferSize;
+        }
+        if (numDropped > 0)
+            os << "    (" << numDropped << " events of the first process were dropped from its trace)\n";
+        os << std::flush;
+    }
+
+    std::chrono::steady_clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::vector<const char*> regionNames_;
+    std::vector<std::unique_ptr<ThreadData>> threadData_;
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Measures the time spent in a region of code until the object goes out of scope.
+ *
+ * Usually, this class should not be used directly, but via the EWOMS_TIMEBLOCK macro.
+ */
+class ProfilerRegion
+{
+public:
+    explicit ProfilerRegion(unsigned regionIdx)
+    { Profiler::instance().beginRegion(regionIdx); }
+
+    ProfilerRegion(const ProfilerRegion&) = delete;
+    ProfilerRegion& operator=(const ProfilerRegion&) = delete;
+
+    ~ProfilerRegion()
+    { Profiler::instance().endRegion(); }
+};
+
+} // namespace Opm
+
+#define EWOMS_PROFILER_CONCAT_IMPL_(a, b) a ## b
+#define EWOMS_PROFILER_CONCAT_(a, b) EWOMS_PROFILER_CONCAT_IMPL_(a, b)
+
+#if EWOMS_ENABLE_PROFILING
+#define EWOMS_TIMEBLOCK(name)                                           \
+    static const unsigned EWOMS_PROFILER_CONCAT_(ewomsProfilerRegionIdx, __LINE__) = \
+        ::Opm::Profiler::instance().registerRegion(#name);              \
+    ::Opm::ProfilerRegion EWOMS_PROFILER_CONCAT_(ewomsProfilerRegion, __LINE__) \
+        (EWOMS_PROFILER_CONCAT_(ewomsProfilerRegionIdx, __LINE__))
+
+#define EWOMS_PROFILER_REPORT(outputDir, name, os)                     \
+    ::Opm::Profiler::instance().report(outputDir, name, os)
+#else
+#define EWOMS_TIMEBLOCK(name) do {} while (false)
+#define EWOMS_PROFILER_REPORT(outputDir, name, os) do {} while (false)
+#endif
+
+#endif
@@ -32,6 +32,7 @@
 #include <opm/models/utils/parametersystem.hh>
 
 #include <opm/models/utils/basicproperties.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
@@ -154,6 +155,7 @@ public:
 
         int exceptionThrown = 0;
         std::string what;
+        vanguardTimer_.start();
         try
         { vanguard_.reset(new Vanguard(*this)); }
         catch (const std::exception& e) {
@@ -192,6 +194,7 @@ public:
             assert(!all_what.empty());
             throw std::runtime_error("Could not distribute the vanguard data: " + all_what.front());
         }
+        vanguardTimer_.stop();
 
         if (verbose_)
             std::cout << "Allocating the model\n" << std::flush;
@@ -380,6 +383,15 @@ public:
     const Timer& setupTimer() const
     { return setupTimer_; }
 
+    /*!
+     * \brief Returns a reference to the timer object which measures the time needed to
+     *        create and distribute the grid
+     *
+     * This is a part of the setup time.
+     */
+    const Timer& vanguardTimer() const
+    { return vanguardTimer_; }
+
     /*!
      * \brief Returns a reference to the timer object which measures the time needed to
      *        run the simulation
@@ -811,6 +823,9 @@ public:
         executionTimer_.stop();
 
         EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->finalize());
+
+        // write the trace and print the summary of the profiler if it is compiled in
+        EWOMS_PROFILER_REPORT(problem_->outputDir(), problem_->name(), std::cout);
     }
 
     /*!
@@ -985,6 +1000,7 @@ private:
     Scalar episodeLength_;
 
     Timer setupTimer_;
+    Timer vanguardTimer_;
     Timer executionTimer_;
     Timer prePostProcessTimer_;
     Timer linearizeTimer_;
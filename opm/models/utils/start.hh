@@ -87,6 +87,9 @@ static inline void registerAllParameters_(bool finalizeRegistration = true)
     EWOMS_REGISTER_PARAM(TypeTag, int, PrintParameters,
                          "Print the values of the run-time parameters at the "
                          "start of the simulation");
+    EWOMS_REGISTER_PARAM(TypeTag, bool, MemoryDryRun,
+                         "Only set up the grid and the model, print the estimated "
+                         "memory footprint of the simulation and exit");
 
     Simulator::registerParameters();
     ThreadManager::registerParameters();
@@ -351,6 +354,10 @@ static inline int start(int argc, char **argv,  bool registerParams=true)
             else
                 std::cout << "opm models " << versionString
                           << " will now start the simulation. " << std::endl;
+
+            if (ThreadManager::maxThreads() > 1)
+                std::cout << "Using " << ThreadManager::maxThreads() << " threads per process, "
+                          << "thread pinning: " << ThreadManager::threadPinning() << std::endl;
         }
 
         // print the parameters if requested
@@ -388,6 +395,15 @@ static inline int start(int argc, char **argv,  bool registerParams=true)
         // deallocate the problem and before the time manager and the
         // grid
         Simulator simulator;
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, MemoryDryRun)) {
+            // the model did not allocate its caches, and the linear system and the
+            // structures of the linear solver are not allocated either. their
+            // footprints are estimated from the size of the discretization.
+            simulator.problem().printMemoryEstimate();
+            return 0;
+        }
+
         simulator.run();
 
         if (myRank == 0) {
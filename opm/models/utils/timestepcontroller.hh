@@ -0,0 +1,311 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Strategies to select the size of the next time step.
+ */
+#ifndef EWOMS_TIME_STEP_CONTROLLER_HH
+#define EWOMS_TIME_STEP_CONTROLLER_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace Opm {
+
+/*!
+ * \brief The base class for all time step controllers.
+ *
+ * A controller is notified about each successful and about each failed attempt to
+ * integrate a time step. Based on this, it proposes the size of the next time step.
+ *
+ * All controllers remember recent failures: If the time integration failed using a
+ * step size dt, the proposed step sizes are limited to a fraction of dt for a number
+ * of subsequent successful steps. This avoids that the step size grows back to a
+ * value which is likely to fail again.
+ */
+template <class Scalar>
+class TimeStepController
+{
+public:
+    /*!
+     * \param failureMemory The number of successful time steps for which the step size
+     *                      of the most recent failure is remembered. 0 disables this.
+     * \param failureSafetyFactor The fraction of the failed step size to which the
+     *                            step sizes are limited during this period
+     */
+    TimeStepController(unsigned failureMemory, Scalar failureSafetyFactor)
+        : failureMemory_(failureMemory)
+        , failureSafetyFactor_(failureSafetyFactor)
+    {}
+
+    virtual ~TimeStepController() = default;
+
+    /*!
+     * \brief Create a controller given its name.
+     */
+    static std::unique_ptr<TimeStepController> create(const std::string& name,
+                                                   unsigned failureMemory,
+                                                   Scalar failureSafetyFactor,
+                                                   Scalar targetChange,
+                                                   Scalar maxGrowth);
+
+    /*!
+     * \brief Returns the name of the controller.
+     */
+    virtual std::string name() const = 0;
+
+    /*!
+     * \brief Returns true iff the controller uses the change of the solution over a time
+     *        step.
+     *
+     * If this is false, the change does not need to be computed.
+     */
+    virtual bool needsSolutionChange() const
+    { return false; }
+
+    /*!
+     * \brief Notify the controller about a successfully integrated time step.
+     *
+     * \param dt The size of the time step
+     * \param solutionChange The maximum relative change of the solution over the step
+     */
+    void registerSuccess(Scalar dt, Scalar solutionChange)
+    {
+        ++numSucceeded_;
+        if (stepsSinceFailure_ < failureMemory_)
+            ++stepsSinceFailure_;
+        registerSuccess_(dt, solutionChange);
+    }
+
+    /*!
+     * \brief Notify the controller about a failed attempt to integrate a time step.
+     *
+     * \param dt The size of the time step which could not be integrated
+     */
+    void registerFailure(Scalar dt)
+    {
+        ++numFailed_;
+        lastFailedDt_ = dt;
+        stepsSinceFailure_ = 0;
+    }
+
+    /*!
+     * \brief Propose the size of the next time step.
+     *
+     * \param dt The size of the time step which was just integrated
+     * \param iterationDt The step size suggested by the non-linear solver based on the
+     *                    number of iterations it required
+     */
+    Scalar suggestTimeStepSize(Scalar dt, Scalar iterationDt) const
+    {
+        Scalar nextDt = suggestTimeStepSize_(dt, iterationDt);
+        if (stepsSinceFailure_ < failureMemory_)
+            nextDt = std::min(nextDt, failureSafetyFactor_*lastFailedDt_);
+        return nextDt;
+    }
+
+    /*!
+     * \brief Returns the number of time steps which were integrated successfully.
+     */
+    unsigned numSucceeded() const
+    { return numSucceeded_; }
+
+    /*!
+     * \brief Returns the number of failed attempts to integrate a time step.
+     */
+    unsigned numFailed() const
+    { return numFailed_; }
+
+protected:
+    virtual void registerSuccess_(Scalar, Scalar)
+    {}
+
+    virtual Scalar suggestTimeStepSize_(Scalar dt, Scalar iterationDt) const = 0;
+
+private:
+    unsigned failureMemory_;
+    Scalar failureSafetyFactor_;
+
+    unsigned stepsSinceFailure_{std::numeric_limits<unsigned>::max()};
+    Scalar lastFailedDt_{0.0};
+
+    unsigned numSucceeded_{0};
+    unsigned numFailed_{0};
+};
+
+/*!
+ * \brief Select the step size based on the number of iterations of the non-linear
+ *        solver.
+ *
+ * The actual rule is implemented by NewtonMethod::suggestTimeStepSize().
+ */
+template <class Scalar>
+class IterationCountTimeStepController : public TimeStepController<Scalar>
+{
+public:
+    using TimeStepController<Scalar>::TimeStepController;
+
+    std::string name() const override
+    { return "iteration-count"; }
+
+protected:
+    Scalar suggestTimeStepSize_(Scalar, Scalar iterationDt) const override
+    { return iterationDt; }
+};
+
+/*!
+ * \brief Select the step size using a PID controller on the relative change of the
+ *        solution.
+ *
+ * The step size is chosen such that the maximum relative change of the solution per
+ * time step stays close to a target value. The coefficients of the controller are the
+ * ones proposed by Valli et al. ("Control strategies for timestep selection in finite
+ * element simulation of incompressible flows and coupled reaction-convection-diffusion
+ * processes", 2005).
+ */
+template <class Scalar>
+class PidTimeStepController : public TimeStepController<Scalar>
+{
+    using ParentType = TimeStepController<Scalar>;
+
+public:
+    /*!
+     * \copydoc TimeStepController::TimeStepController
+     * \param targetChange The targeted relative change of the solution per time step
+     * \param maxGrowth The maximum factor by which the step size is increased
+     */
+    PidTimeStepController(unsigned failureMemory,
+                       Scalar failureSafetyFactor,
+                       Scalar targetChange,
+                       Scalar maxGrowth)
+        : ParentType(failureMemory, failureSafetyFactor)
+        , targetChange_(targetChange)
+        , maxGrowth_(maxGrowth)
+    {}
+
+    std::string name() const override
+    { return "pid"; }
+
+    bool needsSolutionChange() const override
+    { return true; }
+
+protected:
+    void registerSuccess_(Scalar, Scalar solutionChange) override
+    {
+        // keep the changes of the last three time steps. the last entry is the most
+        // recent one.
+        changes_[0] = changes_[1];
+        changes_[1] = changes_[2];
+        changes_[2] = std::max(solutionChange, std::numeric_limits<Scalar>::epsilon());
+        numChanges_ = std::min(numChanges_ + 1, 3u);
+    }
+
+    Scalar suggestTimeStepSize_(Scalar dt, Scalar) const override
+    {
+        if (numChanges_ == 0)
+            return dt;
+
+        const Scalar e2 = changes_[2];
+        Scalar factor;
+        if (numChanges_ < 3 || e2 > targetChange_)
+            // not enough history or the change was too large: use a proportional
+            // controller
+            factor = targetChange_/e2;
+        else {
+            const Scalar e0 = changes_[0];
+            const Scalar e1 = changes_[1];
+            const Scalar kP = 0.075;
+            const Scalar kI = 0.175;
+            const Scalar kD = 0.01;
+            factor =
+                std::pow(e1/e2, kP)
+                * std::pow(targetChange_/e2, kI)
+                * std::pow(e1*e1/(e0*e2), kD);
+        }
+
+        return dt*std::min(factor, maxGrowth_);
+    }
+
+private:
+    Scalar targetChange_;
+    Scalar maxGrowth_;
+
+    std::array<Scalar, 3> changes_{};
+    unsigned numChanges_{0};
+};
+
+/*!
+ * \brief Select the step size as the minimum of the PID and the iteration count
+ *        controllers.
+ */
+template <class Scalar>
+class PidAndIterationCountTimeStepController : public PidTimeStepController<Scalar>
+{
+    using ParentType = PidTimeStepController<Scalar>;
+
+public:
+    using ParentType::ParentType;
+
+    std::string name() const override
+    { return "pid+iteration-count"; }
+
+protected:
+    Scalar suggestTimeStepSize_(Scalar dt, Scalar iterationDt) const override
+    { return std::min(ParentType::suggestTimeStepSize_(dt, iterationDt), iterationDt); }
+};
+
+template <class Scalar>
+std::unique_ptr<TimeStepController<Scalar>>
+TimeStepController<Scalar>::create(const std::string& name,
+                                   unsigned failureMemory,
+                                   Scalar failureSafetyFactor,
+                                   Scalar targetChange,
+                                   Scalar maxGrowth)
+{
+    if (name == "iteration-count")
+        return std::make_unique<IterationCountTimeStepController<Scalar>>(failureMemory,
+                                                                          failureSafetyFactor);
+    else if (name == "pid")
+        return std::make_unique<PidTimeStepController<Scalar>>(failureMemory,
+                                                               failureSafetyFactor,
+                                                               targetChange,
+                                                               maxGrowth);
+    else if (name == "pid+iteration-count")
+        return std::make_unique<PidAndIterationCountTimeStepController<Scalar>>(failureMemory,
+                                                                                failureSafetyFactor,
+                                                                                targetChange,
+                                                                                maxGrowth);
+
+    throw std::runtime_error("Unknown time step controller '"+name+"'. Valid controllers "
+                             "are 'iteration-count', 'pid' and 'pid+iteration-count'");
+}
+
+} // namespace Opm
+
+#endif
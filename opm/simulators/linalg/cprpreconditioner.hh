@@ -0,0 +1,278 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::CprPreconditioner
+ */
+#ifndef EWOMS_CPR_PRECONDITIONER_HH
+#define EWOMS_CPR_PRECONDITIONER_HH
+
+#include "pressuresystem.hh"
+
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/propertysystem.hh>
+#include <opm/models/utils/parametersystem.hh>
+#include <opm/simulators/linalg/linalgproperties.hh>
+#include <opm/simulators/linalg/ilufirstelement.hh> //definitions needed in next header
+
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+
+#include <cstddef>
+#include <memory>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief A constrained pressure residual (CPR) preconditioner for block systems.
+ *
+ * The preconditioner works in two stages:
+ *
+ * - A scalar system for the pressure is extracted from the block matrix using
+ *   quasi-IMPES weights (see PressureSystem). One V-cycle of an algebraic multigrid
+ *   method is used to approximately solve it for the residual.
+ * - The pressure correction is extended to a correction of the full system. The
+ *   residual which remains after this correction is then smoothed using ILU(0) for the
+ *   full block system.
+ *
+ * The first stage deals with the (near) elliptic character of the pressure, the second
+ * stage with the local and the hyperbolic parts of the system.
+ */
+template <class Matrix, class Vector>
+class CprPreconditioner : public Dune::Preconditioner<Vector, Vector>
+{
+    using Scalar = typename Vector::field_type;
+    static constexpr int numEq = Vector::block_type::dimension;
+
+    using PressureSystem = Opm::Linear::PressureSystem<Scalar, numEq>;
+    using PressureMatrix = typename PressureSystem::Matrix;
+    using PressureVector = typename PressureSystem::Vector;
+    using PressureOperator = Dune::MatrixAdapter<PressureMatrix, PressureVector, PressureVector>;
+    using PressureSmoother = Dune::SeqSSOR<PressureMatrix, PressureVector, PressureVector>;
+    using PressureAmg = Dune::Amg::AMG<PressureOperator, PressureVector, PressureSmoother>;
+
+    using Smoother = Dune::SeqILU<Matrix, Vector, Vector>;
+
+public:
+    using matrix_type = Matrix;
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = Scalar;
+
+    /*!
+     * \param matrix The block matrix of the system
+     * \param pressureIdx The index of the pressure within the blocks
+     * \param coarsenTarget The number of unknowns of the coarsest level of the AMG
+     * \param dimension The dimension of the grid. This is used to determine the
+     *                  aggregate sizes of the AMG.
+     * \param relaxationFactor The relaxation factor of the ILU(0) smoother
+     */
+    CprPreconditioner(const Matrix& matrix,
+                      int pressureIdx,
+                      int coarsenTarget,
+                      int dimension,
+                      Scalar relaxationFactor)
+        : matrix_(matrix)
+        , pressureSystem_(pressureIdx)
+        , smoother_(matrix, relaxationFactor)
+    {
+        pressureSystem_.update(matrix);
+        pressureOperator_ = std::make_unique<PressureOperator>(pressureSystem_.matrix());
+
+        using SmootherArgs = typename Dune::Amg::SmootherTraits<PressureSmoother>::Arguments;
+        SmootherArgs smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1.0;
+
+        using CoarsenCriterion = Dune::Amg::
+            CoarsenCriterion<Dune::Amg::SymmetricCriterion<PressureMatrix, Dune::Amg::FirstDiagonal> >;
+        CoarsenCriterion coarsenCriterion(/*maxLevel=*/15, coarsenTarget);
+        coarsenCriterion.setDefaultValuesAnisotropic(dimension, /*aggregateSizePerDim=*/3);
+        coarsenCriterion.setDebugLevel(0); // make the AMG shut up
+        coarsenCriterion.setMinCoarsenRate(1.05);
+        coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
+        coarsenCriterion.setSkipIsolated(false);
+
+        pressureAmg_ = std::make_unique<PressureAmg>(*pressureOperator_, coarsenCriterion, smootherArgs);
+    }
+
+    //! \copydoc Dune::Preconditioner::category()
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+    /*!
+     * \copydoc Dune::Preconditioner::pre()
+     */
+    void pre(Vector& x, Vector& b) override
+    {
+        pressureSystem_.assembleRhs(b, pressureRhs_);
+        pressureUpdate_.resize(pressureRhs_.size());
+        pressureUpdate_ = 0.0;
+        pressureAmg_->pre(pressureUpdate_, pressureRhs_);
+
+        smoother_.pre(x, b);
+    }
+
+    /*!
+     * \copydoc Dune::Preconditioner::apply()
+     */
+    void apply(Vector& v, const Vector& d) override
+    {
+        // first stage: approximately solve the pressure system for the residual
+        pressureSystem_.assembleRhs(d, pressureRhs_);
+        pressureUpdate_ = 0.0;
+        pressureAmg_->apply(pressureUpdate_, pressureRhs_);
+
+        int pressureIdx = pressureSystem_.pressureIdx();
+        v = 0.0;
+        for (std::size_t rowIdx = 0; rowIdx < v.size(); ++rowIdx)
+            v[rowIdx][pressureIdx] = pressureUpdate_[rowIdx][0];
+
+        // second stage: smooth the residual which remains after the pressure
+        // correction on the full system
+        if (!residual_) {
+            residual_ = std::make_unique<Vector>(d);
+            correction_ = std::make_unique<Vector>(v);
+        }
+        *residual_ = d;
+        matrix_.mmv(v, *residual_);
+
+        *correction_ = 0.0;
+        smoother_.apply(*correction_, *residual_);
+        v += *correction_;
+    }
+
+    /*!
+     * \copydoc Dune::Preconditioner::post()
+     */
+    void post(Vector& x) override
+    {
+        pressureAmg_->post(pressureUpdate_);
+        smoother_.post(x);
+    }
+
+private:
+    const Matrix& matrix_;
+
+    PressureSystem pressureSystem_;
+    PressureVector pressureRhs_;
+    PressureVector pressureUpdate_;
+    std::unique_ptr<PressureOperator> pressureOperator_;
+    std::unique_ptr<PressureAmg> pressureAmg_;
+
+    Smoother smoother_;
+
+    std::unique_ptr<Vector> residual_;
+    std::unique_ptr<Vector> correction_;
+};
+
+/*!
+ * \brief Wraps the CPR preconditioner so that it can be used by the linear solver
+ *        backends.
+ *
+ * The index of the pressure within the equation blocks is specified by the
+ * CprPressureIndex property. The preconditioner is applied to the overlapping matrix of
+ * each process, i.e., it is combined with the overlapping Schwarz method of the
+ * OverlappingPreconditioner in parallel runs.
+ */
+template <class TypeTag>
+class PreconditionerWrapperCPR
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
+    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+
+    static constexpr int pressureIdx = getPropValue<TypeTag, Properties::CprPressureIndex>();
+    static constexpr int numEq = OverlappingVector::block_type::dimension;
+
+public:
+    using SequentialPreconditioner = CprPreconditioner<OverlappingMatrix, OverlappingVector>;
+
+    PreconditionerWrapperCPR()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, CprCoarsenTarget,
+                             "The coarsening target for the AMG of the pressure stage of the "
+                             "CPR preconditioner");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        int coarsenTarget = EWOMS_GET_PARAM(TypeTag, int, CprCoarsenTarget);
+
+        seqPreCond_ = new SequentialPreconditioner(matrix,
+                                                   pressureIdx,
+                                                   coarsenTarget,
+                                                   GridView::dimension,
+                                                   relaxationFactor);
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    /*!
+     * \brief Add the memory footprint of the CPR preconditioner for a given matrix.
+     *
+     * This comprises the ILU(0) factors of the block matrix and the scalar pressure
+     * matrix. The hierarchy of the AMG is not considered.
+     */
+    void addMemoryUsage(MemoryUsage& usage, const OverlappingMatrix& matrix) const
+    { estimateMemoryUsage(usage, matrix.N(), matrix.nonzeroes()); }
+
+    /*!
+     * \brief Add the memory footprint of the CPR preconditioner for a matrix with a given
+     *        number of rows and non-zero blocks.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage, std::size_t numRows, std::size_t numNonzeros) const
+    {
+        using PressureMatrix = typename PressureSystem<Scalar, numEq>::Matrix;
+
+        // the ILU(0) factors, the pressure matrix and the weights of the equations
+        usage.add("Preconditioner",
+                  estimatedMemoryUsageOfMatrix<OverlappingMatrix>(numRows, numNonzeros)
+                  + estimatedMemoryUsageOfMatrix<PressureMatrix>(numRows, numNonzeros)
+                  + numRows*numEq*sizeof(Scalar));
+    }
+
+    void cleanup()
+    {
+        delete seqPreCond_;
+        seqPreCond_ = nullptr;
+    }
+
+private:
+    SequentialPreconditioner *seqPreCond_{nullptr};
+};
+
+}} // namespace Linear, Opm
+
+#endif
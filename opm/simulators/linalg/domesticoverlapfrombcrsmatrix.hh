@@ -32,8 +32,10 @@
 #include "globalindices.hh"
 
 #include <opm/models/parallel/mpibuffer.hh>
+#include <opm/models/utils/memoryusage.hh>
 
 #include <algorithm>
+#include <cstddef>
 #include <limits>
 #include <set>
 #include <map>
@@ -268,6 +270,23 @@ public:
     void print() const
     { globalIndices_.print(); }
 
+    /*!
+     * \brief Add the memory footprints of the overlap and of its MPI buffers.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        usage.add("Overlap",
+                  foreignOverlap_.memoryUsage()
+                  + globalIndices_.memoryUsage()
+                  + memoryUsageOf(domesticOverlapWithPeer_)
+                  + memoryUsageOf(domesticOverlapByIndex_)
+                  + memoryUsageOf(borderDistance_)
+                  + memoryUsageOf(masterRank_));
+        usage.add("Linear solver MPI buffers",
+                  memoryUsageOfMappedPointees(numIndicesSendBuffer_)
+                  + memoryUsageOfMappedPointees(indicesSendBuffer_));
+    }
+
     /*!
      * \brief Returns a domestic index given a global one
      */
@@ -417,6 +436,9 @@ protected:
 
         // take the master ranks for the local indices from the
         // foreign overlap
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (unsigned i = 0; i < nLocal; ++i) {
             masterRank_[i] = foreignOverlap_.masterRank(static_cast<Index>(i));
         }
@@ -31,6 +31,7 @@
 #include "blacklist.hh"
 
 #include <opm/models/parallel/mpibuffer.hh>
+#include <opm/models/utils/memoryusage.hh>
 
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/istl/bcrsmatrix.hh>
@@ -38,8 +39,12 @@
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <map>
+#include <set>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #if HAVE_MPI
@@ -90,6 +95,7 @@ public:
 
         // calculate the set of local indices on the border (beware:
         // _not_ the native ones)
+        isLocalBorder_.resize(numLocal_, 0);
         auto it = borderList.begin();
         const auto& endIt = borderList.end();
         for (; it != endIt; ++it) {
@@ -97,9 +103,13 @@ public:
             if (localIdx < 0)
                 continue;
 
-            localBorderIndices_.insert(localIdx);
+            isLocalBorder_[static_cast<unsigned>(localIdx)] = 1;
         }
 
+        // sort the border list by local index and peer rank so that the index of a
+        // border index on a peer process can be looked up quickly
+        createPeerIndices_();
+
         // compute the set of processes which are neighbors of the
         // local process ...
         neighborPeerSet_.update(borderList);
@@ -147,7 +157,12 @@ public:
      * \brief Returns true iff a local index is a border index.
      */
     bool isBorder(Index localIdx) const
-    { return localBorderIndices_.count(localIdx) > 0; }
+    {
+        return
+            localIdx >= 0
+            && static_cast<size_t>(localIdx) < isLocalBorder_.size()
+            && isLocalBorder_[static_cast<unsigned>(localIdx)];
+    }
 
     /*!
      * \brief Returns true iff a local index is a border index shared with a
@@ -341,6 +356,21 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns the number of bytes occupied by the data structures of the
+     *        foreign overlap.
+     */
+    std::size_t memoryUsage() const
+    {
+        return memoryUsageOf(nativeToLocalIndices_)
+            + memoryUsageOf(localToNativeIndices_)
+            + memoryUsageOf(masterRank_)
+            + memoryUsageOf(isLocalBorder_)
+            + memoryUsageOf(peerIndices_)
+            + memoryUsageOf(foreignOverlapByLocalIndex_)
+            + memoryUsageOf(foreignOverlapByRank_);
+    }
+
 protected:
     // extend the foreign overlaps by 'overlapSize' levels. this uses
     // a greedy algorithm which extends the region by one level and
@@ -373,56 +403,77 @@ protected:
             return;
 
         // find the seed list for the next overlap level using the
-        // seed set for the current level
-        SeedList nextSeedList;
-        seedIt = seedList.begin();
-        for (; seedIt != seedEndIt; ++seedIt) {
-            Index nativeRowIdx = seedIt->index;
-            if (nativeToLocal(nativeRowIdx) < 0)
-                continue; // ignore blacklisted indices
-            ProcessRank peerRank = seedIt->peerRank;
-
-            // find all column indices in the row. The indices of the
-            // columns are the additional indices of the overlap which
-            // we would like to add
-            using ColIterator = typename BCRSMatrix::ConstColIterator;
-            ColIterator colIt = A[static_cast<unsigned>(nativeRowIdx)].begin();
-            ColIterator colEndIt = A[static_cast<unsigned>(nativeRowIdx)].end();
-            for (; colIt != colEndIt; ++colIt) {
-                Index nativeColIdx = static_cast<Index>(colIt.index());
-                Index localColIdx = nativeToLocal(nativeColIdx);
-
-                // ignore if the native index is not a local one
-                if (localColIdx < 0)
-                    continue;
-                // if the process is already is in the overlap of the
-                // column index, ignore this column index!
-                else if (foreignOverlapByLocalIndex_[static_cast<unsigned>(localColIdx)].count(peerRank) > 0)
-                    continue;
+        // seed set for the current level. the seeds are independent of each other, so
+        // the candidates for the next level are collected in parallel and duplicates are
+        // removed afterwards.
+        std::vector<IndexRankDist> seeds(seedList.begin(), seedList.end());
+        std::vector<IndexRankDist> candidates;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            std::vector<IndexRankDist> threadCandidates;
 
-                // check whether the new index is already in the overlap
-                bool hasIndex = false;
-                typename SeedList::iterator sIt = nextSeedList.begin();
-                typename SeedList::iterator sEndIt = nextSeedList.end();
-                for (; sIt != sEndIt; ++sIt) {
-                    if (sIt->index == nativeColIdx && sIt->peerRank == peerRank) {
-                        hasIndex = true;
-                        break;
-                    }
+#ifdef _OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+            for (size_t seedIdx = 0; seedIdx < seeds.size(); ++seedIdx) {
+                const IndexRankDist& seed = seeds[seedIdx];
+                Index nativeRowIdx = seed.index;
+                if (nativeToLocal(nativeRowIdx) < 0)
+                    continue; // ignore blacklisted indices
+                ProcessRank peerRank = seed.peerRank;
+
+                // find all column indices in the row. The indices of the
+                // columns are the additional indices of the overlap which
+                // we would like to add
+                using ColIterator = typename BCRSMatrix::ConstColIterator;
+                ColIterator colIt = A[static_cast<unsigned>(nativeRowIdx)].begin();
+                ColIterator colEndIt = A[static_cast<unsigned>(nativeRowIdx)].end();
+                for (; colIt != colEndIt; ++colIt) {
+                    Index nativeColIdx = static_cast<Index>(colIt.index());
+                    Index localColIdx = nativeToLocal(nativeColIdx);
+
+                    // ignore if the native index is not a local one
+                    if (localColIdx < 0)
+                        continue;
+                    // if the process is already is in the overlap of the
+                    // column index, ignore this column index!
+                    else if (foreignOverlapByLocalIndex_[static_cast<unsigned>(localColIdx)].count(peerRank) > 0)
+                        continue;
+
+                    // add the current processes to the seed list for the
+                    // next overlap level
+                    IndexRankDist newTuple;
+                    newTuple.index = nativeColIdx;
+                    newTuple.peerRank = peerRank;
+                    newTuple.borderDistance = seed.borderDistance + 1;
+                    threadCandidates.push_back(newTuple);
                 }
-                if (hasIndex)
-                    continue; // we already have this index
-
-                // add the current processes to the seed list for the
-                // next overlap level
-                IndexRankDist newTuple;
-                newTuple.index = nativeColIdx;
-                newTuple.peerRank = peerRank;
-                newTuple.borderDistance = seedIt->borderDistance + 1;
-                nextSeedList.push_back(newTuple);
             }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+            candidates.insert(candidates.end(), threadCandidates.begin(), threadCandidates.end());
         }
 
+        // each (index, peer rank) pair must only be added once. if there are multiple
+        // candidates for a pair, take the one with the smallest border distance.
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const IndexRankDist& a, const IndexRankDist& b)
+                  {
+                      return std::tie(a.index, a.peerRank, a.borderDistance)
+                          < std::tie(b.index, b.peerRank, b.borderDistance);
+                  });
+        auto candidatesEnd =
+            std::unique(candidates.begin(), candidates.end(),
+                        [](const IndexRankDist& a, const IndexRankDist& b)
+                        { return a.index == b.index && a.peerRank == b.peerRank; });
+
+        SeedList nextSeedList;
+        nextSeedList.assign(candidates.begin(), candidatesEnd);
+
         // clear the old seed list to save some memory
         seedList.clear();
 
@@ -451,14 +502,26 @@ protected:
         numLocal_ = localToNativeIndices_.size();
     }
 
+    // create the array of the border indices sorted by local index and peer rank
+    void createPeerIndices_()
+    {
+        peerIndices_.assign(borderList_.begin(), borderList_.end());
+
+        // stable sorting makes sure that the first entry of the border list wins if a
+        // (local index, peer rank) pair occurs multiple times
+        std::stable_sort(peerIndices_.begin(), peerIndices_.end(),
+                         [](const BorderIndex& a, const BorderIndex& b)
+                         { return std::tie(a.localIdx, a.peerRank) < std::tie(b.localIdx, b.peerRank); });
+    }
+
     Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
     {
-        auto it = borderList_.begin();
-        const auto& endIt = borderList_.end();
-        for (; it != endIt; ++it) {
-            if (it->localIdx == localIdx && it->peerRank == peerRank)
-                return it->peerIdx;
-        }
+        auto it = std::lower_bound(peerIndices_.begin(), peerIndices_.end(),
+                                   std::make_pair(localIdx, peerRank),
+                                   [](const BorderIndex& a, const std::pair<Index, ProcessRank>& b)
+                                   { return std::tie(a.localIdx, a.peerRank) < std::tie(b.first, b.second); });
+        if (it != peerIndices_.end() && it->localIdx == localIdx && it->peerRank == peerRank)
+            return it->peerIdx;
 
         return -1;
     }
@@ -542,6 +605,11 @@ protected:
             indicesSendBufs[neighborPeer].send(neighborPeer);
         }
 
+        // the (index, peer rank) pairs which are already in the seed list
+        std::set<std::pair<Index, ProcessRank> > seedKeys;
+        for (const auto& seed : seedList)
+            seedKeys.emplace(seed.index, seed.peerRank);
+
         // receive all data from the neighbors
         std::map<ProcessRank, MpiBuffer<unsigned> > numIndicesRcvBufs;
         std::map<ProcessRank, MpiBuffer<BorderIndex> > indicesRcvBufs;
@@ -576,16 +644,7 @@ protected:
                     continue;
 
                 // make sure the index is not already in the seed list
-                bool inSeedList = false;
-                auto seedIt = seedList.begin();
-                const auto& seedEndIt = seedList.end();
-                for (; seedIt != seedEndIt; ++seedIt) {
-                    if (seedIt->index == localIdx && seedIt->peerRank == peerRank) {
-                        inSeedList = true;
-                        break;
-                    }
-                }
-                if (inSeedList)
+                if (!seedKeys.emplace(localIdx, peerRank).second)
                     continue;
 
                 IndexRankDist seedEntry;
@@ -616,6 +675,9 @@ protected:
     {
         // determine the minimum rank for all indices
         masterRank_.resize(numLocal_);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (unsigned localIdx = 0; localIdx < numLocal_; ++localIdx) {
             unsigned masterRank = myRank_;
             if (isBorder(static_cast<Index>(localIdx))) {
@@ -679,9 +741,12 @@ protected:
     // index
     std::vector<ProcessRank> masterRank_;
 
-    // set of all local indices which are on the border of some remote
+    // flags for all local indices which are on the border of some remote
     // process
-    std::set<Index> localBorderIndices_;
+    std::vector<unsigned char> isLocalBorder_;
+
+    // the border list sorted by local index and peer rank
+    std::vector<BorderIndex> peerIndices_;
 
     // stores the set of process ranks which are in the overlap for a
     // given row index "owned" by the current rank. The second value
@@ -27,16 +27,22 @@
 #ifndef EWOMS_GLOBAL_INDICES_HH
 #define EWOMS_GLOBAL_INDICES_HH
 
+#include <opm/models/utils/memoryusage.hh>
+
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/istl/bcrsmatrix.hh>
 #include <dune/istl/scalarproducts.hh>
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <set>
 #include <map>
 #include <iostream>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #if HAVE_MPI
 #include <mpi.h>
@@ -56,8 +62,10 @@ class GlobalIndices
 {
     GlobalIndices(const GlobalIndices& ) = delete;
 
-    using GlobalToDomesticMap = std::map<Index, Index>;
-    using DomesticToGlobalMap = std::map<Index, Index>;
+    // the domestic indices are contiguous, so they can be mapped using a flat array.
+    // (entries which are not yet known are set to -1.) the global indices are sparse.
+    using GlobalToDomesticMap = std::unordered_map<Index, Index>;
+    using DomesticToGlobalMap = std::vector<Index>;
 
 public:
     GlobalIndices(const ForeignOverlap& foreignOverlap)
@@ -87,9 +95,11 @@ public:
      */
     Index domesticToGlobal(Index domesticIdx) const
     {
-        assert(domesticToGlobal_.find(domesticIdx) != domesticToGlobal_.end());
+        assert(0 <= domesticIdx);
+        assert(static_cast<size_t>(domesticIdx) < domesticToGlobal_.size());
+        assert(domesticToGlobal_[static_cast<size_t>(domesticIdx)] >= 0);
 
-        return domesticToGlobal_.find(domesticIdx)->second;
+        return domesticToGlobal_[static_cast<size_t>(domesticIdx)];
     }
 
     /*!
@@ -126,11 +136,14 @@ public:
      */
     void addIndex(Index domesticIdx, Index globalIdx)
     {
-        domesticToGlobal_[domesticIdx] = globalIdx;
-        globalToDomestic_[globalIdx] = domesticIdx;
-        numDomestic_ = domesticToGlobal_.size();
+        assert(domesticIdx >= 0);
+        size_t idx = static_cast<size_t>(domesticIdx);
+        if (idx >= domesticToGlobal_.size())
+            domesticToGlobal_.resize(idx + 1, -1);
 
-        assert(domesticToGlobal_.size() == globalToDomestic_.size());
+        domesticToGlobal_[idx] = globalIdx;
+        globalToDomestic_[globalIdx] = domesticIdx;
+        numDomestic_ = globalToDomestic_.size();
     }
 
     /*!
@@ -198,6 +211,12 @@ public:
         std::cout << "\n" << std::flush;
     }
 
+    /*!
+     * \brief Returns the number of bytes occupied by the index mappings.
+     */
+    std::size_t memoryUsage() const
+    { return memoryUsageOf(globalToDomestic_) + memoryUsageOf(domesticToGlobal_); }
+
 protected:
     // retrieve the offset for the indices where we are master in the
     // global index list
@@ -44,14 +44,18 @@
 #ifndef EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
 #define EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
 
+#include <opm/models/utils/memoryusage.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/simulators/linalg/linalgproperties.hh>
+#include <opm/simulators/linalg/scalarilu0preconditioner.hh>
 #include <opm/simulators/linalg/ilufirstelement.hh> //definitions needed in next header
 #include <dune/istl/preconditioners.hh>
 
 #include <dune/common/version.hh>
 
+#include <type_traits>
+
 namespace Opm {
 namespace Linear {
 #define EWOMS_WRAP_ISTL_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE)               \
@@ -91,10 +95,13 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
-        SequentialPreconditioner *seqPreCond_;                                  \
+        SequentialPreconditioner *seqPreCond_{nullptr};                         \
     };
 
 // the same as the EWOMS_WRAP_ISTL_PRECONDITIONER macro, but without
@@ -133,10 +140,13 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
-        SequentialPreconditioner *seqPreCond_;                                  \
+        SequentialPreconditioner *seqPreCond_{nullptr};                         \
     };
 
 EWOMS_WRAP_ISTL_PRECONDITIONER(Jacobi, Dune::SeqJac)
@@ -146,7 +156,9 @@ EWOMS_WRAP_ISTL_PRECONDITIONER(SOR, Dune::SeqSOR)
 EWOMS_WRAP_ISTL_PRECONDITIONER(SSOR, Dune::SeqSSOR)
 
 // we need a custom preconditioner wrapper for ILU because the Dune::SeqILU class uses a
-// non-standard extra template parameter to specify its order.
+// non-standard extra template parameter to specify its order. for systems with a single
+// equation and an order of 0, a specialized ILU(0) which works on plain scalars is used
+// instead.
 template <class TypeTag>
 class PreconditionerWrapperILU
 {
@@ -155,9 +167,13 @@ class PreconditionerWrapperILU
     using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
 
     static constexpr int order = getPropValue<TypeTag, Properties::PreconditionerOrder>();
+    static constexpr bool isScalar = OverlappingVector::block_type::dimension == 1 && order == 0;
 
 public:
-    using SequentialPreconditioner = Dune::SeqILU<OverlappingMatrix, OverlappingVector, OverlappingVector, order>;
+    using SequentialPreconditioner =
+        std::conditional_t<isScalar,
+                           ScalarIlu0Preconditioner<OverlappingMatrix, OverlappingVector>,
+                           Dune::SeqILU<OverlappingMatrix, OverlappingVector, OverlappingVector, order> >;
 
     PreconditionerWrapperILU()
     {}
@@ -179,11 +195,40 @@ public:
     SequentialPreconditioner& get()
     { return *seqPreCond_; }
 
+    /*!
+     * \brief Add the memory footprint of the ILU factors for a given matrix.
+     *
+     * The factors are stored in a copy of the matrix, so this is exact for ILU(0). For
+     * higher orders, it is a lower bound because the fill-in is not considered.
+     */
+    void addMemoryUsage(MemoryUsage& usage, const OverlappingMatrix& matrix) const
+    { estimateMemoryUsage(usage, matrix.N(), matrix.nonzeroes()); }
+
+    /*!
+     * \brief Add the memory footprint of the ILU factors for a matrix with a given
+     *        number of rows and non-zero blocks.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage, std::size_t numRows, std::size_t numNonzeros) const
+    {
+        if constexpr (isScalar)
+            // values and column indices of the non-zeros plus the row starts, the
+            // positions and the inverses of the diagonal entries
+            usage.add("Preconditioner",
+                      numNonzeros*(sizeof(Scalar) + sizeof(unsigned))
+                      + numRows*(sizeof(Scalar) + 2*sizeof(unsigned)));
+        else
+            usage.add("Preconditioner",
+                      estimatedMemoryUsageOfMatrix<OverlappingMatrix>(numRows, numNonzeros));
+    }
+
     void cleanup()
-    { delete seqPreCond_; }
+    {
+        delete seqPreCond_;
+        seqPreCond_ = nullptr;
+    }
 
 private:
-    SequentialPreconditioner *seqPreCond_;
+    SequentialPreconditioner *seqPreCond_{nullptr};
 };
 
 #undef EWOMS_WRAP_ISTL_PRECONDITIONER
@@ -90,6 +90,14 @@ struct PreconditionerOrder { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PreconditionerRelaxation { using type = UndefinedProperty; };
 
+//! The index of the pressure within the equation blocks for the CPR preconditioner
+template<class TypeTag, class MyTypeTag>
+struct CprPressureIndex { using type = UndefinedProperty; };
+
+//! The coarsening target of the pressure AMG of the CPR preconditioner
+template<class TypeTag, class MyTypeTag>
+struct CprCoarsenTarget { using type = UndefinedProperty; };
+
 //! number of iterations between solver restarts for the GMRES solver
 template<class TypeTag, class MyTypeTag>
 struct GMResRestart { using type = UndefinedProperty; };
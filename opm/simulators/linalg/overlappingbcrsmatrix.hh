@@ -31,6 +31,7 @@
 #include <opm/simulators/linalg/globalindices.hh>
 #include <opm/simulators/linalg/blacklist.hh>
 #include <opm/models/parallel/mpibuffer.hh>
+#include <opm/models/utils/memoryusage.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 
@@ -58,7 +59,7 @@ public:
     using Overlap = Opm::Linear::DomesticOverlapFromBCRSMatrix;
 
 private:
-    using Entries = std::vector<std::set<Index> >;
+    using Entries = std::vector<std::vector<Index> >;
 
 public:
     using ColIterator = typename ParentType::ColIterator;
@@ -132,6 +133,27 @@ public:
     const Overlap& overlap() const
     { return *overlap_; }
 
+    /*!
+     * \brief Add the memory footprints of the matrix, of its MPI buffers and of the
+     *        overlap.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        usage.add("Overlapping matrix", memoryUsageOf(asParent()) + memoryUsageOf(entries_));
+        usage.add("Linear solver MPI buffers",
+                  memoryUsageOfMappedPointees(numRowsSendBuff_)
+                  + memoryUsageOfMappedPointees(rowSizesSendBuff_)
+                  + memoryUsageOfMappedPointees(rowIndicesSendBuff_)
+                  + memoryUsageOfMappedPointees(entryColIndicesSendBuff_)
+                  + memoryUsageOfMappedPointees(entryValuesSendBuff_)
+                  + memoryUsageOf(numRowsRecvBuff_)
+                  + memoryUsageOfMappedPointees(rowSizesRecvBuff_)
+                  + memoryUsageOfMappedPointees(rowIndicesRecvBuff_)
+                  + memoryUsageOfMappedPointees(entryColIndicesRecvBuff_)
+                  + memoryUsageOfMappedPointees(entryValuesRecvBuff_));
+        overlap_->addMemoryUsage(usage);
+    }
+
     /*!
      * \brief Assign and syncronize the overlapping matrix from a non-overlapping one.
      */
@@ -341,8 +363,15 @@ private:
         /////////
         // first, add all local matrix entries
         /////////
+        // each native row corresponds to a different domestic row, so the rows can be
+        // dealt with in parallel.
+        entries_.clear();
         entries_.resize(overlap_->numDomestic());
-        for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
+        size_t numNative = nativeMatrix.N();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (unsigned nativeRowIdx = 0; nativeRowIdx < numNative; ++nativeRowIdx) {
             int domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
             if (domesticRowIdx < 0)
                 continue;
@@ -362,7 +391,7 @@ private:
                 if (domesticColIdx < 0)
                     continue;
 
-                entries_[static_cast<unsigned>(domesticRowIdx)].insert(domesticColIdx);
+                entries_[static_cast<unsigned>(domesticRowIdx)].push_back(domesticColIdx);
             }
         }
 
@@ -406,43 +435,39 @@ private:
         // actually initialize the BCRS matrix structure
         /////////
 
-        // set the row sizes
+        // sort the column indices of each row and remove the duplicates as well as the
+        // entries for DOFs which the matrix of the local process does not know about
         size_t numDomestic = overlap_->numDomestic();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
-            unsigned numCols = 0;
-            const auto& colIndices = entries_[rowIdx];
-            auto colIdxIt = colIndices.begin();
-            const auto& colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
-
-                ++numCols;
-            }
-
-            this->setrowsize(rowIdx, numCols);
+            auto& colIndices = entries_[rowIdx];
+            std::sort(colIndices.begin(), colIndices.end());
+            colIndices.erase(std::unique(colIndices.begin(), colIndices.end()), colIndices.end());
+            colIndices.erase(colIndices.begin(),
+                             std::lower_bound(colIndices.begin(), colIndices.end(), 0));
         }
+
+        // set the row sizes
+        for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx)
+            this->setrowsize(rowIdx, entries_[rowIdx].size());
         this->endrowsizes();
 
-        // set the indices
+        // set the indices. in random build mode, the rows are independent of each
+        // other.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
             const auto& colIndices = entries_[rowIdx];
-
-            auto colIdxIt = colIndices.begin();
-            const auto& colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
-
-                this->addindex(rowIdx, static_cast<unsigned>(*colIdxIt));
-            }
+            this->setIndices(rowIdx, colIndices.begin(), colIndices.end());
         }
         this->endindices();
 
         // free the memory occupied by the array of the matrix entries
         entries_.clear();
+        entries_.shrink_to_fit();
     }
 
     // send the overlap indices to a peer
@@ -462,18 +487,17 @@ private:
         rowIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
         rowSizesSendBuff_[peerRank] = new MpiBuffer<unsigned>(numOverlapRows);
 
-        // compute the sets of the indices of the entries which need to be send to the peer
-        using ColumnIndexSet = std::set<int>;
-        using EntryTuples = std::map<int, ColumnIndexSet>;
-
-        EntryTuples entryIndices;
-        unsigned numEntries = 0; // <- total number of matrix entries to be send to the peer
+        // compute the global column indices of the entries which need to be send to the
+        // peer. the rows are independent of each other.
+        std::vector<std::vector<Index> > entryIndices(numOverlapRows);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (unsigned overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
             Index domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
             Index nativeRowIdx = overlap_->domesticToNative(domesticRowIdx);
-            Index globalRowIdx = overlap_->domesticToGlobal(domesticRowIdx);
 
-            ColumnIndexSet& colIndices = entryIndices[globalRowIdx];
+            auto& colIndices = entryIndices[overlapOffset];
 
             auto nativeColIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].begin();
             const auto& nativeColEndIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].end();
@@ -492,11 +516,16 @@ private:
                     // entry.
                     continue;
 
-                Index globalColIdx = overlap_->domesticToGlobal(domesticColIdx);
-                colIndices.insert(globalColIdx);
-                ++numEntries;
+                colIndices.push_back(overlap_->domesticToGlobal(domesticColIdx));
             }
-        };
+
+            std::sort(colIndices.begin(), colIndices.end());
+            colIndices.erase(std::unique(colIndices.begin(), colIndices.end()), colIndices.end());
+        }
+
+        unsigned numEntries = 0; // <- total number of matrix entries to be send to the peer
+        for (const auto& colIndices : entryIndices)
+            numEntries += static_cast<unsigned>(colIndices.size());
 
         // fill the send buffers
         entryColIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numEntries);
@@ -507,12 +536,10 @@ private:
 
             (*rowIndicesSendBuff_[peerRank])[overlapOffset] = globalRowIdx;
 
-            const ColumnIndexSet& colIndexSet = entryIndices[globalRowIdx];
+            const auto& colIndices = entryIndices[overlapOffset];
             auto* rssb = rowSizesSendBuff_[peerRank];
-            (*rssb)[overlapOffset] = static_cast<unsigned>(colIndexSet.size());
-            for (auto it = colIndexSet.begin(); it != colIndexSet.end(); ++it) {
-                int globalColIdx = *it;
-
+            (*rssb)[overlapOffset] = static_cast<unsigned>(colIndices.size());
+            for (Index globalColIdx : colIndices) {
                 (*entryColIndicesSendBuff_[peerRank])[static_cast<unsigned>(overlapEntryIdx)] = globalColIdx;
                 ++ overlapEntryIdx;
             }
@@ -571,7 +598,7 @@ private:
             Index domRowIdx = (*rowIndicesRecvBuff_[peerRank])[i];
             for (unsigned j = 0; j < (*rowSizesRecvBuff_[peerRank])[i]; ++j) {
                 Index domColIdx = (*entryColIndicesRecvBuff_[peerRank])[k];
-                entries_[static_cast<unsigned>(domRowIdx)].insert(domColIdx);
+                entries_[static_cast<unsigned>(domRowIdx)].push_back(domColIdx);
                 ++k;
             }
         }
@@ -30,11 +30,13 @@
 #include "overlaptypes.hh"
 
 #include <opm/models/parallel/mpibuffer.hh>
+#include <opm/models/utils/memoryusage.hh>
 #include <opm/material/common/Valgrind.hpp>
 
 #include <dune/istl/bvector.hh>
 #include <dune/common/fvector.hh>
 
+#include <cstddef>
 #include <memory>
 #include <map>
 #include <iostream>
@@ -101,6 +103,20 @@ public:
         return *this;
     }
 
+    /*!
+     * \brief Returns the number of bytes occupied by the MPI buffers of the vector.
+     *
+     * Note that copies of a vector share their buffers.
+     */
+    std::size_t bufferMemoryUsage() const
+    {
+        return memoryUsageOfMappedPointees(numIndicesSendBuff_)
+            + memoryUsageOfMappedPointees(indicesSendBuff_)
+            + memoryUsageOfMappedPointees(indicesRecvBuff_)
+            + memoryUsageOfMappedPointees(valuesSendBuff_)
+            + memoryUsageOfMappedPointees(valuesRecvBuff_);
+    }
+
     /*!
      * \brief Assign an overlapping block vector from a
      *        non-overlapping one, border entries are added.
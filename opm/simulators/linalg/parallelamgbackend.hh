@@ -138,7 +138,8 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
                                            OverlappingVector,
                                            AMG> ;
 
-    static_assert(std::is_same<SparseMatrixAdapter, IstlSparseMatrixAdapter<MatrixBlock> >::value,
+    static_assert(std::is_same<SparseMatrixAdapter,
+                               IstlSparseMatrixAdapter<MatrixBlock, typename SparseMatrixAdapter::IstlMatrix::allocator_type> >::value,
                   "The ParallelAmgBackend linear solver backend requires the IstlSparseMatrixAdapter");
 
 public:
@@ -193,13 +194,12 @@ protected:
         const auto& gridView = this->simulator_.gridView();
         using CCC = CombinedCriterion<OverlappingVector, decltype(gridView.comm())>;
 
-        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
         Scalar linearSolverAbsTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverAbsTolerance);
         if(linearSolverAbsTolerance < 0.0)
             linearSolverAbsTolerance = this->simulator_.model().newtonMethod().tolerance()/100.0;
 
         convCrit_.reset(new CCC(gridView.comm(),
-                                /*residualReductionTolerance=*/linearSolverTolerance,
+                                /*residualReductionTolerance=*/this->tolerance_,
                                 /*absoluteResidualTolerance=*/linearSolverAbsTolerance,
                                 EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverMaxError)));
 
@@ -305,6 +305,9 @@ protected:
     std::shared_ptr<FineOperator> fineOperator_;
     std::shared_ptr<AMG> amg_;
 
+    // the preconditioner of the last solve, see ParallelBaseBackend::solve()
+    std::shared_ptr<AMG> preconditioner_;
+
 #if HAVE_MPI
     std::shared_ptr<OwnerOverlapCopyCommunication> istlComm_;
 #endif
@@ -37,8 +37,13 @@
 #include <opm/simulators/linalg/overlappingoperator.hh>
 #include <opm/simulators/linalg/parallelbasebackend.hh>
 #include <opm/simulators/linalg/istlpreconditionerwrappers.hh>
+#include <opm/simulators/linalg/cprpreconditioner.hh>
 
+#include <opm/models/parallel/firsttouchallocator.hh>
 #include <opm/models/utils/genericguard.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/profiler.hh>
+#include <opm/models/utils/timer.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/simulators/linalg/matrixblock.hh>
@@ -68,9 +73,12 @@ private:
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     enum { numEq = getPropValue<TypeTag, Properties::NumEq>() };
     using Block = Opm::MatrixBlock<Scalar, numEq, numEq>;
+    using Allocator =
+        OptionalFirstTouchAllocator<Block,
+                                    getPropValue<TypeTag, Properties::EnableFirstTouchAllocation>()>;
 
 public:
-    using type = typename Opm::Linear::IstlSparseMatrixAdapter<Block>;
+    using type = typename Opm::Linear::IstlSparseMatrixAdapter<Block, Allocator>;
 };
 
 } // namespace Opm::Properties
@@ -103,6 +111,8 @@ namespace Linear {
  *            that it is computationally cheaper because it does not
  *            need to consider things which are only required for
  *            higher orders
+ * - \c CPR: A two-stage constrained pressure residual preconditioner for systems
+ *           with a pressure equation (see cprpreconditioner.hh)
  */
 template <class TypeTag>
 class ParallelBaseBackend
@@ -139,6 +149,8 @@ public:
         , gridSequenceNumber_( -1 )
         , lastIterations_( -1 )
     {
+        tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
@@ -181,6 +193,7 @@ public:
      */
     void prepare(const SparseMatrixAdapter& M, const Vector& )
     {
+        EWOMS_TIMEBLOCK(linearSolverPrepare);
         // if grid has changed the sequence number has changed too
         int curSeqNum = simulator_.vanguard().gridSequenceNumber();
         if (gridSequenceNumber_ == curSeqNum && overlappingMatrix_)
@@ -191,11 +204,15 @@ public:
         asImp_().cleanup_();
         gridSequenceNumber_ = curSeqNum;
 
+        Opm::Timer setupTimer;
+        setupTimer.start();
+
         BorderListCreator borderListCreator(simulator_.gridView(),
                                             simulator_.model().dofMapper());
 
         // create the overlapping Jacobian matrix
         unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
+        matrixChanged_ = true;
         overlappingMatrix_ = new OverlappingMatrix(M.istlMatrix(),
                                                    borderListCreator.borderList(),
                                                    borderListCreator.blackList(),
@@ -207,6 +224,15 @@ public:
         overlappingx_ = new OverlappingVector(*overlappingb_);
 
         // writeOverlapToVTK_();
+
+        setupTimer.stop();
+        setupTimer_ += setupTimer;
+        const auto& comm = simulator_.gridView().comm();
+        double maxSetupTime = comm.max(setupTimer.realTimeElapsed());
+        if (EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity) > 0 && comm.rank() == 0)
+            std::cout << "Setting up the overlap of the linear solver took " << maxSetupTime
+                      << " seconds (" << setupTimer_.realTimeElapsed() << " seconds in total)\n"
+                      << std::flush;
     }
 
     /*!
@@ -242,6 +268,7 @@ public:
     {
         overlappingMatrix_->assignFromNative(M.istlMatrix());
         overlappingMatrix_->syncAdd();
+        matrixChanged_ = true;
     }
 
     /*!
@@ -251,12 +278,21 @@ public:
      */
     bool solve(Vector& x)
     {
+        EWOMS_TIMEBLOCK(linearSolve);
         (*overlappingx_) = 0.0;
 
-        auto parPreCond = asImp_().preparePreconditioner_();
-        auto precondCleanupFn = [this]() -> void
-                                { this->asImp_().cleanupPreconditioner_(); };
-        auto precondCleanupGuard = Opm::make_guard(precondCleanupFn);
+        // the preconditioner only needs to be rebuilt if the matrix was changed since
+        // the last solve. this allows to reuse it if the same system is solved for
+        // multiple right hand sides.
+        auto& parPreCond = asImp_().preconditioner_;
+        if (matrixChanged_ || !parPreCond) {
+            if (parPreCond) {
+                parPreCond.reset();
+                asImp_().cleanupPreconditioner_();
+            }
+            parPreCond = asImp_().preparePreconditioner_();
+            matrixChanged_ = false;
+        }
         // create the parallel scalar product and the parallel operator
         ParallelScalarProduct parScalarProduct(overlappingMatrix_->overlap());
         ParallelOperator parOperator(*overlappingMatrix_);
@@ -283,12 +319,79 @@ public:
         return result.first;
     }
 
+    /*!
+     * \brief Set the reduction of the residual which the linear solver needs to
+     *        achieve.
+     *
+     * By default, this is the value of the LinearSolverTolerance parameter. The Newton
+     * method may adapt it for each iteration if it does not need to solve the
+     * linearized system accurately.
+     */
+    void setTolerance(Scalar tolerance)
+    { tolerance_ = tolerance; }
+
+    /*!
+     * \brief Returns the reduction of the residual which the linear solver needs to
+     *        achieve.
+     */
+    Scalar tolerance() const
+    { return tolerance_; }
+
     /*!
      * \brief Return number of iterations used during last solve.
      */
     size_t iterations () const
     { return lastIterations_; }
 
+    /*!
+     * \brief Returns the timer which accumulates the time spent to set up the overlap
+     *        of the linear solver.
+     *
+     * The overlap needs to be set up for the first solve and every time the grid has
+     * changed.
+     */
+    const Opm::Timer& setupTimer() const
+    { return setupTimer_; }
+
+    /*!
+     * \brief Add the memory footprints of the overlapping linear system, of its MPI
+     *        buffers and of the preconditioner.
+     *
+     * Nothing is added if the linear system has not been prepared yet.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        if (!overlappingMatrix_)
+            return;
+
+        using BlockVector = Dune::BlockVector<typename OverlappingVector::block_type>;
+        overlappingMatrix_->addMemoryUsage(usage);
+        usage.add("Overlapping vectors",
+                  memoryUsageOf(static_cast<const BlockVector&>(*overlappingb_))
+                  + memoryUsageOf(static_cast<const BlockVector&>(*overlappingx_)));
+        // the solution vector is a copy of the right hand side and shares its buffers
+        usage.add("Linear solver MPI buffers", overlappingb_->bufferMemoryUsage());
+        addPreconditionerMemoryUsage_(precWrapper_, usage, 0);
+    }
+
+    /*!
+     * \brief Estimate the memory footprints of the overlapping linear system and of the
+     *        preconditioner without allocating them.
+     *
+     * \param numRows The number of block rows of the Jacobian matrix
+     * \param numNonzeros The number of non-zero blocks of the Jacobian matrix
+     *
+     * The overlap with the peer processes and the MPI buffers are not considered, i.e.,
+     * the estimate is exact only for sequential runs.
+     */
+    void estimateMemoryUsage(MemoryUsage& usage, std::size_t numRows, std::size_t numNonzeros) const
+    {
+        usage.add("Overlapping matrix",
+                  estimatedMemoryUsageOfMatrix<OverlappingMatrix>(numRows, numNonzeros));
+        usage.add("Overlapping vectors", 2*numRows*sizeof(typename OverlappingVector::block_type));
+        Opm::estimateMemoryUsage(precWrapper_, usage, numRows, numNonzeros);
+    }
+
 protected:
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -296,8 +399,21 @@ protected:
     const Implementation& asImp_() const
     { return *static_cast<const Implementation *>(this); }
 
+    template <class Wrapper>
+    auto addPreconditionerMemoryUsage_(const Wrapper& wrapper, MemoryUsage& usage, int) const
+        -> decltype(wrapper.addMemoryUsage(usage, *overlappingMatrix_), void())
+    { wrapper.addMemoryUsage(usage, *overlappingMatrix_); }
+
+    template <class Wrapper>
+    void addPreconditionerMemoryUsage_(const Wrapper&, MemoryUsage&, long) const
+    {}
+
     void cleanup_()
     {
+        // the preconditioner may refer to the overlapping matrix
+        preconditioner_.reset();
+        precWrapper_.cleanup();
+
         // create the overlapping Jacobian matrix and vectors
         delete overlappingMatrix_;
         delete overlappingb_;
@@ -377,11 +493,19 @@ protected:
     const Simulator& simulator_;
     int gridSequenceNumber_;
     size_t lastIterations_;
+    Scalar tolerance_;
+    Opm::Timer setupTimer_;
 
     OverlappingMatrix *overlappingMatrix_;
     OverlappingVector *overlappingb_;
     OverlappingVector *overlappingx_;
 
+    // the parallel preconditioner of the last solve. implementations which prepare a
+    // different kind of preconditioner declare their own preconditioner_ attribute
+    // of the type returned by their preparePreconditioner_() method.
+    std::shared_ptr<ParallelPreconditioner> preconditioner_;
+    bool matrixChanged_{true};
+
     PreconditionerWrapper precWrapper_;
 };
 }} // namespace Linear, Opm
@@ -404,6 +528,14 @@ struct PreconditionerRelaxation<TypeTag, TTag::ParallelBaseLinearSolver>
 template<class TypeTag>
 struct PreconditionerOrder<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 0; };
 
+//! the CPR preconditioner assumes that the pressure is the first primary variable by
+//! default
+template<class TypeTag>
+struct CprPressureIndex<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 0; };
+
+template<class TypeTag>
+struct CprCoarsenTarget<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 1000; };
+
 //! by default use the same kind of floating point values for the linearization and for
 //! the linear solve
 template<class TypeTag>
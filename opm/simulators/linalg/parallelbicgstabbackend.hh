@@ -109,7 +109,8 @@ class ParallelBiCGStabSolverBackend : public ParallelBaseBackend<TypeTag>
                                            OverlappingVector,
                                            ParallelPreconditioner>;
 
-    static_assert(std::is_same<SparseMatrixAdapter, IstlSparseMatrixAdapter<MatrixBlock> >::value,
+    static_assert(std::is_same<SparseMatrixAdapter,
+                               IstlSparseMatrixAdapter<MatrixBlock, typename SparseMatrixAdapter::IstlMatrix::allocator_type> >::value,
                   "The ParallelIstlSolverBackend linear solver backend requires the IstlSparseMatrixAdapter");
 
 public:
@@ -136,13 +137,12 @@ protected:
         const auto& gridView = this->simulator_.gridView();
         using CCC = CombinedCriterion<OverlappingVector, decltype(gridView.comm())>;
 
-        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
         Scalar linearSolverAbsTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverAbsTolerance);
         if(linearSolverAbsTolerance < 0.0)
             linearSolverAbsTolerance = this->simulator_.model().newtonMethod().tolerance() / 100.0;
 
         convCrit_.reset(new CCC(gridView.comm(),
-                                /*residualReductionTolerance=*/linearSolverTolerance,
+                                /*residualReductionTolerance=*/this->tolerance_,
                                 /*absoluteResidualTolerance=*/linearSolverAbsTolerance,
                                 EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverMaxError)));
 
@@ -76,6 +76,8 @@ namespace Opm::Linear {
  * - \c SOR: A successive overrelaxation (SOR) preconditioner
  * - \c ILUn: An ILU(n) preconditioner
  * - \c ILU0: A specialized (and optimized) ILU(0) preconditioner
+ * - \c CPR: A two-stage constrained pressure residual preconditioner (see
+ *           cprpreconditioner.hh)
  */
 template <class TypeTag>
 class ParallelIstlSolverBackend : public ParallelBaseBackend<TypeTag>
@@ -95,7 +97,8 @@ class ParallelIstlSolverBackend : public ParallelBaseBackend<TypeTag>
     using MatrixBlock = typename SparseMatrixAdapter::MatrixBlock;
     using RawLinearSolver = typename LinearSolverWrapper::RawSolver;
 
-    static_assert(std::is_same<SparseMatrixAdapter, IstlSparseMatrixAdapter<MatrixBlock> >::value,
+    static_assert(std::is_same<SparseMatrixAdapter,
+                               IstlSparseMatrixAdapter<MatrixBlock, typename SparseMatrixAdapter::IstlMatrix::allocator_type> >::value,
                   "The ParallelIstlSolverBackend linear solver backend requires the IstlSparseMatrixAdapter");
 
 public:
@@ -122,7 +125,8 @@ protected:
     {
         return solverWrapper_.get(parOperator,
                                   parScalarProduct,
-                                  parPreCond);
+                                  parPreCond,
+                                  this->tolerance_);
     }
 
     void cleanupSolver_()
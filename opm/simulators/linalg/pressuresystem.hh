@@ -0,0 +1,180 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::PressureSystem
+ */
+#ifndef EWOMS_PRESSURE_SYSTEM_HH
+#define EWOMS_PRESSURE_SYSTEM_HH
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief Extracts a scalar system for the pressure from a block matrix.
+ *
+ * For each row, the equations of the block system are combined using quasi-IMPES
+ * weights, i.e., the weights w for which the combination w^T D of the rows of the
+ * diagonal block D only depends on the pressure. The entries of the pressure matrix
+ * are the resulting combinations of the pressure derivatives of the blocks of the row.
+ *
+ * The sparsity pattern of the pressure matrix is the one of the block matrix. It is
+ * only re-created if the latter changes.
+ */
+template <class Scalar, int numEq>
+class PressureSystem
+{
+public:
+    using BlockVector = Dune::FieldVector<Scalar, numEq>;
+    using Matrix = Dune::BCRSMatrix<Dune::FieldMatrix<Scalar, 1, 1>>;
+    using Vector = Dune::BlockVector<Dune::FieldVector<Scalar, 1>>;
+
+    explicit PressureSystem(int pressureIdx)
+        : pressureIdx_(pressureIdx)
+    {}
+
+    /*!
+     * \brief Compute the weights and the pressure matrix for a block matrix.
+     */
+    template <class BlockMatrix>
+    void update(const BlockMatrix& blockMatrix)
+    {
+        computeWeights_(blockMatrix);
+        assembleMatrix_(blockMatrix);
+    }
+
+    /*!
+     * \brief Combine the equations of a block vector to the right hand side of the
+     *        pressure system.
+     */
+    template <class BlockVectorType>
+    void assembleRhs(const BlockVectorType& b, Vector& bp) const
+    {
+        bp.resize(b.size());
+        for (std::size_t rowIdx = 0; rowIdx < b.size(); ++rowIdx)
+            bp[rowIdx] = weights_[rowIdx]*b[rowIdx];
+    }
+
+    /*!
+     * \brief Returns the weights for the equations of a row.
+     */
+    const BlockVector& weights(std::size_t rowIdx) const
+    { return weights_[rowIdx]; }
+
+    /*!
+     * \brief Returns the index of the equation which has the largest weight in a row.
+     */
+    unsigned dominantEquation(std::size_t rowIdx) const
+    { return dominantEqIdx_[rowIdx]; }
+
+    /*!
+     * \brief Returns the index of the pressure within the blocks.
+     */
+    int pressureIdx() const
+    { return pressureIdx_; }
+
+    /*!
+     * \brief Returns the scalar matrix of the pressure system.
+     */
+    const Matrix& matrix() const
+    { return matrix_; }
+
+private:
+    template <class BlockMatrix>
+    void computeWeights_(const BlockMatrix& blockMatrix)
+    {
+        std::size_t numRows = blockMatrix.N();
+        weights_.resize(numRows);
+        dominantEqIdx_.resize(numRows);
+
+        BlockVector rhs(0.0);
+        rhs[pressureIdx_] = 1.0;
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            Dune::FieldMatrix<Scalar, numEq, numEq> diagT;
+            const auto& diag = blockMatrix[rowIdx][rowIdx];
+            for (unsigned i = 0; i < numEq; ++i)
+                for (unsigned j = 0; j < numEq; ++j)
+                    diagT[i][j] = diag[j][i];
+
+            BlockVector& w = weights_[rowIdx];
+            diagT.solve(w, rhs);
+
+            // normalize the weights and remember the equation with the largest one
+            unsigned maxEqIdx = 0;
+            for (unsigned eqIdx = 1; eqIdx < numEq; ++eqIdx)
+                if (std::abs(w[eqIdx]) > std::abs(w[maxEqIdx]))
+                    maxEqIdx = eqIdx;
+            w /= std::abs(w[maxEqIdx]);
+            dominantEqIdx_[rowIdx] = maxEqIdx;
+        }
+    }
+
+    template <class BlockMatrix>
+    void assembleMatrix_(const BlockMatrix& blockMatrix)
+    {
+        std::size_t numRows = blockMatrix.N();
+
+        // (re-)create the sparsity pattern if the one of the block matrix has changed
+        if (matrix_.N() != numRows || matrix_.nonzeroes() != blockMatrix.nonzeroes()) {
+            matrix_ = Matrix(numRows, numRows, blockMatrix.nonzeroes(), Matrix::row_wise);
+            for (auto rowIt = matrix_.createbegin(); rowIt != matrix_.createend(); ++rowIt) {
+                const auto& blockRow = blockMatrix[rowIt.index()];
+                for (auto colIt = blockRow.begin(); colIt != blockRow.end(); ++colIt)
+                    rowIt.insert(colIt.index());
+            }
+        }
+
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const BlockVector& w = weights_[rowIdx];
+
+            const auto& blockRow = blockMatrix[rowIdx];
+            auto pColIt = matrix_[rowIdx].begin();
+            for (auto colIt = blockRow.begin(); colIt != blockRow.end(); ++colIt, ++pColIt) {
+                Scalar value = 0.0;
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    value += w[eqIdx]*(*colIt)[eqIdx][pressureIdx_];
+                (*pColIt)[0][0] = value;
+            }
+        }
+    }
+
+    int pressureIdx_;
+
+    std::vector<BlockVector> weights_;
+    std::vector<unsigned> dominantEqIdx_;
+
+    Matrix matrix_;
+};
+
+}} // namespace Linear, Opm
+
+#endif
@@ -0,0 +1,227 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::ScalarIlu0Preconditioner
+ */
+#ifndef EWOMS_SCALAR_ILU0_PRECONDITIONER_HH
+#define EWOMS_SCALAR_ILU0_PRECONDITIONER_HH
+
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/istl/preconditioner.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief An ILU(0) preconditioner for matrices with 1x1 blocks.
+ *
+ * For systems with a single equation, the generic block ILU spends most of its time in
+ * the block operations (inversion, products of 1x1 matrices) and in navigating the rows
+ * of the BCRS matrix. This preconditioner copies the matrix into plain compressed row
+ * arrays of scalars once, factorizes it in place and applies the factors with tight
+ * scalar loops. The results are the same as the ones of Dune::SeqILU with order 0.
+ */
+template <class Matrix, class Vector>
+class ScalarIlu0Preconditioner : public Dune::Preconditioner<Vector, Vector>
+{
+    using Scalar = typename Vector::field_type;
+
+    static_assert(Vector::block_type::dimension == 1,
+                  "The scalar ILU(0) preconditioner only works for systems with a single equation");
+
+public:
+    using matrix_type = Matrix;
+    using domain_type = Vector;
+    using range_type = Vector;
+    using field_type = Scalar;
+
+    /*!
+     * \param matrix The matrix of the system
+     * \param relaxationFactor The factor by which the correction is scaled
+     */
+    ScalarIlu0Preconditioner(const Matrix& matrix, Scalar relaxationFactor)
+        : relaxationFactor_(relaxationFactor)
+    {
+        copyMatrix_(matrix);
+        factorize_();
+    }
+
+    //! \copydoc Dune::Preconditioner::category()
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+    /*!
+     * \copydoc Dune::Preconditioner::pre()
+     */
+    void pre(Vector&, Vector&) override
+    {}
+
+    /*!
+     * \copydoc Dune::Preconditioner::apply()
+     */
+    void apply(Vector& v, const Vector& d) override
+    {
+        const std::size_t numRows = diagIdx_.size();
+
+        // forward substitution with the unit lower triangular factor
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            Scalar sum = d[rowIdx][0];
+            for (unsigned pos = rowStart_[rowIdx]; pos < diagIdx_[rowIdx]; ++pos)
+                sum -= values_[pos]*v[colIdx_[pos]][0];
+            v[rowIdx][0] = sum;
+        }
+
+        // backward substitution with the upper triangular factor
+        for (std::size_t rowIdx = numRows; rowIdx-- > 0; ) {
+            Scalar sum = v[rowIdx][0];
+            for (unsigned pos = diagIdx_[rowIdx] + 1; pos < rowStart_[rowIdx + 1]; ++pos)
+                sum -= values_[pos]*v[colIdx_[pos]][0];
+            v[rowIdx][0] = sum*invDiag_[rowIdx];
+        }
+
+        // scale the correction by the relaxation factor
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            v[rowIdx][0] *= relaxationFactor_;
+    }
+
+    /*!
+     * \copydoc Dune::Preconditioner::post()
+     */
+    void post(Vector&) override
+    {}
+
+    /*!
+     * \brief Returns the number of bytes occupied by the factors.
+     */
+    std::size_t memoryUsage() const
+    {
+        return values_.capacity()*sizeof(Scalar)
+            + invDiag_.capacity()*sizeof(Scalar)
+            + colIdx_.capacity()*sizeof(unsigned)
+            + rowStart_.capacity()*sizeof(unsigned)
+            + diagIdx_.capacity()*sizeof(unsigned);
+    }
+
+private:
+    void copyMatrix_(const Matrix& matrix)
+    {
+        const std::size_t numRows = matrix.N();
+        rowStart_.resize(numRows + 1);
+        diagIdx_.resize(numRows);
+        invDiag_.resize(numRows);
+        colIdx_.resize(matrix.nonzeroes());
+        values_.resize(matrix.nonzeroes());
+
+        std::vector<unsigned> perm;
+        unsigned pos = 0;
+        for (auto rowIt = matrix.begin(); rowIt != matrix.end(); ++rowIt) {
+            const std::size_t rowIdx = rowIt.index();
+            const unsigned rowBegin = pos;
+            rowStart_[rowIdx] = rowBegin;
+            for (auto colIt = rowIt->begin(); colIt != rowIt->end(); ++colIt, ++pos) {
+                colIdx_[pos] = static_cast<unsigned>(colIt.index());
+                values_[pos] = (*colIt)[0][0];
+            }
+
+            // the factorization relies on the columns of each row being sorted
+            if (!std::is_sorted(colIdx_.begin() + rowBegin, colIdx_.begin() + pos)) {
+                perm.resize(pos - rowBegin);
+                std::iota(perm.begin(), perm.end(), rowBegin);
+                std::sort(perm.begin(), perm.end(),
+                          [this](unsigned a, unsigned b) { return colIdx_[a] < colIdx_[b]; });
+                std::vector<unsigned> sortedCols(perm.size());
+                std::vector<Scalar> sortedValues(perm.size());
+                for (std::size_t i = 0; i < perm.size(); ++i) {
+                    sortedCols[i] = colIdx_[perm[i]];
+                    sortedValues[i] = values_[perm[i]];
+                }
+                std::copy(sortedCols.begin(), sortedCols.end(), colIdx_.begin() + rowBegin);
+                std::copy(sortedValues.begin(), sortedValues.end(), values_.begin() + rowBegin);
+            }
+
+            const auto diagIt = std::lower_bound(colIdx_.begin() + rowBegin,
+                                                 colIdx_.begin() + pos,
+                                                 static_cast<unsigned>(rowIdx));
+            if (diagIt == colIdx_.begin() + pos || *diagIt != rowIdx)
+                throw NumericalProblem("Row "+std::to_string(rowIdx)+" of the matrix does not "
+                                       "contain a diagonal entry");
+            diagIdx_[rowIdx] = static_cast<unsigned>(diagIt - colIdx_.begin());
+        }
+        rowStart_[numRows] = pos;
+    }
+
+    // compute the incomplete LU factorization in place. the strictly lower part of each
+    // row holds the factor L (with an implicit unit diagonal), the rest holds U.
+    void factorize_()
+    {
+        const std::size_t numRows = diagIdx_.size();
+        for (std::size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const unsigned rowEnd = rowStart_[rowIdx + 1];
+            for (unsigned ikPos = rowStart_[rowIdx]; ikPos < diagIdx_[rowIdx]; ++ikPos) {
+                const unsigned k = colIdx_[ikPos];
+                values_[ikPos] *= invDiag_[k];
+                const Scalar lik = values_[ikPos];
+
+                // subtract l_ik times the upper part of row k from row i, but only for
+                // the entries of the sparsity pattern of row i
+                unsigned ijPos = ikPos + 1;
+                for (unsigned kjPos = diagIdx_[k] + 1; kjPos < rowStart_[k + 1]; ++kjPos) {
+                    const unsigned j = colIdx_[kjPos];
+                    while (ijPos < rowEnd && colIdx_[ijPos] < j)
+                        ++ijPos;
+                    if (ijPos == rowEnd)
+                        break;
+                    if (colIdx_[ijPos] == j)
+                        values_[ijPos] -= lik*values_[kjPos];
+                }
+            }
+
+            const Scalar diag = values_[diagIdx_[rowIdx]];
+            if (diag == 0.0)
+                throw NumericalProblem("Zero pivot in row "+std::to_string(rowIdx)
+                                       +" of the ILU(0) decomposition");
+            invDiag_[rowIdx] = 1.0/diag;
+        }
+    }
+
+    Scalar relaxationFactor_;
+
+    std::vector<unsigned> rowStart_;
+    std::vector<unsigned> colIdx_;
+    std::vector<unsigned> diagIdx_;
+    std::vector<Scalar> values_;
+    std::vector<Scalar> invDiag_;
+};
+
+} // namespace Linear
+} // namespace Opm
+
+#endif
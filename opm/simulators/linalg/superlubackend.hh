@@ -94,9 +94,26 @@ public:
     void setMatrix(const SparseMatrixAdapter& M)
     { M_ = &M; }
 
+    /*!
+     * \brief Set the reduction of the residual which the linear solver needs to
+     *        achieve.
+     *
+     * SuperLU is a direct solver, so this is a no-op.
+     */
+    void setTolerance(Scalar)
+    { }
+
     bool solve(Vector& x)
     { return SuperLUSolve_<Scalar, TypeTag, Matrix, Vector>::solve_(*M_, x, *b_); }
 
+    /*!
+     * \brief Return number of iterations used during last solve.
+     *
+     * For a direct solver, this is always one.
+     */
+    size_t iterations() const
+    { return 1; }
+
 private:
     const Matrix* M_;
     Vector* b_;
@@ -0,0 +1,328 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Microbenchmarks for the computational kernels of the black-oil model.
+ *
+ * This program sets up the reservoir problem using the black-oil model and the ECFV
+ * discretization, but instead of running a simulation it measures the time spent in the
+ * individual kernels which dominate the run time of a simulation: The update of the
+ * intensive quantities, the storage and flux terms, the linearization of the elements
+ * and of the whole domain as well as the linear operator, the preconditioner and the
+ * BiCGStab linear solver.
+ *
+ * The size of the grid is controlled by the --grid-global-refinements parameter and the
+ * number of threads by the --threads-per-process parameter. The results are written
+ * in the JSON format to the standard output or to the file specified by the
+ * --benchmark-output-file parameter.
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/utils/microbenchmark.hh>
+#include <opm/models/blackoil/blackoilmodel.hh>
+#include <opm/models/discretization/ecfv/ecfvdiscretization.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include "problems/reservoirproblem.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct ReservoirBlackOilBenchmark { using InheritsFrom = std::tuple<ReservoirBaseProblem, BlackOilModel>; };
+} // end namespace TTag
+
+// The number of timed repetitions of each kernel
+template<class TypeTag, class MyTypeTag>
+struct BenchmarkRepetitions { using type = UndefinedProperty; };
+
+// The file to which the results are written. if empty, they go to the standard output
+template<class TypeTag, class MyTypeTag>
+struct BenchmarkOutputFile { using type = UndefinedProperty; };
+
+template<class TypeTag>
+struct SpatialDiscretizationSplice<TypeTag, TTag::ReservoirBlackOilBenchmark> { using type = TTag::EcfvDiscretization; };
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::ReservoirBlackOilBenchmark> { using type = TTag::AutoDiffLocalLinearizer; };
+
+template<class TypeTag>
+struct BenchmarkRepetitions<TypeTag, TTag::ReservoirBlackOilBenchmark> { static constexpr unsigned value = 10; };
+
+template<class TypeTag>
+struct BenchmarkOutputFile<TypeTag, TTag::ReservoirBlackOilBenchmark> { static constexpr auto value = ""; };
+
+// the benchmarks do not write any output
+template<class TypeTag>
+struct EnableVtkOutput<TypeTag, TTag::ReservoirBlackOilBenchmark> { static constexpr bool value = false; };
+
+} // namespace Opm::Properties
+
+namespace {
+
+using TypeTag = Opm::Properties::TTag::ReservoirBlackOilBenchmark;
+
+using Scalar = Opm::GetPropType<TypeTag, Opm::Properties::Scalar>;
+using Evaluation = Opm::GetPropType<TypeTag, Opm::Properties::Evaluation>;
+using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+using GridView = Opm::GetPropType<TypeTag, Opm::Properties::GridView>;
+using ElementContext = Opm::GetPropType<TypeTag, Opm::Properties::ElementContext>;
+using RateVector = Opm::GetPropType<TypeTag, Opm::Properties::RateVector>;
+using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+using BorderListCreator = Opm::GetPropType<TypeTag, Opm::Properties::BorderListCreator>;
+using OverlappingMatrix = Opm::GetPropType<TypeTag, Opm::Properties::OverlappingMatrix>;
+using OverlappingVector = Opm::GetPropType<TypeTag, Opm::Properties::OverlappingVector>;
+using Overlap = Opm::GetPropType<TypeTag, Opm::Properties::Overlap>;
+using PreconditionerWrapper = Opm::GetPropType<TypeTag, Opm::Properties::PreconditionerWrapper>;
+using GlobalEqVector = Opm::GetPropType<TypeTag, Opm::Properties::GlobalEqVector>;
+using Element = typename GridView::template Codim<0>::Entity;
+
+using ParallelOperator = Opm::Linear::OverlappingOperator<OverlappingMatrix,
+                                                          OverlappingVector,
+                                                          OverlappingVector>;
+using ParallelPreconditioner =
+    Opm::Linear::OverlappingPreconditioner<typename PreconditionerWrapper::SequentialPreconditioner,
+                                           Overlap>;
+
+enum { numEq = Opm::getPropValue<TypeTag, Opm::Properties::NumEq>() };
+
+// Calls a kernel for all interior elements of the grid using a static schedule. The
+// kernel returns the time it spent on the actual work for an element, which allows
+// to exclude the preparation of the element context from the measurement. The result
+// is the time of the slowest thread.
+template <class Kernel>
+double forAllElements(std::vector<std::unique_ptr<ElementContext> >& elemCtx,
+                      const std::vector<Element>& elements,
+                      const Kernel& kernel)
+{
+    std::vector<double> threadTimes(ThreadManager::maxThreads(), 0.0);
+    const int numElements = static_cast<int>(elements.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+        unsigned threadId = ThreadManager::threadId();
+        threadTimes[threadId] += kernel(*elemCtx[threadId], elements[elemIdx], threadId);
+    }
+
+    return *std::max_element(threadTimes.begin(), threadTimes.end());
+}
+
+double secondsSince(std::chrono::steady_clock::time_point startTime)
+{
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    return duration.count();
+}
+
+void runBenchmarks(Simulator& simulator, Opm::MicroBenchmark& benchmark)
+{
+    auto& model = simulator.model();
+    const auto& gridView = simulator.gridView();
+
+    std::vector<Element> elements;
+    std::size_t numFaces = 0;
+    for (const auto& elem : Dune::elements(gridView, Dune::Partitions::interior))
+        elements.push_back(elem);
+
+    std::vector<std::unique_ptr<ElementContext> > elemCtx;
+    for (unsigned threadId = 0; threadId < ThreadManager::maxThreads(); ++threadId)
+        elemCtx.emplace_back(std::make_unique<ElementContext>(simulator));
+
+    // count the faces of the stencils
+    for (const auto& elem : elements) {
+        elemCtx[0]->updateStencil(elem);
+        numFaces += elemCtx[0]->numInteriorFaces(/*timeIdx=*/0);
+    }
+
+    benchmark.addMetadata("elements", elements.size());
+    benchmark.addMetadata("faces", numFaces);
+    benchmark.addMetadata("dofs", model.numGridDof());
+    benchmark.addMetadata("threads", ThreadManager::maxThreads());
+    benchmark.addMetadata("hardwareCounters", benchmark.haveHardwareCounters());
+
+    ////////////
+    // kernels of the discretization
+    ////////////
+    benchmark.run("intensiveQuantitiesUpdate", elements.size(), [&]() {
+        return forAllElements(elemCtx, elements,
+                              [&](ElementContext& ctx, const Element& elem, unsigned) {
+            ctx.updatePrimaryStencil(elem);
+            auto startTime = std::chrono::steady_clock::now();
+            for (unsigned dofIdx = 0; dofIdx < ctx.numPrimaryDof(/*timeIdx=*/0); ++dofIdx) {
+                unsigned globalIdx = ctx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                ctx.updateIntensiveQuantities(model.solution(/*timeIdx=*/0)[globalIdx],
+                                              dofIdx, /*timeIdx=*/0);
+            }
+            return secondsSince(startTime);
+        });
+    });
+
+    benchmark.run("computeStorage", elements.size(), [&]() {
+        return forAllElements(elemCtx, elements,
+                              [&](ElementContext& ctx, const Element& elem, unsigned threadId) {
+            ctx.updatePrimaryStencil(elem);
+            ctx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+            const auto& localResidual = model.localResidual(threadId);
+
+            Dune::FieldVector<Evaluation, numEq> storage;
+            auto startTime = std::chrono::steady_clock::now();
+            for (unsigned dofIdx = 0; dofIdx < ctx.numPrimaryDof(/*timeIdx=*/0); ++dofIdx)
+                localResidual.computeStorage(storage, ctx, dofIdx, /*timeIdx=*/0);
+            return secondsSince(startTime);
+        });
+    });
+
+    benchmark.run("computeFlux", numFaces, [&]() {
+        return forAllElements(elemCtx, elements,
+                              [&](ElementContext& ctx, const Element& elem, unsigned threadId) {
+            ctx.updateAll(elem);
+            const auto& localResidual = model.localResidual(threadId);
+
+            RateVector flux;
+            auto startTime = std::chrono::steady_clock::now();
+            for (unsigned scvfIdx = 0; scvfIdx < ctx.numInteriorFaces(/*timeIdx=*/0); ++scvfIdx)
+                localResidual.computeFlux(flux, ctx, scvfIdx, /*timeIdx=*/0);
+            return secondsSince(startTime);
+        });
+    });
+
+    benchmark.run("linearizeElements", elements.size(), [&]() {
+        forAllElements(elemCtx, elements,
+                       [&](ElementContext& ctx, const Element& elem, unsigned threadId) {
+            model.localLinearizer(threadId).linearize(ctx, elem);
+            return 0.0;
+        });
+    });
+
+    auto& linearizer = model.linearizer();
+    benchmark.run("linearizeDomain", elements.size(), [&]() {
+        linearizer.linearizeDomain();
+    });
+    linearizer.linearizeAuxiliaryEquations();
+    linearizer.finalize();
+
+    ////////////
+    // kernels of the linear solver
+    ////////////
+    const auto& jacobian = linearizer.jacobian();
+    const auto& residual = linearizer.residual();
+
+    BorderListCreator borderListCreator(gridView, model.dofMapper());
+    unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
+    OverlappingMatrix overlappingMatrix(jacobian.istlMatrix(),
+                                        borderListCreator.borderList(),
+                                        borderListCreator.blackList(),
+                                        overlapSize);
+    overlappingMatrix.assignFromNative(jacobian.istlMatrix());
+    overlappingMatrix.syncAdd();
+
+    OverlappingVector x(overlappingMatrix.overlap());
+    OverlappingVector y(x);
+    x.assignAddBorder(residual);
+
+    ParallelOperator parOperator(overlappingMatrix);
+    benchmark.run("overlappingOperatorApply", overlappingMatrix.N(), [&]() {
+        parOperator.apply(x, y);
+    });
+
+    PreconditionerWrapper precWrapper;
+    precWrapper.prepare(overlappingMatrix);
+    ParallelPreconditioner parPreCond(precWrapper.get(), overlappingMatrix.overlap());
+    benchmark.run("preconditionerApply", overlappingMatrix.N(), [&]() {
+        parPreCond.apply(y, x);
+    });
+    precWrapper.cleanup();
+
+    // the preconditioner is only set up by the first solve, the timed ones reuse it
+    auto& linearSolver = model.newtonMethod().linearSolver();
+    GlobalEqVector solutionUpdate(residual.size());
+    linearSolver.prepare(jacobian, residual);
+    linearSolver.setMatrix(jacobian);
+    benchmark.run("bicgstabSolve", residual.size(), [&]() {
+        linearSolver.setResidual(residual);
+        solutionUpdate = 0.0;
+        linearSolver.solve(solutionUpdate);
+    });
+    benchmark.addMetadata("linearSolverIterations", linearSolver.iterations());
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    try {
+        Opm::registerAllParameters_<TypeTag>(/*finalizeRegistration=*/false);
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, BenchmarkRepetitions,
+                             "The number of timed repetitions of each kernel");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, BenchmarkOutputFile,
+                             "The file to which the results are written in the JSON format. "
+                             "If empty, the standard output is used.");
+        EWOMS_END_PARAM_REGISTRATION(TypeTag);
+
+        int paramStatus = Opm::setupParameters_<TypeTag>(argc,
+                                                         const_cast<const char**>(argv),
+                                                         /*registerParams=*/false);
+        if (paramStatus == 1)
+            return 1;
+        if (paramStatus == 2)
+            return 0;
+
+        ThreadManager::init();
+        const auto& mpiHelper = Dune::MPIHelper::instance(argc, argv);
+
+        Simulator simulator(/*verbose=*/false);
+        simulator.setTimeStepSize(EWOMS_GET_PARAM(TypeTag, Scalar, InitialTimeStepSize));
+        simulator.model().applyInitialSolution();
+
+        Opm::MicroBenchmark benchmark(EWOMS_GET_PARAM(TypeTag, unsigned, BenchmarkRepetitions));
+        benchmark.addMetadata("processes", mpiHelper.size());
+        runBenchmarks(simulator, benchmark);
+
+        if (mpiHelper.rank() == 0) {
+            std::string outputFile = EWOMS_GET_PARAM(TypeTag, std::string, BenchmarkOutputFile);
+            if (outputFile.empty())
+                benchmark.writeJson(std::cout);
+            else {
+                std::ofstream os(outputFile);
+                benchmark.writeJson(os);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Compares the batched NCP flash with the per-cell one.
+ *
+ * The total molarities of water and nitrogen are computed for a large number of
+ * two-phase cells with different saturations, pressures and temperatures. Their
+ * flashes are then solved cell by cell by Opm::NcpFlash and in batches by
+ * Opm::BatchedNcpFlash, both starting at the default initial guess. The results must
+ * agree, and the number of cells per second is printed for both solvers.
+ */
+#include "config.h"
+
+#include <opm/models/flash/batchedncpflash.hh>
+#include <opm/models/utils/timer.hh>
+
+#include <opm/material/constraintsolvers/NcpFlash.hpp>
+#include <opm/material/constraintsolvers/ComputeFromReferencePhase.hpp>
+#include <opm/material/fluidmatrixinteractions/RegularizedBrooksCorey.hpp>
+#include <opm/material/fluidmatrixinteractions/EffToAbsLaw.hpp>
+#include <opm/material/fluidmatrixinteractions/MaterialTraits.hpp>
+#include <opm/material/fluidsystems/H2ON2FluidSystem.hpp>
+#include <opm/material/fluidstates/CompositionalFluidState.hpp>
+
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using Scalar = double;
+using FluidSystem = Opm::H2ON2FluidSystem<Scalar>;
+using Traits = Opm::TwoPhaseMaterialTraits<Scalar,
+                                           /*wettingPhaseIdx=*/FluidSystem::liquidPhaseIdx,
+                                           /*nonWettingPhaseIdx=*/FluidSystem::gasPhaseIdx>;
+using MaterialLaw = Opm::EffToAbsLaw<Opm::RegularizedBrooksCorey<Traits> >;
+using MaterialLawParams = typename MaterialLaw::Params;
+using FluidState = Opm::CompositionalFluidState<Scalar, FluidSystem, /*enableEnergy=*/false>;
+
+static constexpr unsigned numPhases = FluidSystem::numPhases;
+static constexpr unsigned numComponents = FluidSystem::numComponents;
+static constexpr unsigned batchSize = 16;
+
+using NcpFlash = Opm::NcpFlash<Scalar, FluidSystem>;
+using BatchedFlash = Opm::BatchedNcpFlash<Scalar, FluidSystem, batchSize>;
+using ComponentVector = Dune::FieldVector<Scalar, numComponents>;
+
+// compute the total molarities of a cell in equilibrium which is given by its liquid
+// saturation, its gas pressure and its temperature
+ComponentVector totalMolarities(Scalar Sl, Scalar pg, Scalar T)
+{
+    FluidState fs;
+    fs.setTemperature(T);
+    fs.setSaturation(FluidSystem::liquidPhaseIdx, Sl);
+    fs.setSaturation(FluidSystem::gasPhaseIdx, 1.0 - Sl);
+    fs.setPressure(FluidSystem::liquidPhaseIdx, pg);
+    fs.setPressure(FluidSystem::gasPhaseIdx, pg);
+
+    Scalar xgH2O = 0.01;
+    fs.setMoleFraction(FluidSystem::gasPhaseIdx, FluidSystem::H2OIdx, xgH2O);
+    fs.setMoleFraction(FluidSystem::gasPhaseIdx, FluidSystem::N2Idx, 1.0 - xgH2O);
+
+    using CFRP = Opm::ComputeFromReferencePhase<Scalar, FluidSystem>;
+    typename FluidSystem::template ParameterCache<Scalar> paramCache;
+    CFRP::solve(fs, paramCache, FluidSystem::gasPhaseIdx,
+                /*setViscosity=*/false, /*setEnthalpy=*/false);
+
+    ComponentVector cTotal(0.0);
+    for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            cTotal[compIdx] += fs.saturation(phaseIdx)*fs.molarity(phaseIdx, compIdx);
+    return cTotal;
+}
+
+Scalar maxRelativeDifference(const FluidState& fs1, const FluidState& fs2)
+{
+    auto relDiff = [](Scalar a, Scalar b)
+    { return std::abs(a - b)/std::max<Scalar>(1.0, std::max(std::abs(a), std::abs(b))); };
+
+    Scalar result = 0.0;
+    for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+        // the pressures are compared in bar
+        result = std::max(result, relDiff(fs1.pressure(phaseIdx)/1e5, fs2.pressure(phaseIdx)/1e5));
+        result = std::max(result, relDiff(fs1.saturation(phaseIdx), fs2.saturation(phaseIdx)));
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            result = std::max(result, relDiff(fs1.moleFraction(phaseIdx, compIdx),
+                                              fs2.moleFraction(phaseIdx, compIdx)));
+    }
+    return result;
+}
+
+int main()
+{
+    FluidSystem::init();
+
+    MaterialLawParams materialParams;
+    materialParams.setResidualSaturation(FluidSystem::liquidPhaseIdx, 0.2);
+    materialParams.setResidualSaturation(FluidSystem::gasPhaseIdx, 0.0);
+    materialParams.setEntryPressure(1e4);
+    materialParams.setLambda(2.0);
+    materialParams.finalize();
+
+    const unsigned numCells = 20000;
+    std::vector<ComponentVector> cTotal(numCells);
+    std::vector<FluidState> initialFluidStates(numCells);
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        Scalar Sl = 0.3 + 0.6*(0.5 + 0.5*std::sin(0.37*cellIdx));
+        Scalar pg = 1e5*(1.0 + 4.0*(0.5 + 0.5*std::cos(0.11*cellIdx)));
+        Scalar T = 283.15 + 40.0*(0.5 + 0.5*std::sin(0.07*cellIdx));
+        cTotal[cellIdx] = totalMolarities(Sl, pg, T);
+
+        initialFluidStates[cellIdx].setTemperature(T);
+        NcpFlash::guessInitial(initialFluidStates[cellIdx], cTotal[cellIdx]);
+    }
+
+    // solve the flashes cell by cell
+    std::vector<FluidState> referenceFluidStates(initialFluidStates);
+    std::vector<bool> referenceConverged(numCells, true);
+    Opm::Timer perCellTimer;
+    perCellTimer.start();
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        typename FluidSystem::template ParameterCache<Scalar> paramCache;
+        try {
+            NcpFlash::solve<MaterialLaw>(referenceFluidStates[cellIdx],
+                                         materialParams,
+                                         paramCache,
+                                         cTotal[cellIdx]);
+        }
+        catch (const std::exception&) {
+            referenceConverged[cellIdx] = false;
+        }
+    }
+    perCellTimer.stop();
+
+    // solve the flashes in batches
+    std::vector<FluidState> batchedFluidStates(initialFluidStates);
+    std::vector<bool> batchedConverged(numCells, false);
+    std::array<const MaterialLawParams*, batchSize> laneParams;
+    laneParams.fill(&materialParams);
+    Opm::Timer batchedTimer;
+    batchedTimer.start();
+    for (unsigned firstCellIdx = 0; firstCellIdx < numCells; firstCellIdx += batchSize) {
+        unsigned numLanes = std::min(batchSize, numCells - firstCellIdx);
+        std::array<FluidState, batchSize> laneFluidStates;
+        std::array<ComponentVector, batchSize> laneCTotal;
+        for (unsigned laneIdx = 0; laneIdx < numLanes; ++laneIdx) {
+            laneFluidStates[laneIdx] = batchedFluidStates[firstCellIdx + laneIdx];
+            laneCTotal[laneIdx] = cTotal[firstCellIdx + laneIdx];
+        }
+
+        auto converged = BatchedFlash::solve<MaterialLaw>(laneFluidStates,
+                                                          laneParams,
+                                                          laneCTotal,
+                                                          numLanes);
+
+        for (unsigned laneIdx = 0; laneIdx < numLanes; ++laneIdx) {
+            batchedFluidStates[firstCellIdx + laneIdx] = laneFluidStates[laneIdx];
+            batchedConverged[firstCellIdx + laneIdx] = converged[laneIdx];
+        }
+    }
+    batchedTimer.stop();
+
+    bool success = true;
+    unsigned numConverged = 0;
+    Scalar maxDifference = 0.0;
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        if (!referenceConverged[cellIdx])
+            continue;
+
+        ++numConverged;
+        if (!batchedConverged[cellIdx]) {
+            std::cerr << "The batched flash did not converge for cell " << cellIdx << "\n";
+            success = false;
+            continue;
+        }
+
+        maxDifference = std::max(maxDifference,
+                                 maxRelativeDifference(referenceFluidStates[cellIdx],
+                                                       batchedFluidStates[cellIdx]));
+    }
+
+    std::cout << std::setw(12) << "solver"
+              << std::setw(14) << "time [s]"
+              << std::setw(14) << "cells/s" << "\n"
+              << std::setw(12) << "per-cell"
+              << std::setw(14) << perCellTimer.realTimeElapsed()
+              << std::setw(14) << numCells/perCellTimer.realTimeElapsed() << "\n"
+              << std::setw(12) << "batched"
+              << std::setw(14) << batchedTimer.realTimeElapsed()
+              << std::setw(14) << numCells/batchedTimer.realTimeElapsed() << "\n"
+              << numConverged << " of " << numCells << " flashes converged, "
+              << "maximum relative difference: " << maxDifference << "\n";
+
+    if (numConverged == 0) {
+        std::cerr << "None of the per-cell flashes converged\n";
+        success = false;
+    }
+
+    // both solvers stop once the update falls below the default tolerance, so their
+    // results may differ by about this much
+    if (maxDifference > 1e-5) {
+        std::cerr << "The results of the batched and the per-cell flash differ by "
+                  << maxDifference << "\n";
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Compares the finite difference linearizer which reuses the volume terms of the
+ *        degrees of freedom which are not deflected with automatic differentiation.
+ *
+ * The power injection problem with Darcy's law is simulated using time steps of fixed
+ * size with automatic differentiation, with plain finite differences and with
+ * compressed finite differences, the latter once with the source terms being
+ * recalculated and once with them being reused. The solutions at the end of the
+ * simulations must agree within a tolerance.
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/immiscible/immisciblemodel.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+#include "problems/powerinjectionproblem.hh"
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct PowerInjectionAd
+{ using InheritsFrom = std::tuple<PowerInjectionBaseProblem, ImmiscibleTwoPhaseModel>; };
+struct PowerInjectionFd { using InheritsFrom = std::tuple<PowerInjectionAd>; };
+struct PowerInjectionCompressedFd { using InheritsFrom = std::tuple<PowerInjectionFd>; };
+struct PowerInjectionCompressedFdLocalSources { using InheritsFrom = std::tuple<PowerInjectionCompressedFd>; };
+} // end namespace TTag
+
+template<class TypeTag>
+struct FluxModule<TypeTag, TTag::PowerInjectionAd> { using type = Opm::DarcyFluxModule<TypeTag>; };
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::PowerInjectionAd> { using type = TTag::AutoDiffLocalLinearizer; };
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::PowerInjectionFd> { using type = TTag::FiniteDifferenceLocalLinearizer; };
+
+template<class TypeTag>
+struct EnableCompressedFiniteDifferences<TypeTag, TTag::PowerInjectionCompressedFd> { static constexpr bool value = true; };
+
+template<class TypeTag>
+struct LocalSourceTerms<TypeTag, TTag::PowerInjectionCompressedFdLocalSources> { static constexpr bool value = true; };
+
+// use time steps of fixed size, so that all simulations compute the same time steps
+template<class TypeTag>
+struct EndTime<TypeTag, TTag::PowerInjectionAd>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 10;
+};
+
+template<class TypeTag>
+struct InitialTimeStepSize<TypeTag, TTag::PowerInjectionAd>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.5;
+};
+
+template<class TypeTag>
+struct MaxTimeStepSize<TypeTag, TTag::PowerInjectionAd>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 0.5;
+};
+
+template<class TypeTag>
+struct EnableVtkOutput<TypeTag, TTag::PowerInjectionAd> { static constexpr bool value = false; };
+
+} // namespace Opm::Properties
+
+// the primary variables of all degrees of freedom at the end of a simulation
+template <class TypeTag>
+std::vector<double> runSimulation(int argc, char **argv)
+{
+    using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+    using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+
+    // all simulations share the registry of the parameters
+    EWOMS_RESET_PARAMS_(TypeTag);
+    int paramStatus = Opm::setupParameters_<TypeTag>(argc,
+                                                     const_cast<const char**>(argv),
+                                                     /*registerParams=*/true,
+                                                     /*allowUnused=*/false,
+                                                     /*handleHelp=*/false);
+    if (paramStatus != 0)
+        throw std::runtime_error("Invalid parameters");
+
+    ThreadManager::init();
+
+    Simulator simulator(/*verbose=*/false);
+    simulator.run();
+
+    std::vector<double> result;
+    for (const auto& priVars : simulator.model().solution(/*timeIdx=*/0))
+        for (unsigned pvIdx = 0; pvIdx < priVars.size(); ++pvIdx)
+            result.push_back(priVars[pvIdx]);
+
+    return result;
+}
+
+bool compareSolutions(const std::vector<double>& reference,
+                      const std::vector<double>& solution,
+                      const std::string& name,
+                      double tolerance)
+{
+    if (reference.size() != solution.size()) {
+        std::cerr << name << ": The number of primary variables differs\n";
+        return false;
+    }
+
+    // pressures are compared relative to their magnitude, saturations absolutely
+    double maxError = 0.0;
+    for (unsigned i = 0; i < reference.size(); ++i)
+        maxError = std::max(maxError,
+                            std::abs(solution[i] - reference[i])
+                            / std::max(std::abs(reference[i]), 1.0));
+
+    std::cout << name << ": max. relative deviation from automatic differentiation: "
+              << maxError << "\n";
+
+    if (maxError > tolerance) {
+        std::cerr << name << ": The deviation exceeds " << tolerance << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    using namespace Opm::Properties::TTag;
+
+    Dune::MPIHelper::instance(argc, argv);
+
+    try {
+        const auto adSolution = runSimulation<PowerInjectionAd>(argc, argv);
+
+        const double tolerance = 1e-5;
+        bool success = true;
+        success = compareSolutions(adSolution,
+                                   runSimulation<PowerInjectionFd>(argc, argv),
+                                   "finite differences",
+                                   tolerance) && success;
+        success = compareSolutions(adSolution,
+                                   runSimulation<PowerInjectionCompressedFd>(argc, argv),
+                                   "compressed finite differences",
+                                   tolerance) && success;
+        success = compareSolutions(adSolution,
+                                   runSimulation<PowerInjectionCompressedFdLocalSources>(argc, argv),
+                                   "compressed finite differences, local sources",
+                                   tolerance) && success;
+
+        return success ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Simulation failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,228 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Compares the CPR preconditioner with ILU(0) for the linearized equations of a
+ *        two-phase flow problem on grids of increasing size.
+ *
+ * The Jacobian is the one of an immiscible, slightly compressible two-phase system with
+ * pressure and saturation as primary variables, heterogeneous transmissibilities and
+ * upstream weighting of the mobilities. For each grid size, the number of BiCGStab
+ * iterations and the time to solve the system are printed for both preconditioners.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/cprpreconditioner.hh>
+#include <opm/simulators/linalg/matrixblock.hh>
+#include <opm/models/utils/timer.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Scalar = double;
+static constexpr int numEq = 2;
+static constexpr int pressureIdx = 0;
+static constexpr int saturationIdx = 1;
+
+using MatrixBlock = Opm::MatrixBlock<Scalar, numEq, numEq>;
+using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+using Vector = Dune::BlockVector<Dune::FieldVector<Scalar, numEq> >;
+using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+
+// assemble the Jacobian of the wetting and the non-wetting phase mass balances on a
+// structured n x n grid. the pressure decreases from the left to the right boundary,
+// where it is fixed.
+Matrix createMatrix(unsigned n)
+{
+    const unsigned numCells = n*n;
+    Matrix matrix(numCells, numCells, 5*numCells, Matrix::row_wise);
+    for (auto rowIt = matrix.createbegin(); rowIt != matrix.createend(); ++rowIt) {
+        const unsigned i = rowIt.index() % n;
+        const unsigned j = rowIt.index() / n;
+        if (j > 0)
+            rowIt.insert(rowIt.index() - n);
+        if (i > 0)
+            rowIt.insert(rowIt.index() - 1);
+        rowIt.insert(rowIt.index());
+        if (i < n - 1)
+            rowIt.insert(rowIt.index() + 1);
+        if (j < n - 1)
+            rowIt.insert(rowIt.index() + n);
+    }
+    matrix = 0.0;
+
+    std::vector<Scalar> pressure(numCells);
+    std::vector<Scalar> saturation(numCells);
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        const unsigned i = cellIdx % n;
+        const unsigned j = cellIdx / n;
+        pressure[cellIdx] = 1.0 - (i + 0.5)/n;
+        saturation[cellIdx] = 0.5 + 0.4*std::sin(0.37*i + 0.21*j);
+    }
+
+    // the mobilities of the phases and their derivatives w.r.t. the saturation
+    const auto mobility = [](unsigned phaseIdx, Scalar S)
+    { return phaseIdx == 0 ? S*S : (1.0 - S)*(1.0 - S); };
+    const auto dMobility = [](unsigned phaseIdx, Scalar S)
+    { return phaseIdx == 0 ? 2*S : -2*(1.0 - S); };
+
+    // accumulation term: pore volume over time step size and total compressibility
+    const Scalar poreVolumeByDt = 1e-2;
+    const Scalar compressibility = 1e-3;
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        auto& diag = matrix[cellIdx][cellIdx];
+        const Scalar S = saturation[cellIdx];
+        diag[0][pressureIdx] += compressibility*poreVolumeByDt*S;
+        diag[0][saturationIdx] += poreVolumeByDt;
+        diag[1][pressureIdx] += compressibility*poreVolumeByDt*(1.0 - S);
+        diag[1][saturationIdx] -= poreVolumeByDt;
+    }
+
+    // fluxes over the faces between cells, which are weighted upstream
+    const auto addFlux = [&](unsigned cellIdx, unsigned neighborIdx, Scalar trans) {
+        const Scalar dp = pressure[cellIdx] - pressure[neighborIdx];
+        const unsigned upIdx = dp >= 0.0 ? cellIdx : neighborIdx;
+        for (unsigned phaseIdx = 0; phaseIdx < numEq; ++phaseIdx) {
+            const Scalar lambda = mobility(phaseIdx, saturation[upIdx]);
+            const Scalar dLambda = dMobility(phaseIdx, saturation[upIdx]);
+
+            matrix[cellIdx][cellIdx][phaseIdx][pressureIdx] += trans*lambda;
+            matrix[cellIdx][neighborIdx][phaseIdx][pressureIdx] -= trans*lambda;
+            matrix[cellIdx][upIdx][phaseIdx][saturationIdx] += trans*dLambda*dp;
+
+            matrix[neighborIdx][neighborIdx][phaseIdx][pressureIdx] += trans*lambda;
+            matrix[neighborIdx][cellIdx][phaseIdx][pressureIdx] -= trans*lambda;
+            matrix[neighborIdx][upIdx][phaseIdx][saturationIdx] -= trans*dLambda*dp;
+        }
+    };
+
+    for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+        const unsigned i = cellIdx % n;
+        const unsigned j = cellIdx / n;
+
+        // the permeability varies by about two orders of magnitude
+        const Scalar trans = std::exp(2.0*std::sin(0.5*i)*std::cos(0.3*j));
+        if (i < n - 1)
+            addFlux(cellIdx, cellIdx + 1, trans);
+        if (j < n - 1)
+            addFlux(cellIdx, cellIdx + n, trans);
+
+        // fixed pressure at the left and the right boundaries
+        if (i == 0 || i == n - 1)
+            for (unsigned phaseIdx = 0; phaseIdx < numEq; ++phaseIdx)
+                matrix[cellIdx][cellIdx][phaseIdx][pressureIdx] +=
+                    2*trans*mobility(phaseIdx, saturation[cellIdx]);
+    }
+
+    return matrix;
+}
+
+// solve the system using BiCGStab and a given preconditioner. returns whether the
+// solver converged.
+template <class Preconditioner>
+bool solve(const Matrix& matrix,
+           const Vector& b,
+           Preconditioner& preconditioner,
+           int& iterations)
+{
+    Operator op(matrix);
+    Dune::BiCGSTABSolver<Vector> solver(op,
+                                        preconditioner,
+                                        /*reduction=*/1e-8,
+                                        /*maxIterations=*/2000,
+                                        /*verbose=*/0);
+
+    Vector x(b.size());
+    x = 0.0;
+    Vector rhs(b);
+    Dune::InverseOperatorResult result;
+    solver.apply(x, rhs, result);
+    iterations = result.iterations;
+    return result.converged;
+}
+
+int main()
+{
+    bool success = true;
+
+    std::cout << std::setw(10) << "cells"
+              << std::setw(12) << "ILU(0) its"
+              << std::setw(14) << "ILU(0) time"
+              << std::setw(12) << "CPR its"
+              << std::setw(14) << "CPR time" << "\n";
+
+    for (unsigned n : { 16, 32, 64, 128 }) {
+        const Matrix matrix = createMatrix(n);
+
+        // use a right hand side for a smooth solution
+        Vector xRef(matrix.N());
+        for (unsigned i = 0; i < xRef.size(); ++i) {
+            xRef[i][pressureIdx] = std::cos(0.01*i);
+            xRef[i][saturationIdx] = 0.1*std::sin(0.02*i);
+        }
+        Vector b(matrix.N());
+        matrix.mv(xRef, b);
+
+        Opm::Timer iluTimer;
+        iluTimer.start();
+        Dune::SeqILU<Matrix, Vector, Vector> ilu(matrix, /*relaxationFactor=*/1.0);
+        int iluIterations = 0;
+        bool iluConverged = solve(matrix, b, ilu, iluIterations);
+        iluTimer.stop();
+
+        Opm::Timer cprTimer;
+        cprTimer.start();
+        Opm::Linear::CprPreconditioner<Matrix, Vector> cpr(matrix,
+                                                           pressureIdx,
+                                                           /*coarsenTarget=*/100,
+                                                           /*dimension=*/2,
+                                                           /*relaxationFactor=*/1.0);
+        int cprIterations = 0;
+        bool cprConverged = solve(matrix, b, cpr, cprIterations);
+        cprTimer.stop();
+
+        std::cout << std::setw(10) << n*n
+                  << std::setw(12) << (iluConverged ? std::to_string(iluIterations) : "-")
+                  << std::setw(14) << iluTimer.realTimeElapsed()
+                  << std::setw(12) << (cprConverged ? std::to_string(cprIterations) : "-")
+                  << std::setw(14) << cprTimer.realTimeElapsed() << "\n";
+
+        if (!cprConverged) {
+            std::cerr << "BiCGStab did not converge with the CPR preconditioner for "
+                      << n*n << " cells\n";
+            success = false;
+        }
+    }
+
+    return success ? 0 : 1;
+}
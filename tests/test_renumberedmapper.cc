@@ -0,0 +1,257 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Tests the renumbering of the elements and vertices of a structured grid.
+ *
+ * The numbering of the grid's mapper is shuffled first. Then, it is made sure that the
+ * reverse Cuthill-McKee and the space filling curve orderings are bijections and that
+ * the reverse Cuthill-McKee ordering reduces the bandwidth of the connectivity graph.
+ * Finally, the VTK output of fields which are indexed by the renumbered mappers is
+ * compared with the one of the same fields indexed by the grid's mappers.
+ */
+#include "config.h"
+
+#include <opm/models/discretization/common/renumberedmapper.hh>
+#include <opm/models/io/vtkmultiwriter.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/version.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/common/rangegenerators.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+#include <dune/grid/yaspgrid.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Grid = Dune::YaspGrid<2>;
+using GridView = Grid::LeafGridView;
+using GridMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+
+// the mapper of the grid with the indices shuffled randomly. this emulates grids which
+// number their entities in an order that is unrelated to their position.
+class ShuffledMapper
+{
+public:
+    using Index = GridMapper::Index;
+
+    ShuffledMapper(const GridView& gridView, const Dune::MCMGLayout& layout)
+        : gridMapper_(gridView, layout)
+    { shuffle_(); }
+
+    template <class EntityType>
+    Index index(const EntityType& e) const
+    { return shuffled_[gridMapper_.index(e)]; }
+
+    template <class Element>
+    Index subIndex(const Element& e, int i, unsigned int codim) const
+    { return shuffled_[gridMapper_.subIndex(e, i, codim)]; }
+
+    auto size() const
+    { return gridMapper_.size(); }
+
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2, 8)
+    void update(const GridView& gridView)
+    {
+        gridMapper_.update(gridView);
+        shuffle_();
+    }
+#else
+    void update()
+    {
+        gridMapper_.update();
+        shuffle_();
+    }
+#endif
+
+private:
+    void shuffle_()
+    {
+        shuffled_.resize(gridMapper_.size());
+        std::iota(shuffled_.begin(), shuffled_.end(), Index(0));
+        std::mt19937 randomGenerator(/*seed=*/42);
+        std::shuffle(shuffled_.begin(), shuffled_.end(), randomGenerator);
+    }
+
+    GridMapper gridMapper_;
+    std::vector<Index> shuffled_;
+};
+
+// make sure that the mapper assigns each entity of a given codimension a unique index
+template <int codim, class Mapper>
+bool checkBijection(const GridView& gridView, const Mapper& mapper, const std::string& name)
+{
+    const std::size_t numEntities = gridView.size(codim);
+    if (mapper.size() != numEntities || mapper.permutation().size() != numEntities) {
+        std::cerr << name << ": The mapper has " << mapper.size() << " entries, expected "
+                  << numEntities << "\n";
+        return false;
+    }
+
+    std::vector<bool> permutationHit(numEntities, false);
+    for (auto newIdx : mapper.permutation()) {
+        if (newIdx >= numEntities || permutationHit[newIdx]) {
+            std::cerr << name << ": The permutation is not a bijection\n";
+            return false;
+        }
+        permutationHit[newIdx] = true;
+    }
+
+    std::vector<bool> indexHit(numEntities, false);
+    for (const auto& entity : entities(gridView, Dune::Codim<codim>{})) {
+        auto idx = mapper.index(entity);
+        if (idx >= numEntities || indexHit[idx]) {
+            std::cerr << name << ": The index " << idx << " is invalid or used twice\n";
+            return false;
+        }
+        indexHit[idx] = true;
+    }
+
+    return true;
+}
+
+template <int codim, Opm::DofOrdering ordering>
+bool checkOrdering(const GridView& gridView, const std::string& name)
+{
+    using Mapper = Opm::RenumberedMapper<GridView, ordering, ShuffledMapper>;
+    const Mapper mapper(gridView, codim == 0 ? Dune::mcmgElementLayout() : Dune::mcmgVertexLayout());
+
+    if (!checkBijection<codim>(gridView, mapper, name))
+        return false;
+
+    std::cout << name << ": bandwidth " << mapper.naturalBandwidth()
+              << " (shuffled) -> " << mapper.bandwidth() << "\n";
+
+    if (ordering == Opm::DofOrdering::ReverseCuthillMcKee
+        && mapper.bandwidth() >= mapper.naturalBandwidth())
+    {
+        std::cerr << name << ": The bandwidth was not reduced\n";
+        return false;
+    }
+
+    return true;
+}
+
+// write a scalar field for the elements and the vertices to a VTK file and return its
+// contents. the fields are indexed by the given mappers.
+template <class ElementMapper, class VertexMapper>
+std::string writeVtk(const GridView& gridView,
+                     const ElementMapper& elementMapper,
+                     const VertexMapper& vertexMapper,
+                     const std::vector<GridMapper::Index>* elementPermutation,
+                     const std::vector<GridMapper::Index>* vertexPermutation,
+                     const std::string& simName)
+{
+    using VtkMultiWriter = Opm::VtkMultiWriter<GridView, Dune::VTK::ascii>;
+    {
+        VtkMultiWriter writer(/*asyncWriting=*/false, gridView, /*outputDir=*/".", simName);
+        writer.setPermutations(elementPermutation, vertexPermutation);
+        writer.beginWrite(/*t=*/0.0);
+
+        auto* elementData = writer.allocateManagedScalarBuffer(gridView.size(/*codim=*/0));
+        for (const auto& elem : elements(gridView)) {
+            const auto& pos = elem.geometry().center();
+            (*elementData)[elementMapper.index(elem)] = std::sin(pos[0])*std::cos(2.0*pos[1]);
+        }
+        writer.attachScalarElementData(*elementData, "elementData");
+
+        auto* vertexData = writer.allocateManagedScalarBuffer(gridView.size(/*codim=*/2));
+        for (const auto& vertex : vertices(gridView)) {
+            const auto& pos = vertex.geometry().center();
+            (*vertexData)[vertexMapper.index(vertex)] = pos[0]*pos[0] - 3.0*pos[1];
+        }
+        writer.attachScalarVertexData(*vertexData, "vertexData");
+
+        writer.endWrite();
+    }
+
+    std::ifstream file(simName + "-00001.vtu");
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+template <Opm::DofOrdering ordering>
+bool checkVtkOutput(const GridView& gridView,
+                    const std::string& naturalOutput,
+                    const std::string& name)
+{
+    using Mapper = Opm::RenumberedMapper<GridView, ordering>;
+    const Mapper elementMapper(gridView, Dune::mcmgElementLayout());
+    const Mapper vertexMapper(gridView, Dune::mcmgVertexLayout());
+
+    const std::string output = writeVtk(gridView,
+                                        elementMapper,
+                                        vertexMapper,
+                                        Opm::mapperPermutation(elementMapper),
+                                        Opm::mapperPermutation(vertexMapper),
+                                        "renumberedmapper-" + name);
+    if (output.empty() || output != naturalOutput) {
+        std::cerr << name << ": The VTK output differs from the one of the grid's mappers\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    const Grid grid(/*upperRight=*/Dune::FieldVector<double, 2>{6.0, 4.0},
+                    /*cells=*/std::array<int, 2>{24, 16});
+    const GridView gridView = grid.leafGridView();
+
+    bool success = true;
+    success = checkOrdering<0, Opm::DofOrdering::ReverseCuthillMcKee>(gridView, "RCM elements") && success;
+    success = checkOrdering<0, Opm::DofOrdering::Hilbert>(gridView, "Hilbert elements") && success;
+    success = checkOrdering<0, Opm::DofOrdering::Morton>(gridView, "Morton elements") && success;
+    success = checkOrdering<2, Opm::DofOrdering::ReverseCuthillMcKee>(gridView, "RCM vertices") && success;
+    success = checkOrdering<2, Opm::DofOrdering::Hilbert>(gridView, "Hilbert vertices") && success;
+    success = checkOrdering<2, Opm::DofOrdering::Morton>(gridView, "Morton vertices") && success;
+
+    const GridMapper elementMapper(gridView, Dune::mcmgElementLayout());
+    const GridMapper vertexMapper(gridView, Dune::mcmgVertexLayout());
+    const std::string naturalOutput = writeVtk(gridView,
+                                               elementMapper,
+                                               vertexMapper,
+                                               /*elementPermutation=*/nullptr,
+                                               /*vertexPermutation=*/nullptr,
+                                               "renumberedmapper-natural");
+    success = checkVtkOutput<Opm::DofOrdering::ReverseCuthillMcKee>(gridView, naturalOutput, "rcm") && success;
+    success = checkVtkOutput<Opm::DofOrdering::Hilbert>(gridView, naturalOutput, "hilbert") && success;
+    success = checkVtkOutput<Opm::DofOrdering::Morton>(gridView, naturalOutput, "morton") && success;
+
+    return success ? 0 : 1;
+}
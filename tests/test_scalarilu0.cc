@@ -0,0 +1,113 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Makes sure that the scalar ILU(0) preconditioner yields the same results as
+ *        the generic block ILU(0) of dune-istl for a single equation.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/scalarilu0preconditioner.hh>
+#include <opm/simulators/linalg/matrixblock.hh>
+#include <opm/simulators/linalg/ilufirstelement.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using Scalar = double;
+using MatrixBlock = Opm::MatrixBlock<Scalar, 1, 1>;
+using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+using Vector = Dune::BlockVector<Dune::FieldVector<Scalar, 1> >;
+
+// assemble a non-symmetric matrix with the sparsity pattern of the five point stencil
+// on a structured two-dimensional grid
+Matrix createMatrix(unsigned nx, unsigned ny)
+{
+    const unsigned n = nx*ny;
+    Matrix matrix(n, n, 5*n, Matrix::row_wise);
+    for (auto rowIt = matrix.createbegin(); rowIt != matrix.createend(); ++rowIt) {
+        const unsigned i = rowIt.index() % nx;
+        const unsigned j = rowIt.index() / nx;
+        if (j > 0)
+            rowIt.insert(rowIt.index() - nx);
+        if (i > 0)
+            rowIt.insert(rowIt.index() - 1);
+        rowIt.insert(rowIt.index());
+        if (i < nx - 1)
+            rowIt.insert(rowIt.index() + 1);
+        if (j < ny - 1)
+            rowIt.insert(rowIt.index() + nx);
+    }
+
+    for (auto rowIt = matrix.begin(); rowIt != matrix.end(); ++rowIt) {
+        for (auto colIt = rowIt->begin(); colIt != rowIt->end(); ++colIt) {
+            if (colIt.index() == rowIt.index())
+                (*colIt) = 4.5;
+            else if (colIt.index() < rowIt.index())
+                (*colIt) = -1.25;
+            else
+                (*colIt) = -0.75 - 0.01*(rowIt.index() % 7);
+        }
+    }
+
+    return matrix;
+}
+
+int main()
+{
+    const Matrix matrix = createMatrix(13, 11);
+
+    Vector d(matrix.N());
+    for (unsigned i = 0; i < d.size(); ++i)
+        d[i] = std::sin(0.3*i) + 1.0;
+
+    for (Scalar relaxationFactor : { 1.0, 0.9 }) {
+        Dune::SeqILU<Matrix, Vector, Vector> blockIlu(matrix, relaxationFactor);
+        Opm::Linear::ScalarIlu0Preconditioner<Matrix, Vector> scalarIlu(matrix, relaxationFactor);
+
+        Vector vBlock(matrix.N());
+        Vector vScalar(matrix.N());
+        vBlock = 0.0;
+        vScalar = 0.0;
+        Vector dBlock(d);
+        blockIlu.apply(vBlock, dBlock);
+        scalarIlu.apply(vScalar, d);
+
+        for (unsigned i = 0; i < d.size(); ++i) {
+            const Scalar diff = std::abs(vBlock[i][0] - vScalar[i][0]);
+            if (diff > 1e-12*std::max(1.0, std::abs(vBlock[i][0]))) {
+                std::cerr << "The scalar ILU(0) differs from the block ILU(0) at index " << i
+                          << ": " << vScalar[i][0] << " vs. " << vBlock[i][0] << "\n";
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Compares the sequential solution strategy of the black-oil model with the
+ *        fully implicit one.
+ *
+ * The reservoir problem is simulated with the element centered finite volume
+ * discretization using the fully implicit strategy and the sequential one, the latter
+ * once with its iterations being repeated until the fully implicit system has converged
+ * and once with a single iteration per time step. The time steps are the same for all
+ * simulations. The run time and the iterations of each simulation are printed. The
+ * solution of the iterated sequential strategy must agree with the fully implicit one
+ * within a tolerance.
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/utils/timer.hh>
+#include <opm/models/blackoil/blackoilmodel.hh>
+#include <opm/models/discretization/ecfv/ecfvdiscretization.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+#include "problems/reservoirproblem.hh"
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct ReservoirFullyImplicit { using InheritsFrom = std::tuple<ReservoirBaseProblem, BlackOilModel>; };
+struct ReservoirSequential { using InheritsFrom = std::tuple<ReservoirFullyImplicit>; };
+struct ReservoirSequentialSingleIteration { using InheritsFrom = std::tuple<ReservoirSequential>; };
+} // end namespace TTag
+
+template<class TypeTag>
+struct SpatialDiscretizationSplice<TypeTag, TTag::ReservoirFullyImplicit> { using type = TTag::EcfvDiscretization; };
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::ReservoirFullyImplicit> { using type = TTag::AutoDiffLocalLinearizer; };
+
+template<class TypeTag>
+struct NewtonSolutionStrategy<TypeTag, TTag::ReservoirSequential> { static constexpr auto value = "sequential"; };
+
+template<class TypeTag>
+struct SequentialIterateToFullyImplicit<TypeTag, TTag::ReservoirSequentialSingleIteration> { static constexpr bool value = false; };
+
+// simulate the "settle down" episode and the beginning of the production
+template<class TypeTag>
+struct EndTime<TypeTag, TTag::ReservoirFullyImplicit>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 8750000;
+};
+
+// the time step size grows independently of the number of Newton iterations until it
+// reaches its maximum, so that all simulations compute the same time steps
+template<class TypeTag>
+struct NewtonTargetIterations<TypeTag, TTag::ReservoirFullyImplicit> { static constexpr int value = 1000000; };
+
+template<class TypeTag>
+struct MaxTimeStepSize<TypeTag, TTag::ReservoirFullyImplicit>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 100e3;
+};
+
+template<class TypeTag>
+struct EnableVtkOutput<TypeTag, TTag::ReservoirFullyImplicit> { static constexpr bool value = false; };
+
+} // namespace Opm::Properties
+
+struct SimulationResult
+{
+    // the primary variables of all degrees of freedom at the end of the simulation
+    std::vector<double> solution;
+
+    double runTime{0.0};
+    int numTimeSteps{0};
+    std::size_t numNewtonIterations{0};
+    std::size_t numPressureIterations{0};
+    std::size_t numTransportIterations{0};
+};
+
+template <class TypeTag>
+SimulationResult runSimulation(int argc, char **argv)
+{
+    using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+    using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+
+    // all simulations share the registry of the parameters
+    EWOMS_RESET_PARAMS_(TypeTag);
+    int paramStatus = Opm::setupParameters_<TypeTag>(argc,
+                                                     const_cast<const char**>(argv),
+                                                     /*registerParams=*/true,
+                                                     /*allowUnused=*/false,
+                                                     /*handleHelp=*/false);
+    if (paramStatus != 0)
+        throw std::runtime_error("Invalid parameters");
+
+    ThreadManager::init();
+
+    Simulator simulator(/*verbose=*/false);
+    Opm::Timer timer;
+    timer.start();
+    simulator.run();
+    timer.stop();
+
+    SimulationResult result;
+    for (const auto& priVars : simulator.model().solution(/*timeIdx=*/0))
+        for (unsigned pvIdx = 0; pvIdx < priVars.size(); ++pvIdx)
+            result.solution.push_back(priVars[pvIdx]);
+
+    const auto& newtonMethod = simulator.model().newtonMethod();
+    result.runTime = timer.realTimeElapsed();
+    result.numTimeSteps = simulator.timeStepIndex();
+    result.numNewtonIterations = newtonMethod.numTotalIterations();
+    result.numPressureIterations = newtonMethod.numPressureIterations();
+    result.numTransportIterations = newtonMethod.numTransportIterations();
+
+    return result;
+}
+
+void printResult(const SimulationResult& result, const std::string& name)
+{
+    std::cout << std::setw(24) << name
+              << std::setw(12) << result.runTime
+              << std::setw(12) << result.numTimeSteps
+              << std::setw(12) << result.numNewtonIterations
+              << std::setw(12) << result.numPressureIterations
+              << std::setw(12) << result.numTransportIterations << "\n";
+}
+
+// pressures are compared relative to their magnitude, saturations absolutely
+double maxDeviation(const std::vector<double>& reference, const std::vector<double>& solution)
+{
+    if (reference.size() != solution.size())
+        throw std::runtime_error("The number of primary variables differs");
+
+    double result = 0.0;
+    for (unsigned i = 0; i < reference.size(); ++i)
+        result = std::max(result,
+                          std::abs(solution[i] - reference[i])
+                          / std::max(std::abs(reference[i]), 1.0));
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    using namespace Opm::Properties::TTag;
+
+    Dune::MPIHelper::instance(argc, argv);
+
+    try {
+        const auto fullyImplicit = runSimulation<ReservoirFullyImplicit>(argc, argv);
+        const auto sequential = runSimulation<ReservoirSequential>(argc, argv);
+        const auto singleIteration = runSimulation<ReservoirSequentialSingleIteration>(argc, argv);
+
+        std::cout << std::setw(24) << "strategy"
+                  << std::setw(12) << "time [s]"
+                  << std::setw(12) << "steps"
+                  << std::setw(12) << "Newton"
+                  << std::setw(12) << "pressure"
+                  << std::setw(12) << "transport" << "\n";
+        printResult(fullyImplicit, "fully implicit");
+        printResult(sequential, "sequential");
+        printResult(singleIteration, "sequential, 1 iteration");
+
+        const double sequentialDeviation = maxDeviation(fullyImplicit.solution, sequential.solution);
+        std::cout << "max. relative deviation from the fully implicit solution: "
+                  << sequentialDeviation << " (sequential), "
+                  << maxDeviation(fullyImplicit.solution, singleIteration.solution)
+                  << " (sequential, 1 iteration)\n";
+
+        // both strategies stop once the residual of the fully implicit system falls
+        // below the tolerance of the Newton method
+        const double tolerance = 1e-3;
+        if (sequentialDeviation > tolerance) {
+            std::cerr << "The deviation of the sequential strategy exceeds " << tolerance << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Simulation failed: " << e.what() << "\n";
+        return 1;
+    }
+}
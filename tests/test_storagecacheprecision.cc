@@ -0,0 +1,221 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Bounds the error which is caused by storing the cached storage terms of the
+ *        previous time level in single precision.
+ *
+ * The lens problem of the immiscible model and the reservoir problem of the black-oil
+ * model are simulated for a few time steps of fixed size, once with the storage cache
+ * in double and once in float precision. The total amounts of the conserved quantities
+ * at the end of both simulations must agree within a tolerance and the storage cache in
+ * float precision must occupy less memory than the one in double precision.
+ */
+#include "config.h"
+
+#include "lens_immiscible_ecfv_ad.hh"
+#include "problems/reservoirproblem.hh"
+
+#include <opm/models/blackoil/blackoilmodel.hh>
+#include <opm/models/discretization/ecfv/ecfvdiscretization.hh>
+#include <opm/models/utils/memoryusage.hh>
+#include <opm/models/utils/start.hh>
+#include <opm/simulators/linalg/parallelbicgstabbackend.hh>
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct LensStorageCacheDouble { using InheritsFrom = std::tuple<LensProblemEcfvAd>; };
+struct LensStorageCacheFloat { using InheritsFrom = std::tuple<LensStorageCacheDouble>; };
+struct ReservoirStorageCacheDouble { using InheritsFrom = std::tuple<ReservoirBaseProblem, BlackOilModel>; };
+struct ReservoirStorageCacheFloat { using InheritsFrom = std::tuple<ReservoirStorageCacheDouble>; };
+} // end namespace TTag
+
+template<class TypeTag>
+struct SpatialDiscretizationSplice<TypeTag, TTag::ReservoirStorageCacheDouble> { using type = TTag::EcfvDiscretization; };
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::ReservoirStorageCacheDouble> { using type = TTag::AutoDiffLocalLinearizer; };
+
+// the storage cache is disabled by default. the lens problem enables it, the reservoir
+// problem does not.
+template<class TypeTag>
+struct EnableStorageCache<TypeTag, TTag::LensStorageCacheDouble> { static constexpr bool value = true; };
+
+template<class TypeTag>
+struct EnableStorageCache<TypeTag, TTag::ReservoirStorageCacheDouble> { static constexpr bool value = true; };
+
+// use time steps of fixed size, so that both simulations of a problem compute the same
+// time steps
+template<class TypeTag>
+struct EndTime<TypeTag, TTag::LensStorageCacheDouble>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 3000;
+};
+
+template<class TypeTag>
+struct MaxTimeStepSize<TypeTag, TTag::LensStorageCacheDouble>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 250;
+};
+
+template<class TypeTag>
+struct EndTime<TypeTag, TTag::ReservoirStorageCacheDouble>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 1e6;
+};
+
+template<class TypeTag>
+struct MaxTimeStepSize<TypeTag, TTag::ReservoirStorageCacheDouble>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 100e3;
+};
+
+template<class TypeTag>
+struct EnableVtkOutput<TypeTag, TTag::LensStorageCacheDouble> { static constexpr bool value = false; };
+
+template<class TypeTag>
+struct EnableVtkOutput<TypeTag, TTag::ReservoirStorageCacheDouble> { static constexpr bool value = false; };
+
+template<class TypeTag>
+struct StorageCacheScalar<TypeTag, TTag::LensStorageCacheFloat> { using type = float; };
+
+template<class TypeTag>
+struct StorageCacheScalar<TypeTag, TTag::ReservoirStorageCacheFloat> { using type = float; };
+
+} // namespace Opm::Properties
+
+// the total amounts of the conserved quantities at the end of a simulation and the
+// memory occupied by the storage cache
+struct SimulationResult
+{
+    std::vector<double> totalStorage;
+    std::size_t storageCacheBytes{0};
+};
+
+template <class TypeTag>
+SimulationResult runSimulation(int argc, char **argv)
+{
+    using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+    using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+    using EqVector = Opm::GetPropType<TypeTag, Opm::Properties::EqVector>;
+
+    // all simulations share the registry of the parameters
+    EWOMS_RESET_PARAMS_(TypeTag);
+    int paramStatus = Opm::setupParameters_<TypeTag>(argc,
+                                                     const_cast<const char**>(argv),
+                                                     /*registerParams=*/true,
+                                                     /*allowUnused=*/false,
+                                                     /*handleHelp=*/false);
+    if (paramStatus != 0)
+        throw std::runtime_error("Invalid parameters");
+
+    ThreadManager::init();
+
+    Simulator simulator(/*verbose=*/false);
+    simulator.run();
+
+    SimulationResult result;
+    EqVector storage(0.0);
+    simulator.model().globalStorage(storage);
+    result.totalStorage.assign(storage.begin(), storage.end());
+
+    Opm::MemoryUsage usage;
+    simulator.model().addMemoryUsage(usage);
+    for (const auto& [name, bytes] : usage.entries())
+        if (name == "Storage cache")
+            result.storageCacheBytes = bytes;
+
+    return result;
+}
+
+template <class DoubleTypeTag, class FloatTypeTag>
+bool compareStoragePrecisions(int argc, char **argv, const std::string& name, double tolerance)
+{
+    const SimulationResult doubleResult = runSimulation<DoubleTypeTag>(argc, argv);
+    const SimulationResult floatResult = runSimulation<FloatTypeTag>(argc, argv);
+
+    bool success = true;
+    double maxRelError = 0.0;
+    for (unsigned eqIdx = 0; eqIdx < doubleResult.totalStorage.size(); ++eqIdx) {
+        const double ref = doubleResult.totalStorage[eqIdx];
+        const double error = std::abs(floatResult.totalStorage[eqIdx] - ref);
+        maxRelError = std::max(maxRelError, error/std::max(std::abs(ref), 1e-30));
+    }
+
+    std::cout << name << ": storage cache "
+              << Opm::MemoryUsage::humanReadableBytes(doubleResult.storageCacheBytes)
+              << " (double) -> "
+              << Opm::MemoryUsage::humanReadableBytes(floatResult.storageCacheBytes)
+              << " (float), max. relative error of the total storage: "
+              << maxRelError << "\n";
+
+    if (maxRelError > tolerance) {
+        std::cerr << name << ": The error caused by the float storage cache exceeds "
+                  << tolerance << "\n";
+        success = false;
+    }
+
+    if (floatResult.storageCacheBytes >= doubleResult.storageCacheBytes) {
+        std::cerr << name << ": The float storage cache is not smaller than the double one\n";
+        success = false;
+    }
+
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    try {
+        bool success = true;
+        success = compareStoragePrecisions<Opm::Properties::TTag::LensStorageCacheDouble,
+                                           Opm::Properties::TTag::LensStorageCacheFloat>
+            (argc, argv, "lens (immiscible)", /*tolerance=*/1e-4) && success;
+        success = compareStoragePrecisions<Opm::Properties::TTag::ReservoirStorageCacheDouble,
+                                           Opm::Properties::TTag::ReservoirStorageCacheFloat>
+            (argc, argv, "reservoir (black-oil)", /*tolerance=*/1e-4) && success;
+
+        return success ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Simulation failed: " << e.what() << "\n";
+        return 1;
+    }
+}